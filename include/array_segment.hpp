@@ -0,0 +1,49 @@
+#ifndef ARRAY_SEGMENT_GENERIC_PROGRAMMING
+#define ARRAY_SEGMENT_GENERIC_PROGRAMMING
+
+#include <cstddef>
+
+/// Array Segment
+/// A non-owning view of a contiguous run of elements: just a pointer and a count.
+/// The elements of a circular buffer live in at most two such runs inside the underlying array
+/// (from head to the end of the array and then from the beginning of the array to tail).
+/// Handing those runs out lets algorithms loop over plain arrays which the compiler can easily optimize
+/// instead of going through the wrap around check of operator[] for every single element.
+template<typename T>
+struct array_segment {
+    using value_type = T;
+    using pointer = T*;
+    using reference = T&;
+    using iterator = T*;
+    using size_type = std::size_t;
+
+    pointer   first;
+    size_type count;
+
+    pointer data() const
+    {
+        return first;
+    }
+    size_type size() const
+    {
+        return count;
+    }
+    bool empty() const
+    {
+        return count == 0;
+    }
+    iterator begin() const
+    {
+        return first;
+    }
+    iterator end() const
+    {
+        return first + count;
+    }
+    reference operator[](size_type i) const // [[expects: i < size()]]
+    {
+        return first[i];
+    }
+};
+
+#endif // !ARRAY_SEGMENT_GENERIC_PROGRAMMING
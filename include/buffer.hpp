@@ -1,7 +1,12 @@
 #ifndef BUFFER_GENERIC_PROGRAMMING
 #define BUFFER_GENERIC_PROGRAMMING
 
+#include <algorithm>
 #include <iostream>
+#include <functional>
+#include <type_traits>
+#include "buffer_kernels.hpp"
+#include "text_writer.hpp"
 
 /// Type aliases
 // This is an example of a type function implemented using a template type alias.
@@ -13,6 +18,20 @@
 template<typename C>
 using Value_type = typename C::value_type;
 
+// Type predicate telling if E is a lazy buffer expression (see "Expression templates" bellow).
+// It is declared here since buffer needs it to recognize expressions.
+template<typename E>
+struct is_buffer_expression : std::false_type {};
+
+/// Constructor tags
+// Empty types whose only job is to pick a constructor overload. This is a common technique (see std::in_place_t)
+// for giving a constructor a name: buffer<float, 16> b(uninitialized); reads much better than a bool argument.
+struct uninitialized_t {};
+constexpr uninitialized_t uninitialized {};
+
+struct value_init_t {};
+constexpr value_init_t value_init {};
+
 // We will improve out buffer class with each topic covered.
 
 // We have parametrized the buffer class both on the type and on the size. 
@@ -21,46 +40,62 @@ class buffer {
 public:
     // Associated type
     using value_type = T;
+    // The size as a compile time constant, so that expressions can check they combine buffers of the same size.
+    static constexpr int extent = N;
 
-    // Default constructor - Initialize all array elements to zero
+    // Default constructor - Value initialize all array elements (zero for arithmetic types, the default
+    // constructor for class types such as std::string).
     buffer()
-    {
-        for (int i = 0; i != N; ++i) {
-            buf[i] = 0;
-        }
-    }
+        : buf {}
+    {}
+
+    // The same, but explicitly asked for: buffer<int, 4> b(value_init);
+    explicit buffer(value_init_t)
+        : buf {}
+    {}
+
+    // Leaves the elements default initialized, which for arithmetic types means not initialized at all.
+    // For hot paths which are going to overwrite every element anyway: buffer<float, 16> b(uninitialized);
+    explicit buffer(uninitialized_t)
+    {}
 
     // Normal Constructor - initialize array elements to the integer passed
+    // The standard algorithm fill_n does the same as a loop, but it knows about the type:
+    // for simple types it becomes a memset (or a few SIMD stores) instead of an element by element loop.
     buffer(const T& a)
     {
-        for (int i = 0; i != N; ++i) {
-            buf[i] = a;
-        }
+        std::fill_n(buf, N, a);
     }
 
-    // Copy Constructor
-    buffer(const buffer& other)
+    // Copy and move constructors, copy and move assignment operators.
+    // We let the compiler generate all of them: they copy the array member by member, which is exactly what we want.
+    // As a bonus, when T is trivially copyable (int, float, color_rgba, ...) so is buffer<T, N>. Then the
+    // standard library (and the compiler) may copy buffers with memcpy and relocate them in bulk,
+    // for example when a std::vector<buffer<float, 16>> grows. A hand written copy constructor, even one doing
+    // the same thing, takes that away.
+    buffer(const buffer& other) = default;
+    buffer(buffer&& other) = default;
+    buffer& operator=(const buffer& other) = default;
+    buffer& operator=(buffer&& other) = default;
+
+    // Construction and assignment from a lazy expression. This is where the whole expression is evaluated,
+    // element by element, in a single loop.
+    template<typename E, typename = std::enable_if_t<is_buffer_expression<E>::value && E::extent == N>>
+    buffer(const E& e)
     {
         for (int i = 0; i != N; ++i) {
-            buf[i] = other.buf[i];
+            buf[i] = e[i];
         }
     }
-
-    // Move constructor
-    buffer(buffer&& other) = default; // Instructs the compiler to use the default move constructor
-
-    // Copy Assignment
-    buffer& operator=(const buffer& other)
+    template<typename E, typename = std::enable_if_t<is_buffer_expression<E>::value && E::extent == N>>
+    buffer& operator=(const E& e)
     {
         for (int i = 0; i != N; ++i) {
-            buf[i] = other.buf[i];
+            buf[i] = e[i];
         }
         return *this;
     }
 
-    // Move Assignment
-    buffer& operator=(buffer&& other) = default;
-
     // We  now just return the non-type template argument for the size.
     int size() const
     {
@@ -77,51 +112,242 @@ public:
     {
         return buf[n];
     }
+    // The elements are one plain array, algorithms (like the parallel ones) can work on it directly.
+    T* data()
+    {
+        return buf;
+    }
+    const T* data() const
+    {
+        return buf;
+    }
     
     //We will define "buffer addition" in terms of element wise addition.
+    // The loops themselves live in buffer_kernels (see buffer_kernels.hpp), which is specialized with SIMD
+    // versions for float, double and 32/16 bit integers.
     buffer& operator+=(const buffer& other)
     {
-        for (int i = 0; i != N; ++i) {
-            buf[i] += other[i];
-        }
+        buffer_kernels<T>::add(buf, other.buf, N);
         return *this;
     }
 
     buffer& operator-=(const buffer& other)
+    {
+        buffer_kernels<T>::sub(buf, other.buf, N);
+        return *this;
+    }
+
+    // Element wise multiplication.
+    buffer& operator*=(const buffer& other)
+    {
+        buffer_kernels<T>::mul(buf, other.buf, N);
+        return *this;
+    }
+
+    // Multiply-add: buf[i] += a[i] * b[i]. The bread and butter of filters and linear algebra.
+    buffer& fma(const buffer& a, const buffer& b)
+    {
+        buffer_kernels<T>::fma(buf, a.buf, b.buf, N);
+        return *this;
+    }
+
+    // b += e where e is an expression does not need a temporary either.
+    template<typename E, typename = std::enable_if_t<is_buffer_expression<E>::value && E::extent == N>>
+    buffer& operator+=(const E& e)
+    {
+        for (int i = 0; i != N; ++i) {
+            buf[i] += e[i];
+        }
+        return *this;
+    }
+    template<typename E, typename = std::enable_if_t<is_buffer_expression<E>::value && E::extent == N>>
+    buffer& operator-=(const E& e)
     {
         for (int i = 0; i != N; ++i) {
-            buf[i] -= other[i];
+            buf[i] -= e[i];
         }
         return *this;
     }
 
 private:
     // We just need to modify make all elements in the class to refer to T and to N.
-    T buf[N];
+    // The array is aligned so that SIMD loads never straddle two cache lines (see buffer_alignment).
+    alignas(buffer_alignment(sizeof(T) * N, alignof(T))) T buf[N];
 };
 
-// The inline keyword "kindly" asks the compiler to remove the function call overhead and just insert the function
-// body whenever the function is called. 
-// Note all functions defined inside the class body have the inline specifier by default so that is why 
-// we do not need to add inline there.
+/// Expression templates
+// If operator+ returned a buffer, then b1 + b2 - b3 + b4 would create three temporary buffers and loop
+// over the elements four times. Instead, the arithmetic operators return small objects that only remember
+// what has to be computed (an "expression"). Element i of an expression is computed on demand from element i of
+// its operands. Nothing is computed until the expression is assigned to a buffer, and then the whole expression
+// is evaluated in one loop without any temporaries:
+//     buffer<int, 4> r = b1 + b2 - b3 + b4;   // r[i] = ((b1[i] + b2[i]) - b3[i]) + b4[i]
+// Expressions hold references to the buffers they were built from, so do not keep an expression (auto e = b1 + b2;)
+// around longer than the buffers.
+
+// Buffers and expressions can both be used as operands.
+template<typename E>
+struct is_buffer_operand : is_buffer_expression<E> {};
+
 template<typename T, int N>
+struct is_buffer_operand<buffer<T, N>> : std::true_type {};
+
+// Type function for how an operand is stored inside an expression. Buffers are big, so we keep a reference to them.
+// Expressions are tiny (just references and function objects) and are usually temporaries, so we copy them.
+template<typename E>
+struct buffer_operand_storage {
+    using type = E;
+};
+
+template<typename T, int N>
+struct buffer_operand_storage<buffer<T, N>> {
+    using type = const buffer<T, N>&;
+};
+
+template<typename E>
+using Buffer_operand_storage = typename buffer_operand_storage<E>::type;
+
+// An element-wise function applied to one operand: element i is f(e[i]).
+template<typename E, typename F>
+class buffer_unary_expression {
+public:
+    using value_type = std::decay_t<decltype(std::declval<const F&>()(std::declval<const E&>()[0]))>;
+    static constexpr int extent = E::extent;
+
+    buffer_unary_expression(const E& e, F f)
+        : e_(e), f_(f)
+    {}
+
+    int size() const
+    {
+        return extent;
+    }
+    value_type operator[](int i) const
+    {
+        return f_(e_[i]);
+    }
+private:
+    Buffer_operand_storage<E> e_;
+    F f_;
+};
+
+// An element-wise function applied to two operands of the same size: element i is f(x[i], y[i]).
+template<typename L, typename R, typename F>
+class buffer_binary_expression {
+public:
+    static_assert(L::extent == R::extent, "buffer expressions can only combine buffers of the same size");
+    using value_type = std::decay_t<decltype(std::declval<const F&>()(std::declval<const L&>()[0],
+                                                                       std::declval<const R&>()[0]))>;
+    static constexpr int extent = L::extent;
+
+    buffer_binary_expression(const L& x, const R& y, F f)
+        : x_(x), y_(y), f_(f)
+    {}
+
+    int size() const
+    {
+        return extent;
+    }
+    value_type operator[](int i) const
+    {
+        return f_(x_[i], y_[i]);
+    }
+private:
+    Buffer_operand_storage<L> x_;
+    Buffer_operand_storage<R> y_;
+    F f_;
+};
+
+template<typename E, typename F>
+struct is_buffer_expression<buffer_unary_expression<E, F>> : std::true_type {};
+
+template<typename L, typename R, typename F>
+struct is_buffer_expression<buffer_binary_expression<L, R, F>> : std::true_type {};
+
+// Function objects for multiplying by a scalar. We keep the scalar on the side it was written on
+// since multiplication need not be commutative for every T.
+template<typename S>
+struct multiply_by_scalar {
+    S s;
+    template<typename T>
+    auto operator()(const T& x) const
+    {
+        return x * s;
+    }
+};
+
+template<typename S>
+struct scalar_multiply_by {
+    S s;
+    template<typename T>
+    auto operator()(const T& x) const
+    {
+        return s * x;
+    }
+};
+
+// The operators only take part in overload resolution when their arguments are buffers or expressions.
+// This is done through std::enable_if (an important technique called SFINAE which we will discuss later on).
+// The inline keyword "kindly" asks the compiler to remove the function call overhead and just insert the function
+// body whenever the function is called. Note all functions defined inside the class body have the inline specifier
+// by default so that is why we do not need to add inline there.
+template<typename L, typename R,
+         typename = std::enable_if_t<is_buffer_operand<L>::value && is_buffer_operand<R>::value>>
 inline
-buffer<T,N> operator+(const buffer<T,N>& x, const buffer<T,N>& y)
+buffer_binary_expression<L, R, std::plus<>> operator+(const L& x, const R& y)
 {
-    buffer<T,N> ret = x;
-    ret += y;
-    return ret;
+    return { x, y, std::plus<> {} };
 }
 
-// Note: Outside of the class definition, we must use redeclare the template parameters.
-// Also, all occurences of buffer must be to buffer<T, N> and  not to just buffer as in the class definition 
-template<typename T, int N>
+template<typename L, typename R,
+         typename = std::enable_if_t<is_buffer_operand<L>::value && is_buffer_operand<R>::value>>
 inline
-buffer<T, N> operator-(const buffer<T,N>& x, const buffer<T,N>& y)
+buffer_binary_expression<L, R, std::minus<>> operator-(const L& x, const R& y)
 {
-    buffer<T, N> ret = x;
-    ret -= y;
-    return ret;
+    return { x, y, std::minus<> {} };
+}
+
+// Element wise multiplication of two buffers.
+template<typename L, typename R,
+         typename = std::enable_if_t<is_buffer_operand<L>::value && is_buffer_operand<R>::value>>
+inline
+buffer_binary_expression<L, R, std::multiplies<>> operator*(const L& x, const R& y)
+{
+    return { x, y, std::multiplies<> {} };
+}
+
+template<typename E, typename S,
+         typename = std::enable_if_t<is_buffer_operand<E>::value && !is_buffer_operand<S>::value>>
+inline
+buffer_unary_expression<E, multiply_by_scalar<S>> operator*(const E& e, const S& s)
+{
+    return { e, multiply_by_scalar<S> { s } };
+}
+
+template<typename S, typename E,
+         typename = std::enable_if_t<is_buffer_operand<E>::value && !is_buffer_operand<S>::value>>
+inline
+buffer_unary_expression<E, scalar_multiply_by<S>> operator*(const S& s, const E& e)
+{
+    return { e, scalar_multiply_by<S> { s } };
+}
+
+// User provided element-wise functions (any function object, for example abs_int from revision_2.cpp or a lambda)
+// take part in expressions in the same way:
+//     buffer<int, 4> r = element_wise(b1 - b2, abs_int {}) * 2;
+template<typename E, typename F, typename = std::enable_if_t<is_buffer_operand<E>::value>>
+inline
+buffer_unary_expression<E, F> element_wise(const E& e, F f)
+{
+    return { e, f };
+}
+
+template<typename L, typename R, typename F,
+         typename = std::enable_if_t<is_buffer_operand<L>::value && is_buffer_operand<R>::value>>
+inline
+buffer_binary_expression<L, R, F> element_wise(const L& x, const R& y, F f)
+{
+    return { x, y, f };
 }
 
 /*  // Get n-th element of a buffer. More specific but it does not offer any benefit.
@@ -150,11 +376,31 @@ const Value_type<C>& get(const C& c)
     return c[M];
 }
 
+// The same output as print_buffer, for a text_writer (see text_writer.hpp).
+template<typename T, int N>
+// requires TextFormattable<T>{}
+void write_text(text_writer& writer, const buffer<T, N>& b)
+{
+    for (int i = 0; i != N; ++i) {
+        writer.put_number(b[i]);
+        writer.put(' ');
+    }
+    writer.put('\n');
+}
+
 // We pass a ostream object (cout has a type inheriting from it) so that we do not depend on a particular output.
 template<typename T, int N>
 // requires Streamable<T>{}
 std::ostream& print_buffer(std::ostream& out, const buffer<T, N>& b)
 {
+    // Numbers go through the much faster text_writer whenever it gives the same output.
+    if constexpr (is_text_formattable<T>::value) {
+        if (text_writer::compatible(out)) {
+            text_writer writer(out);
+            write_text(writer, b);
+            return out;
+        }
+    }
     for (int i = 0; i != b.size(); ++i) {
         out << b[i] << ' ';
     }
@@ -168,6 +414,13 @@ template<typename T, int N>
 std::ostream& operator<<(std::ostream& out, const buffer<T, N>& b)
 {
     return print_buffer(out, b);
+}
+
+// Expressions are printed by evaluating them first.
+template<typename E, typename = std::enable_if_t<is_buffer_expression<E>::value>>
+std::ostream& operator<<(std::ostream& out, const E& e)
+{
+    return print_buffer(out, buffer<Value_type<E>, E::extent>(e));
 } 
 
 #endif // !BUFFER_GENERIC_PROGRAMMING
\ No newline at end of file
@@ -0,0 +1,326 @@
+#ifndef BUFFER_KERNELS_GENERIC_PROGRAMMING
+#define BUFFER_KERNELS_GENERIC_PROGRAMMING
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX__) || defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BUFFER_KERNELS_SSE2
+#include <immintrin.h>
+#endif
+
+/// Element-wise kernels for buffer<T, N>
+// These are the loops behind buffer's arithmetic operators. The primary template is the plain loop
+// that works for any T. For the arithmetic types we use the most we can (float, double, 32 and 16 bit integers)
+// we provide explicit specializations that process a whole SIMD register of elements per step.
+// This is an example of template specialization: the interface stays the same, only the implementation
+// is chosen based on the type.
+//     add(x, y, n):    x[i] += y[i]
+//     sub(x, y, n):    x[i] -= y[i]
+//     mul(x, y, n):    x[i] *= y[i]
+//     fma(x, a, b, n): x[i] += a[i] * b[i]   (fused into a single rounding when the hardware has FMA)
+
+// Alignment of buffer storage: a cache line, but never more than the size of the buffer itself
+// (a buffer<float, 4> aligned to 64 bytes would waste three quarters of its memory in arrays of buffers).
+// The kernels load and store with the unaligned instructions (loadu, storeu), since they also get memory we do not
+// align, like that of heap_buffer. On aligned memory those are as fast as the aligned ones; what the alignment of
+// buffer buys is that no full register load or store of its elements splits across two cache lines.
+constexpr std::size_t buffer_cache_line = 64;
+
+constexpr std::size_t buffer_alignment(std::size_t bytes, std::size_t min_alignment)
+{
+    std::size_t a = 1;
+    while (a * 2 <= bytes && a * 2 <= buffer_cache_line) {
+        a *= 2;
+    }
+    return a < min_alignment ? min_alignment : a;
+}
+
+template<typename T>
+struct generic_buffer_kernels {
+    static void add(T* x, const T* y, int n)
+    {
+        for (int i = 0; i != n; ++i) {
+            x[i] += y[i];
+        }
+    }
+    static void sub(T* x, const T* y, int n)
+    {
+        for (int i = 0; i != n; ++i) {
+            x[i] -= y[i];
+        }
+    }
+    static void mul(T* x, const T* y, int n)
+    {
+        for (int i = 0; i != n; ++i) {
+            x[i] *= y[i];
+        }
+    }
+    static void fma(T* x, const T* a, const T* b, int n)
+    {
+        for (int i = 0; i != n; ++i) {
+            x[i] += a[i] * b[i];
+        }
+    }
+};
+
+template<typename T>
+struct buffer_kernels : generic_buffer_kernels<T> {};
+
+#ifdef BUFFER_KERNELS_SSE2
+
+// Each of the structs bellow describes one kind of SIMD register: what it holds, how many elements fit in it
+// and how to load, store and do arithmetic on it. simd_buffer_kernels is written once in terms of them.
+// The floating point registers also have what the reductions need (see reductions.hpp).
+namespace buffer_simd {
+
+struct f32x4 {
+    using value_type = float;
+    using type = __m128;
+    static constexpr int width = 4;
+    static constexpr bool has_mul = true;
+    static type load(const float* p) { return _mm_loadu_ps(p); }
+    static void store(float* p, type v) { _mm_storeu_ps(p, v); }
+    static type add(type a, type b) { return _mm_add_ps(a, b); }
+    static type sub(type a, type b) { return _mm_sub_ps(a, b); }
+    static type mul(type a, type b) { return _mm_mul_ps(a, b); }
+    static type zero() { return _mm_setzero_ps(); }
+    static type set1(float x) { return _mm_set1_ps(x); }
+    static type min(type a, type b) { return _mm_min_ps(a, b); }
+    static type max(type a, type b) { return _mm_max_ps(a, b); }
+#ifdef __FMA__
+    static type fma(type x, type a, type b) { return _mm_fmadd_ps(a, b, x); }
+#else
+    static type fma(type x, type a, type b) { return _mm_add_ps(x, _mm_mul_ps(a, b)); }
+#endif
+};
+
+struct f64x2 {
+    using value_type = double;
+    using type = __m128d;
+    static constexpr int width = 2;
+    static constexpr bool has_mul = true;
+    static type load(const double* p) { return _mm_loadu_pd(p); }
+    static void store(double* p, type v) { _mm_storeu_pd(p, v); }
+    static type add(type a, type b) { return _mm_add_pd(a, b); }
+    static type sub(type a, type b) { return _mm_sub_pd(a, b); }
+    static type mul(type a, type b) { return _mm_mul_pd(a, b); }
+    static type zero() { return _mm_setzero_pd(); }
+    static type set1(double x) { return _mm_set1_pd(x); }
+    static type min(type a, type b) { return _mm_min_pd(a, b); }
+    static type max(type a, type b) { return _mm_max_pd(a, b); }
+#ifdef __FMA__
+    static type fma(type x, type a, type b) { return _mm_fmadd_pd(a, b, x); }
+#else
+    static type fma(type x, type a, type b) { return _mm_add_pd(x, _mm_mul_pd(a, b)); }
+#endif
+};
+
+struct i32x4 {
+    using value_type = std::int32_t;
+    using type = __m128i;
+    static constexpr int width = 4;
+    static type load(const std::int32_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    static void store(std::int32_t* p, type v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+    static type add(type a, type b) { return _mm_add_epi32(a, b); }
+    static type sub(type a, type b) { return _mm_sub_epi32(a, b); }
+    // A 32 bit multiply keeping the low half only came with SSE4.1.
+#ifdef __SSE4_1__
+    static constexpr bool has_mul = true;
+    static type mul(type a, type b) { return _mm_mullo_epi32(a, b); }
+    static type fma(type x, type a, type b) { return _mm_add_epi32(x, _mm_mullo_epi32(a, b)); }
+#else
+    static constexpr bool has_mul = false;
+    static type mul(type a, type) { return a; }
+    static type fma(type x, type, type) { return x; }
+#endif
+};
+
+struct i16x8 {
+    using value_type = std::int16_t;
+    using type = __m128i;
+    static constexpr int width = 8;
+    static constexpr bool has_mul = true;
+    static type load(const std::int16_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    static void store(std::int16_t* p, type v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+    static type add(type a, type b) { return _mm_add_epi16(a, b); }
+    static type sub(type a, type b) { return _mm_sub_epi16(a, b); }
+    static type mul(type a, type b) { return _mm_mullo_epi16(a, b); }
+    static type fma(type x, type a, type b) { return _mm_add_epi16(x, _mm_mullo_epi16(a, b)); }
+};
+
+#ifdef __AVX__
+
+struct f32x8 {
+    using value_type = float;
+    using type = __m256;
+    static constexpr int width = 8;
+    static constexpr bool has_mul = true;
+    static type load(const float* p) { return _mm256_loadu_ps(p); }
+    static void store(float* p, type v) { _mm256_storeu_ps(p, v); }
+    static type add(type a, type b) { return _mm256_add_ps(a, b); }
+    static type sub(type a, type b) { return _mm256_sub_ps(a, b); }
+    static type mul(type a, type b) { return _mm256_mul_ps(a, b); }
+    static type zero() { return _mm256_setzero_ps(); }
+    static type set1(float x) { return _mm256_set1_ps(x); }
+    static type min(type a, type b) { return _mm256_min_ps(a, b); }
+    static type max(type a, type b) { return _mm256_max_ps(a, b); }
+#ifdef __FMA__
+    static type fma(type x, type a, type b) { return _mm256_fmadd_ps(a, b, x); }
+#else
+    static type fma(type x, type a, type b) { return _mm256_add_ps(x, _mm256_mul_ps(a, b)); }
+#endif
+};
+
+struct f64x4 {
+    using value_type = double;
+    using type = __m256d;
+    static constexpr int width = 4;
+    static constexpr bool has_mul = true;
+    static type load(const double* p) { return _mm256_loadu_pd(p); }
+    static void store(double* p, type v) { _mm256_storeu_pd(p, v); }
+    static type add(type a, type b) { return _mm256_add_pd(a, b); }
+    static type sub(type a, type b) { return _mm256_sub_pd(a, b); }
+    static type mul(type a, type b) { return _mm256_mul_pd(a, b); }
+    static type zero() { return _mm256_setzero_pd(); }
+    static type set1(double x) { return _mm256_set1_pd(x); }
+    static type min(type a, type b) { return _mm256_min_pd(a, b); }
+    static type max(type a, type b) { return _mm256_max_pd(a, b); }
+#ifdef __FMA__
+    static type fma(type x, type a, type b) { return _mm256_fmadd_pd(a, b, x); }
+#else
+    static type fma(type x, type a, type b) { return _mm256_add_pd(x, _mm256_mul_pd(a, b)); }
+#endif
+};
+
+#endif // __AVX__
+
+#ifdef __AVX2__
+
+struct i32x8 {
+    using value_type = std::int32_t;
+    using type = __m256i;
+    static constexpr int width = 8;
+    static constexpr bool has_mul = true;
+    static type load(const std::int32_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    static void store(std::int32_t* p, type v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+    static type add(type a, type b) { return _mm256_add_epi32(a, b); }
+    static type sub(type a, type b) { return _mm256_sub_epi32(a, b); }
+    static type mul(type a, type b) { return _mm256_mullo_epi32(a, b); }
+    static type fma(type x, type a, type b) { return _mm256_add_epi32(x, _mm256_mullo_epi32(a, b)); }
+};
+
+struct i16x16 {
+    using value_type = std::int16_t;
+    using type = __m256i;
+    static constexpr int width = 16;
+    static constexpr bool has_mul = true;
+    static type load(const std::int16_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    static void store(std::int16_t* p, type v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+    static type add(type a, type b) { return _mm256_add_epi16(a, b); }
+    static type sub(type a, type b) { return _mm256_sub_epi16(a, b); }
+    static type mul(type a, type b) { return _mm256_mullo_epi16(a, b); }
+    static type fma(type x, type a, type b) { return _mm256_add_epi16(x, _mm256_mullo_epi16(a, b)); }
+};
+
+#endif // __AVX2__
+
+// Runs as many full registers of type V as fit starting from index i and returns where it stopped.
+template<typename V>
+struct simd_loop {
+    using T = typename V::value_type;
+
+    static int add(T* x, const T* y, int n, int i)
+    {
+        for (; i + V::width <= n; i += V::width) {
+            V::store(x + i, V::add(V::load(x + i), V::load(y + i)));
+        }
+        return i;
+    }
+    static int sub(T* x, const T* y, int n, int i)
+    {
+        for (; i + V::width <= n; i += V::width) {
+            V::store(x + i, V::sub(V::load(x + i), V::load(y + i)));
+        }
+        return i;
+    }
+    static int mul(T* x, const T* y, int n, int i)
+    {
+        if (V::has_mul) {
+            for (; i + V::width <= n; i += V::width) {
+                V::store(x + i, V::mul(V::load(x + i), V::load(y + i)));
+            }
+        }
+        return i;
+    }
+    static int fma(T* x, const T* a, const T* b, int n, int i)
+    {
+        if (V::has_mul) {
+            for (; i + V::width <= n; i += V::width) {
+                V::store(x + i, V::fma(V::load(x + i), V::load(a + i), V::load(b + i)));
+            }
+        }
+        return i;
+    }
+};
+
+// Wide registers first (if the compiler may use AVX), then SSE registers, then the remaining elements one by one.
+template<typename Wide, typename Narrow>
+struct simd_buffer_kernels {
+    using T = typename Narrow::value_type;
+
+    static void add(T* x, const T* y, int n)
+    {
+        int i = simd_loop<Narrow>::add(x, y, n, simd_loop<Wide>::add(x, y, n, 0));
+        generic_buffer_kernels<T>::add(x + i, y + i, n - i);
+    }
+    static void sub(T* x, const T* y, int n)
+    {
+        int i = simd_loop<Narrow>::sub(x, y, n, simd_loop<Wide>::sub(x, y, n, 0));
+        generic_buffer_kernels<T>::sub(x + i, y + i, n - i);
+    }
+    static void mul(T* x, const T* y, int n)
+    {
+        int i = simd_loop<Narrow>::mul(x, y, n, simd_loop<Wide>::mul(x, y, n, 0));
+        generic_buffer_kernels<T>::mul(x + i, y + i, n - i);
+    }
+    static void fma(T* x, const T* a, const T* b, int n)
+    {
+        int i = simd_loop<Narrow>::fma(x, a, b, n, simd_loop<Wide>::fma(x, a, b, n, 0));
+        generic_buffer_kernels<T>::fma(x + i, a + i, b + i, n - i);
+    }
+};
+
+#ifdef __AVX__
+using f32_wide = f32x8;
+using f64_wide = f64x4;
+#else
+using f32_wide = f32x4;
+using f64_wide = f64x2;
+#endif
+
+#ifdef __AVX2__
+using i32_wide = i32x8;
+using i16_wide = i16x16;
+#else
+using i32_wide = i32x4;
+using i16_wide = i16x8;
+#endif
+
+} // namespace buffer_simd
+
+template<>
+struct buffer_kernels<float> : buffer_simd::simd_buffer_kernels<buffer_simd::f32_wide, buffer_simd::f32x4> {};
+
+template<>
+struct buffer_kernels<double> : buffer_simd::simd_buffer_kernels<buffer_simd::f64_wide, buffer_simd::f64x2> {};
+
+template<>
+struct buffer_kernels<std::int32_t> : buffer_simd::simd_buffer_kernels<buffer_simd::i32_wide, buffer_simd::i32x4> {};
+
+template<>
+struct buffer_kernels<std::int16_t> : buffer_simd::simd_buffer_kernels<buffer_simd::i16_wide, buffer_simd::i16x8> {};
+
+#endif // BUFFER_KERNELS_SSE2
+
+#endif // !BUFFER_KERNELS_GENERIC_PROGRAMMING
@@ -0,0 +1,259 @@
+#ifndef CHANNEL_GENERIC_PROGRAMMING
+#define CHANNEL_GENERIC_PROGRAMMING
+
+#include <coroutine>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include "circular_buffer.hpp"
+#include "executors.hpp"
+
+/// Channels between coroutines
+// A bounded queue for coroutines: the elements are in a circular_buffer, and instead of blocking a thread
+//     co_await ch.push(x)    suspends the coroutine while the channel is full,
+//     co_await ch.pop()      suspends it while the channel is empty.
+// A suspended coroutine waits in a list inside the channel. The list nodes are the awaiters themselves: the
+// objects push() and pop() return, which the compiler keeps in the frame of the waiting coroutine for as long as
+// it is suspended. So waiting allocates nothing, and neither does the hand-off: push gives its element straight to
+// a waiting pop (into the optional inside its awaiter), pop moves the element of a waiting push into the place it
+// just freed in the buffer. The woken coroutine is scheduled on the channel's executor.
+//
+// pop() gives a std::optional, which is empty once the channel is closed and drained; push() gives false if the
+// channel was closed. close() wakes up everybody waiting.
+//
+// Mutex protects the channel from coroutines running on several threads at once. With a single threaded
+// executor nothing runs concurrently, and null_mutex makes the locking disappear.
+//
+// The elements are only ever moved, never copied, so move-only types like std::unique_ptr are fine.
+
+struct null_mutex {
+    void lock()
+    {}
+    void unlock()
+    {}
+};
+
+template<typename T, typename Mutex = std::mutex>
+// requires Movable<T>{} && DefaultConstructible<T>{} && BasicLockable<Mutex>{}
+class channel {
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+
+    class push_awaiter;
+    class pop_awaiter;
+
+    channel(size_type capacity, executor& e) // [[expects: capacity > 0]]
+        : buffer_(capacity), executor_(e), closed_(false)
+    {}
+
+    channel(const channel&) = delete;
+    channel& operator=(const channel&) = delete;
+
+    // [[expects: nobody is waiting]]
+    ~channel() = default;
+
+    push_awaiter push(T x)
+    {
+        return push_awaiter(*this, std::move(x));
+    }
+    pop_awaiter pop()
+    {
+        return pop_awaiter(*this);
+    }
+
+    // Wakes up everybody waiting: pushes fail, pops get what is left and then nothing.
+    void close()
+    {
+        push_awaiter* pushers;
+        pop_awaiter* poppers;
+        {
+            std::lock_guard<Mutex> lock(mutex_);
+            closed_ = true;
+            pushers = std::exchange(pushers_.first, nullptr);
+            pushers_.last = nullptr;
+            poppers = std::exchange(poppers_.first, nullptr);
+            poppers_.last = nullptr;
+        }
+        // Once scheduled, a coroutine may run (and its awaiter be gone) before we take the next one.
+        while (pushers != nullptr) {
+            push_awaiter* next = pushers->next_;
+            pushers->ok_ = false;
+            executor_.schedule(pushers->handle_);
+            pushers = next;
+        }
+        while (poppers != nullptr) {
+            pop_awaiter* next = poppers->next_;
+            executor_.schedule(poppers->handle_);
+            poppers = next;
+        }
+    }
+
+    // Only a hint when coroutines on other threads use the channel.
+    size_type size() const
+    {
+        return buffer_.size();
+    }
+    size_type capacity() const
+    {
+        return buffer_.capacity();
+    }
+
+    class push_awaiter {
+    public:
+        push_awaiter(channel& ch, T x)
+            : channel_(ch), value_(std::move(x)), next_(nullptr), ok_(true)
+        {}
+
+        bool await_ready() const
+        {
+            return false;
+        }
+        // Returns false (and the coroutine goes on without suspending) if the element could be delivered.
+        bool await_suspend(std::coroutine_handle<> h)
+        {
+            return channel_.suspend_push(*this, h);
+        }
+        bool await_resume() const
+        {
+            return ok_;
+        }
+
+    private:
+        friend class channel;
+
+        channel& channel_;
+        T value_;
+        std::coroutine_handle<> handle_;
+        push_awaiter* next_;
+        bool ok_;
+    };
+
+    class pop_awaiter {
+    public:
+        explicit pop_awaiter(channel& ch)
+            : channel_(ch), next_(nullptr)
+        {}
+
+        bool await_ready() const
+        {
+            return false;
+        }
+        bool await_suspend(std::coroutine_handle<> h)
+        {
+            return channel_.suspend_pop(*this, h);
+        }
+        std::optional<T> await_resume()
+        {
+            return std::move(value_);
+        }
+
+    private:
+        friend class channel;
+
+        channel& channel_;
+        std::optional<T> value_;
+        std::coroutine_handle<> handle_;
+        pop_awaiter* next_;
+    };
+
+private:
+    // An intrusive FIFO list of waiting awaiters.
+    template<typename A>
+    struct waiters {
+        A* first = nullptr;
+        A* last = nullptr;
+
+        bool empty() const
+        {
+            return first == nullptr;
+        }
+        void push_back(A* a)
+        {
+            a->next_ = nullptr;
+            if (last == nullptr) {
+                first = a;
+            }
+            else {
+                last->next_ = a;
+            }
+            last = a;
+        }
+        A* pop_front() // [[expects: !empty()]]
+        {
+            A* a = first;
+            first = a->next_;
+            if (first == nullptr) {
+                last = nullptr;
+            }
+            return a;
+        }
+    };
+
+    bool suspend_push(push_awaiter& a, std::coroutine_handle<> h)
+    {
+        std::coroutine_handle<> wake;
+        {
+            std::lock_guard<Mutex> lock(mutex_);
+            if (closed_) {
+                a.ok_ = false;
+                return false;
+            }
+            if (!poppers_.empty()) {
+                // The buffer is empty and a consumer is waiting: give it the element directly.
+                pop_awaiter* p = poppers_.pop_front();
+                p->value_.emplace(std::move(a.value_));
+                wake = p->handle_;
+            }
+            else if (buffer_.size() != buffer_.capacity()) {
+                buffer_.push_back(std::move(a.value_));
+            }
+            else {
+                a.handle_ = h;
+                pushers_.push_back(&a);
+                return true;
+            }
+        }
+        if (wake) {
+            executor_.schedule(wake);
+        }
+        return false;
+    }
+
+    bool suspend_pop(pop_awaiter& a, std::coroutine_handle<> h)
+    {
+        std::coroutine_handle<> wake;
+        {
+            std::lock_guard<Mutex> lock(mutex_);
+            if (!buffer_.empty()) {
+                a.value_.emplace(std::move(buffer_.front()));
+                buffer_.pop_front();
+                // A producer was waiting for the place we just freed.
+                if (!pushers_.empty()) {
+                    push_awaiter* p = pushers_.pop_front();
+                    buffer_.push_back(std::move(p->value_));
+                    wake = p->handle_;
+                }
+            }
+            else if (!closed_) {
+                a.handle_ = h;
+                poppers_.push_back(&a);
+                return true;
+            }
+        }
+        if (wake) {
+            executor_.schedule(wake);
+        }
+        return false;
+    }
+
+    Mutex mutex_;
+    circular_buffer<T> buffer_;
+    executor& executor_;
+    waiters<push_awaiter> pushers_;
+    waiters<pop_awaiter> poppers_;
+    bool closed_;
+};
+
+#endif // !CHANNEL_GENERIC_PROGRAMMING
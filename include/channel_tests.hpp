@@ -0,0 +1,12 @@
+#ifndef CHANNEL_TESTS_GENERIC_PROGRAMMING
+#define CHANNEL_TESTS_GENERIC_PROGRAMMING
+
+#include "channel.hpp"
+
+bool test_channel();
+
+bool test_channel_threaded();
+
+void test_channel_performance();
+
+#endif // !CHANNEL_TESTS_GENERIC_PROGRAMMING
@@ -2,9 +2,17 @@
 #define CIRCULAR_BUFFER_GENERIC_PROGRAMMING
 
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <limits>
 #include <iostream>
+#include <memory>
+#include <type_traits>
 #include <utility>
+#include "array_segment.hpp"
+#include "relocation.hpp"
+#include "ring_memory.hpp"
+#include "text_writer.hpp"
 
 /// STL Complaint Circular Buffer.
 /// The idea is to have an array that mimics an array that loops around on itself, thus leaving the impression
@@ -36,29 +44,53 @@ public:
     using const_pointer = const T*;
     using size_type = std::size_t;
     using difference_type = std::ptrdiff_t;
+    using self_type = circular_buffer<T>;
     using iterator = circular_buffer_iterator<self_type>;
 public:
     // We define several constructors bellow.
     circular_buffer()
-        : array_(nullptr), array_size_(0),
-        head_(0), tail_(0), contents_size_(0)
+        : memory_(nullptr), array_(nullptr), array_size_(0),
+        head_(0), tail_(0), contents_size_(0), end_seq_(0)
     {}
 
     explicit circular_buffer(std::size_t capacity)
-        : array_(new T[capacity]), array_size_(capacity),
-        head_(0), tail_(capacity), contents_size_(0)
+        : memory_(nullptr), array_(new T[capacity]), array_size_(capacity),
+        head_(0), tail_(capacity), contents_size_(0), end_seq_(0)
     {}
 
+    // A buffer whose array (and every array it gets later, through reserve or copying) is mapped with huge pages
+    // and/or placed on NUMA nodes, see ring_memory.hpp. Worth it for rings of hundreds of megabytes and more.
+    // We delegate to the default constructor first: from then on the object is complete, so if allocating
+    // throws its destructor runs and frees memory_.
+    circular_buffer(std::size_t capacity, const ring_memory_options& options)
+        : circular_buffer()
+    {
+        if (!options.is_default()) {
+            memory_ = new ring_memory { options, {} };
+        }
+        array_ = allocate(capacity);
+        array_size_ = tail_ = capacity;
+    }
+
     // The copy constructor and assignment operator are necessary for keeping the invariant of container.
+    // It delegates too, for the same reason.
     circular_buffer(const circular_buffer& other)
-        : array_(new T[other.array_size_]), array_size_(other.array_size_),
-        head_(other.head_), tail_(other.tail_), contents_size_(other.contents_size_)
+        : circular_buffer()
     {
-        // We need to perform a deep copy. In order to do this we have to copy each element in the underlying buffer
-        for (size_type i = 0; i != other.size(); ++i) {
-            this->operator[](i) = other[i];
+        if (other.memory_ != nullptr) {
+            memory_ = new ring_memory { other.memory_->options, {} };
         }
-        // Once we implement iterators this will simplify immensely.
+        array_ = allocate(other.array_size_);
+        array_size_ = other.array_size_;
+        head_ = other.head_;
+        tail_ = other.tail_;
+        contents_size_ = other.contents_size_;
+        end_seq_ = other.end_seq_;
+        // We need to perform a deep copy. How depends on the element type, so we let overloading pick the right
+        // way: std::is_trivially_copyable<T> is a type with a base of either std::true_type or std::false_type
+        // and we pass an object of it along (this is called tag dispatch). Unlike a run time if, the overload
+        // that does not apply is never even compiled for T.
+        copy_elements(other, std::is_trivially_copyable<T> {});
     }
     circular_buffer& operator=(const circular_buffer& other)
     {
@@ -72,15 +104,27 @@ public:
     }
 
     // This function essentially swaps the internal state of the two buffers.
+    // The elements stay where they are, only the pointers to the arrays change hands, whatever the element type.
     void swap(circular_buffer& other)
     {
         // We want to use the standard swap (no need to define out own for this).
         using std::swap;
+        swap(this->memory_, other.memory_);
         swap(this->array_, other.array_);
         swap(this->array_size_, other.array_size_);
         swap(this->head_, other.head_);
         swap(this->tail_, other.tail_);
         swap(this->contents_size_, other.contents_size_);
+        swap(this->end_seq_, other.end_seq_);
+    }
+    // Takes the array and elements of other and gives it ours, like swap, except for the sequence numbers: they
+    // carry on from where ours were, as if we had been cleared and the elements of other pushed. Consumers
+    // holding a sequence number of ours (sequence_cursor) read the new elements as the next ones.
+    void replace_contents(circular_buffer& other)
+    {
+        sequence_type end = end_seq_ + other.contents_size_;
+        swap(other);
+        end_seq_ = end;
     }
 
     // Obviously, we must free all of the resources we are in control of.
@@ -88,7 +132,8 @@ public:
     // See the idiom RAII on-line for more information on this.
     ~circular_buffer()
     {
-        delete[] array_;
+        deallocate(array_, array_size_, memory());
+        delete memory_;
     }
     
     iterator begin()
@@ -122,7 +167,8 @@ public:
     {
         return array_[tail_ - 1];
     }
-    // A method that simply resets the buffer state
+    // A method that simply resets the buffer state. The sequence numbers carry on from where they were
+    // (the cleared elements count as removed, like pop_front).
     void clear() // [[assures: empty()]]
     {
         head_ = contents_size_ = 0;
@@ -133,6 +179,17 @@ public:
     {
         return array_;
     }
+    const ring_memory_options& memory_options() const
+    {
+        static const ring_memory_options defaults {};
+        return memory_ == nullptr ? defaults : memory_->options;
+    }
+    // What the array is mapped with. Empty unless the buffer was constructed with ring_memory_options.
+    const ring_memory_block& memory() const
+    {
+        static const ring_memory_block none {};
+        return memory_ == nullptr ? none : memory_->block;
+    }
     // This method allocates a new array if needed (through reserve) and then makes the container have the specified number of elements.
     void resize(size_type n, const_reference val) // [[assures: size() == n]]
     {
@@ -162,22 +219,20 @@ public:
     {
         // Only take actions when there is less capacity.
         if (n > capacity()) {
-            // Allocate the memory first;
-            pointer temp_buffer = new value_type[n];
-            // Copy the valid elements of the circular buffer to the new memory.
+            // Allocate the memory first (allocate replaces the mapping in memory_, so keep the old one);
+            ring_memory_block old_memory = memory();
+            pointer temp_buffer = allocate(n);
+            // Move the valid elements of the circular buffer to the beginning of the new memory.
             // We do not care for elements that are outside the range [head, tail)
-            for (size_type i = 0; i < size(); ++i) {
-                // Of course, we will use the functions we have already defined.
-                temp_buffer[i] = this->operator[](i);
-            }
+            relocate_elements(temp_buffer, is_trivially_relocatable<T> {});
             // We need to swap the old buffer with the new one and then free the old memory.
             std::swap(temp_buffer, array_);
             // We need to change the head_ and the tail_ indexes since we have copied the
             // all elements to the beginning of a new allocated array.
             head_ = 0;
             tail_ = size();
+            deallocate(temp_buffer, array_size_, old_memory);
             array_size_ = n;
-            delete[] temp_buffer;
         }
     }
     
@@ -188,12 +243,23 @@ public:
         increment_tail();
         // Then we assign the element to the one before where tail points to.
         array_[tail_ - 1] = val;
+        ++end_seq_;
         // We will override the first element in case we "overflow".
         if (size() > capacity()) {
             increment_head();
         }
         // Assign the next item to the incremented tail.
     }
+    // The same for a value we may take over: it is moved into its place instead of copied.
+    void push_back(value_type&& val) // [[assures: !empty()]]
+    {
+        increment_tail();
+        array_[tail_ - 1] = std::move(val);
+        ++end_seq_;
+        if (size() > capacity()) {
+            increment_head();
+        }
+    }
     // The main method to remove elements from the circular_buffer.
     void pop_front() // [[expects: !empty()]]
     {
@@ -208,6 +274,7 @@ public:
         for (size_type i = old_size; i < size(); ++i) {
             this->operator[](i) = val;
         }
+        end_seq_ += n;
         int diff = size() - capacity();
         //if (size() > capacity()) {
         if (diff > 0) {
@@ -258,7 +325,155 @@ public:
         return array_[index];
     }
 
+    // The elements in their physical layout: array_one() runs from the head to the end of the underlying array
+    // (or to the last element if there is no wrap around), array_two() holds the rest from the beginning of the array.
+    // Algorithms that loop over the two segments only deal with the wrap around once instead of at every element.
+    array_segment<T> array_one()
+    {
+        return { array_ + head_, first_segment_size() };
+    }
+    array_segment<T> array_two()
+    {
+        return { array_, size() - first_segment_size() };
+    }
+    array_segment<const T> array_one() const
+    {
+        return { array_ + head_, first_segment_size() };
+    }
+    array_segment<const T> array_two() const
+    {
+        return { array_, size() - first_segment_size() };
+    }
+
+    // Makes the first n elements of the underlying array the contents, as they are, and returns them so they can
+    // be filled in place (reading a snapshot straight into the array, for example). Faster than n push_backs, and
+    // numbered as if they were n new push_backs.
+    array_segment<T> assign_in_place(size_type n) // [[expects: n <= capacity()]]
+    {
+        end_seq_ += n;
+        head_ = 0;
+        tail_ = n == 0 ? capacity() : n;
+        contents_size_ = n;
+        return { array_, n };
+    }
+
+    /// Sequence numbers
+    // An index of operator[] is relative to the oldest element, so the same index means a different element after
+    // every push_back that overwrites the oldest one. A consumer reading the buffer a bit at a time cannot tell from
+    // indices what it missed. Sequence numbers do not move: the element pushed k-th (counting from 0) has sequence
+    // number k for as long as it is in the buffer. A consumer remembers the sequence number it wants next (see
+    // sequence_cursor.hpp) and learns exactly how many elements it lost from first_seq().
+    // We do not store a number with every element: the elements in the buffer were pushed one after the other, so
+    // they are numbered consecutively and one counter of all the pushes ever made numbers all of them.
+    // A 64 bit counter does not wrap around: at a billion pushes per second it would take over 500 years.
+    using sequence_type = std::uint64_t;
+
+    // The sequence number of front(), or end_seq() if the buffer is empty.
+    sequence_type first_seq() const
+    {
+        return end_seq_ - contents_size_;
+    }
+    // One past the sequence number of back(): the number the next push_back gets.
+    sequence_type end_seq() const
+    {
+        return end_seq_;
+    }
+    // False for elements already overwritten or popped and for elements not pushed yet.
+    bool contains_seq(sequence_type s) const
+    {
+        return s >= first_seq() && s < end_seq_;
+    }
+    reference at_seq(sequence_type s) // [[expects: contains_seq(s)]]
+    {
+        return this->operator[](static_cast<size_type>(s - first_seq()));
+    }
+    const_reference at_seq(sequence_type s) const // [[expects: contains_seq(s)]]
+    {
+        return this->operator[](static_cast<size_type>(s - first_seq()));
+    }
+
 private:
+    /// Copying and relocating the elements
+    // Trivially copyable elements (int, color_rgba, ...) are plain bytes: each of the (at most) two segments
+    // of the other buffer is copied to the same place in our array with one memcpy.
+    void copy_elements(const circular_buffer& other, std::true_type)
+    {
+        for (const array_segment<const T>& segment : { other.array_one(), other.array_two() }) {
+            if (!segment.empty()) {
+                std::memcpy(array_ + (segment.data() - other.array_), segment.data(), segment.size() * sizeof(T));
+            }
+        }
+    }
+    // Anything else is assigned element by element.
+    void copy_elements(const circular_buffer& other, std::false_type)
+    {
+        for (size_type i = 0; i != other.size(); ++i) {
+            this->operator[](i) = other[i];
+        }
+    }
+
+    // The old array is deleted right after reserve moves the elements out of it, so there is no need to copy them.
+    // Both arrays hold constructed objects (allocate constructs all of them), so for trivially relocatable types
+    // we swap the bytes of the elements with the default constructed objects in the new array: the elements end up
+    // in the new array and deallocate destroys the default objects left in the old one. Trivially copyable types are
+    // simply copied. Either way it is one bulk operation per segment.
+    void relocate_elements(pointer destination, std::true_type)
+    {
+        size_type offset = 0;
+        for (const array_segment<T>& segment : { array_one(), array_two() }) {
+            if constexpr (std::is_trivially_copyable<T>::value) {
+                if (!segment.empty()) {
+                    std::memcpy(destination + offset, segment.data(), segment.size() * sizeof(T));
+                }
+            }
+            else {
+                swap_object_bytes(destination + offset, segment.data(), segment.size());
+            }
+            offset += segment.size();
+        }
+    }
+    void relocate_elements(pointer destination, std::false_type)
+    {
+        for (size_type i = 0; i < size(); ++i) {
+            destination[i] = std::move(this->operator[](i));
+        }
+    }
+
+    size_type first_segment_size() const
+    {
+        return size() < array_size_ - head_ ? size() : array_size_ - head_;
+    }
+
+    // An array of n default constructed elements, like new T[n]. With ring_memory_options the memory is mapped
+    // instead, and the new mapping replaces the one in memory_ (once nothing can throw any more).
+    pointer allocate(size_type n)
+    {
+        if (memory_ == nullptr) {
+            return new T[n];
+        }
+        ring_memory_block block = allocate_ring_memory(n * sizeof(T), memory_->options);
+        pointer p = static_cast<pointer>(block.data);
+        try {
+            std::uninitialized_default_construct_n(p, n);
+        }
+        catch (...) {
+            free_ring_memory(block);
+            throw;
+        }
+        memory_->block = block;
+        return p;
+    }
+    // Frees an array from allocate, and its mapping if it has one.
+    void deallocate(pointer p, size_type n, const ring_memory_block& block) const
+    {
+        if (memory_ == nullptr) {
+            delete[] p;
+            return;
+        }
+        std::destroy_n(p, n);
+        free_ring_memory(block);
+    }
+
     // Helper methods for keeping the containers invariants
 
     void increment_tail() // [[expects: size() != capacity()]]
@@ -303,6 +518,8 @@ private:
     
     // Internal data for the circular_buffer
 
+    // The options and mapping of a buffer constructed with ring_memory_options, nullptr for one using new[].
+    ring_memory* memory_;
     // A pointer to the underlying elements.
     value_type* array_;
     // The size of the underlying array.
@@ -313,13 +530,37 @@ private:
     size_type  tail_;
     // Number of (valid) elements stored in the buffer. 
     size_type  contents_size_;
+    // The number of elements ever pushed, which is the sequence number of the next one.
+    sequence_type end_seq_;
 };
 
 
+// The same output as operator<<, for a text_writer (see text_writer.hpp). The two segments are plain arrays.
+template<typename T>
+// requires TextFormattable<T>{}
+void write_text(text_writer& writer, const circular_buffer<T>& buf)
+{
+    for (const array_segment<const T>& segment : { buf.array_one(), buf.array_two() }) {
+        for (const T& x : segment) {
+            writer.put_number(x);
+            writer.write(", ", 2);
+        }
+    }
+    writer.put('\n');
+}
+
 // Output operator for the circular_buffer class
 template<typename T>
 std::ostream& operator<<(std::ostream& out, const circular_buffer<T>& buf)
 {
+    // Numbers go through the much faster text_writer whenever it gives the same output.
+    if constexpr (is_text_formattable<T>::value) {
+        if (text_writer::compatible(out)) {
+            text_writer writer(out);
+            write_text(writer, buf);
+            return out;
+        }
+    }
     typename circular_buffer<T>::size_type curr {};
     typename circular_buffer<T>::size_type size = buf.size();
     while (curr < size) {
@@ -37,6 +37,18 @@ bool test_circular_buffer_iterator_element_access();
 
 bool test_circular_buffer_iterator_movement();
 
+bool test_static_circular_buffer();
+
+void test_static_circular_buffer_startup_performance();
+
+bool test_soa_circular_buffer();
+
+void test_soa_circular_buffer_channel_performance();
+
+bool test_circular_buffer_bulk_copy();
+
+void test_circular_buffer_copy_performance();
+
 
 
 #endif // !CIRCULAR_BUFFER_TESTS_GENERIC_PROGRAMMING
\ No newline at end of file
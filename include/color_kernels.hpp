@@ -0,0 +1,54 @@
+#ifndef COLOR_KERNELS_GENERIC_PROGRAMMING
+#define COLOR_KERNELS_GENERIC_PROGRAMMING
+
+#include <cstddef>
+#include <cstdint>
+#include "array_segment.hpp"
+#include "revision.hpp"
+
+/// Batch color arithmetic
+// The operators of color_rgba work on one color at a time. When we have whole arrays of colors
+// we can do much better by processing 4 (SSE2) or 8 (AVX2) colors with a single instruction.
+// The batch functions bellow give exactly the same results as calling the operators in a loop:
+//     add_colors(dst, src, n)       <==> for each i: dst[i] += src[i]
+//     subtract_colors(dst, src, n)  <==> for each i: dst[i] -= src[i]
+//     scale_colors(dst, n, s)       <==> for each i: dst[i] *= s
+// Alpha is left unchanged, as with the operators. The instruction set is chosen when compiling
+// (define __AVX2__ or __SSE2__ through the compiler flags, e.g. -mavx2), otherwise the plain operators are used.
+
+void add_colors(color_rgba* dst, const color_rgba* src, std::size_t n);
+
+void subtract_colors(color_rgba* dst, const color_rgba* src, std::size_t n);
+
+void scale_colors(color_rgba* dst, std::size_t n, float s);
+
+// Preparing a scale factor for the kernels costs about as much as scaling a few hundred colors.
+// When the same factor is applied to many small arrays (for example, tile by tile) it can be prepared once.
+struct color_scale {
+    explicit color_scale(float s);
+
+    float factor;
+    // The kernels compute min(255, v * whole + ((v * fraction) >> 16)) for each channel value v. The multiplier is
+    // chosen so that this matches operator*= for all 256 values. If no such multiplier exists, exact is false and
+    // scaling falls back to the operator.
+    bool exact;
+    std::uint16_t whole;
+    std::uint16_t fraction;
+};
+
+void scale_colors(color_rgba* dst, std::size_t n, const color_scale& s);
+
+// Convenience overloads for segments (for example, the two halves of a circular buffer).
+// [[expects: dst.size() == src.size()]]
+void add_colors(array_segment<color_rgba> dst, array_segment<const color_rgba> src);
+
+void subtract_colors(array_segment<color_rgba> dst, array_segment<const color_rgba> src);
+
+void scale_colors(array_segment<color_rgba> dst, float s);
+
+void scale_colors(array_segment<color_rgba> dst, const color_scale& s);
+
+// The name of the instruction set the kernels were compiled for: "AVX2", "SSE2" or "scalar".
+const char* color_kernels_instruction_set();
+
+#endif // !COLOR_KERNELS_GENERIC_PROGRAMMING
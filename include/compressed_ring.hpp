@@ -0,0 +1,372 @@
+#ifndef COMPRESSED_RING_GENERIC_PROGRAMMING
+#define COMPRESSED_RING_GENERIC_PROGRAMMING
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include "circular_buffer.hpp"
+
+#if defined(__AVX__) || defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define COMPRESSED_RING_SSE2
+#include <immintrin.h>
+#endif
+
+/// Compressed ring of integer samples
+// A counter sampled every second goes 1041, 1043, 1043, 1050, ...: eight bytes per sample in a circular_buffer
+// of 64 bit integers, when the differences between consecutive samples would fit in one. compressed_ring keeps
+// the samples as those differences (deltas), in as few bytes as each needs:
+//     zigzag   maps small negative and positive deltas to small unsigned numbers (0, -1, 1, -2, 2 become
+//              0, 1, 2, 3, 4), so that a counter going down a little does not cost as much as a huge number.
+//     varint   writes a number 7 bits at a time, low bits first, with the top bit of each byte saying whether
+//              another byte follows: 0 to 127 take one byte, up to 16383 two, a 64 bit number at most ten.
+// The samples go in blocks of BlockSize. A block header holds the first sample as it is (the base) and where the
+// deltas of the others are, so reaching sample i means finding its block (a division, since all of the blocks
+// are full) and adding up at most BlockSize deltas, instead of decoding everything before it. The newest
+// samples, in the block being filled, stay uncompressed until the block is full.
+//
+// The capacity is in bytes instead of samples: the compressed blocks go one after the other in a byte array,
+// starting over at its beginning when the next one does not fit at the end, and the oldest blocks are thrown
+// away, whole, to make room. How many samples that holds depends on how compressible they are.
+//
+// Decoding is where the time goes when the samples are read back. Most bytes of a slowly changing series are
+// single byte deltas, and 16 of those in a row are one SIMD register: we check that none of the 16 bytes has its
+// continuation bit set (one movemask), undo the zigzag on all of them at once, add them up into running sums
+// with a few shifts and adds, and widen the sums to the samples. Anything else is decoded one varint at a time.
+// The SIMD path is SSE2, which every x86-64 processor has, for 32 and 64 bit samples.
+
+// A signed delta as an unsigned number: the sign goes into the lowest bit.
+template<typename U>
+// requires UnsignedIntegral<U>{}
+U zigzag_encode(U d)
+{
+    using S = std::make_signed_t<U>;
+    return static_cast<U>(static_cast<U>(d << 1) ^ static_cast<U>(static_cast<S>(d) >> (8 * sizeof(U) - 1)));
+}
+template<typename U>
+// requires UnsignedIntegral<U>{}
+U zigzag_decode(U z)
+{
+    return static_cast<U>(static_cast<U>(z >> 1) ^ static_cast<U>(-static_cast<U>(z & 1)));
+}
+
+// Writes x as a varint at out and returns the end of it.
+template<typename U>
+// requires UnsignedIntegral<U>{}
+std::uint8_t* write_varint(std::uint8_t* out, U x)
+{
+    while (x >= 0x80) {
+        *out++ = static_cast<std::uint8_t>(x | 0x80);
+        x = static_cast<U>(x >> 7);
+    }
+    *out++ = static_cast<std::uint8_t>(x);
+    return out;
+}
+
+// Decodes n zigzag varint deltas from p, one at a time: out[i] is the sum of prev and the first i + 1 deltas
+// (wrapping around like unsigned arithmetic). Returns the end of the bytes read.
+template<typename T>
+// requires Integral<T>{}
+const std::uint8_t* decode_deltas_scalar(const std::uint8_t* p, std::size_t n, T prev, T* out)
+{
+    using U = std::make_unsigned_t<T>;
+    U value = static_cast<U>(prev);
+    for (std::size_t i = 0; i != n; ++i) {
+        U z = 0;
+        int shift = 0;
+        std::uint8_t byte;
+        do {
+            byte = *p++;
+            z = static_cast<U>(z | static_cast<U>(static_cast<U>(byte & 0x7F) << shift));
+            shift += 7;
+        } while (byte & 0x80);
+        value = static_cast<U>(value + zigzag_decode(z));
+        out[i] = static_cast<T>(value);
+    }
+    return p;
+}
+
+#ifdef COMPRESSED_RING_SSE2
+
+// The running sums of 16 single byte zigzag deltas (none of the bytes may have its top bit set), as two
+// registers of eight 16 bit lanes: a delta is between -64 and 63, so sums of up to 16 of them fit.
+inline void sum_single_byte_deltas(__m128i bytes, __m128i& low, __m128i& high)
+{
+    // Undo the zigzag in 8 bit lanes: (z >> 1) ^ -(z & 1). There is no 8 bit shift, the mask drops the bit
+    // shifted in from the neighbouring byte.
+    __m128i half = _mm_and_si128(_mm_srli_epi16(bytes, 1), _mm_set1_epi8(0x7F));
+    __m128i sign = _mm_sub_epi8(_mm_setzero_si128(), _mm_and_si128(bytes, _mm_set1_epi8(1)));
+    __m128i deltas = _mm_xor_si128(half, sign);
+    // Widen to 16 bits: put each byte in the high half of a lane and shift it back down, keeping the sign.
+    low = _mm_srai_epi16(_mm_unpacklo_epi8(deltas, deltas), 8);
+    high = _mm_srai_epi16(_mm_unpackhi_epi8(deltas, deltas), 8);
+    // Prefix sums within each register: add the register shifted by one, two and four lanes.
+    low = _mm_add_epi16(low, _mm_slli_si128(low, 2));
+    low = _mm_add_epi16(low, _mm_slli_si128(low, 4));
+    low = _mm_add_epi16(low, _mm_slli_si128(low, 8));
+    high = _mm_add_epi16(high, _mm_slli_si128(high, 2));
+    high = _mm_add_epi16(high, _mm_slli_si128(high, 4));
+    high = _mm_add_epi16(high, _mm_slli_si128(high, 8));
+    // The high eight continue from the last sum of the low eight.
+    __m128i carry = _mm_shufflehi_epi16(low, 0xFF);
+    high = _mm_add_epi16(high, _mm_unpackhi_epi64(carry, carry));
+}
+
+// Sign extends four 16 bit lanes (the low or high half of sums) to 32 bits.
+inline __m128i widen_16_to_32(__m128i lanes16)
+{
+    return _mm_srai_epi32(_mm_unpacklo_epi16(lanes16, lanes16), 16);
+}
+
+// Stores prev plus each of the 16 sums as 32 or 64 bit samples.
+template<typename U>
+// requires UnsignedIntegral<U>{} && (sizeof(U) == 4 || sizeof(U) == 8)
+void store_sums(U* out, U prev, __m128i low, __m128i high)
+{
+    __m128i* o = reinterpret_cast<__m128i*>(out);
+    const __m128i halves[4] = { low, _mm_unpackhi_epi64(low, low), high, _mm_unpackhi_epi64(high, high) };
+    if constexpr (sizeof(U) == 4) {
+        __m128i base = _mm_set1_epi32(static_cast<int>(prev));
+        for (int i = 0; i != 4; ++i) {
+            _mm_storeu_si128(o + i, _mm_add_epi32(base, widen_16_to_32(halves[i])));
+        }
+    }
+    else {
+        __m128i base = _mm_set1_epi64x(static_cast<long long>(prev));
+        for (int i = 0; i != 4; ++i) {
+            // And on to 64 bits, with the sign of each lane as its high half.
+            __m128i sums32 = widen_16_to_32(halves[i]);
+            __m128i sign = _mm_srai_epi32(sums32, 31);
+            _mm_storeu_si128(o + 2 * i, _mm_add_epi64(base, _mm_unpacklo_epi32(sums32, sign)));
+            _mm_storeu_si128(o + 2 * i + 1, _mm_add_epi64(base, _mm_unpackhi_epi32(sums32, sign)));
+        }
+    }
+}
+
+#endif
+
+// The same as decode_deltas_scalar, 16 deltas at a time wherever they are 16 single bytes in a row.
+template<typename T>
+// requires Integral<T>{}
+const std::uint8_t* decode_deltas(const std::uint8_t* p, std::size_t n, T prev, T* out)
+{
+#ifdef COMPRESSED_RING_SSE2
+    if constexpr (sizeof(T) == 4 || sizeof(T) == 8) {
+        using U = std::make_unsigned_t<T>;
+        // Every delta is at least one byte, so while 16 are left there are at least 16 bytes to load.
+        while (n >= 16) {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            int continued = _mm_movemask_epi8(bytes);
+            if (continued == 0) {
+                __m128i low, high;
+                sum_single_byte_deltas(bytes, low, high);
+                store_sums(reinterpret_cast<U*>(out), static_cast<U>(prev), low, high);
+                prev = out[15];
+                p += 16;
+                out += 16;
+                n -= 16;
+            }
+            else {
+                // The single byte deltas before the first longer one, and that one.
+                std::size_t k = static_cast<std::size_t>(std::countr_zero(static_cast<unsigned>(continued)));
+                p = decode_deltas_scalar(p, k + 1, prev, out);
+                prev = out[k];
+                out += k + 1;
+                n -= k + 1;
+            }
+        }
+    }
+#endif
+    return decode_deltas_scalar(p, n, prev, out);
+}
+
+template<typename T, std::size_t BlockSize = 128>
+// requires Integral<T>{}
+class compressed_ring {
+    static_assert(std::is_integral<T>::value && !std::is_same<T, bool>::value, "compressed_ring holds integers");
+    static_assert(BlockSize >= 2, "a block holds a base and at least one delta");
+
+    using unsigned_type = std::make_unsigned_t<T>;
+
+    struct block_header {
+        // The first sample of the block.
+        T base;
+        // Where its deltas are in bytes_, and how many bytes they take.
+        std::size_t offset;
+        std::size_t length;
+    };
+
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+
+    static constexpr size_type block_size = BlockSize;
+    // The most bytes the deltas of a block can take: every delta as long as a varint of the type gets.
+    static constexpr size_type max_block_bytes = (BlockSize - 1) * ((8 * sizeof(T) + 6) / 7);
+
+    // The compressed blocks get byte_capacity bytes (at least max_block_bytes, so that any block fits).
+    explicit compressed_ring(size_type byte_capacity)
+        : byte_capacity_(byte_capacity < max_block_bytes ? max_block_bytes : byte_capacity),
+          bytes_(new std::uint8_t[byte_capacity_]),
+          // Every block takes at least one byte per delta, so no more than this many fit.
+          blocks_(byte_capacity_ / (BlockSize - 1) + 1),
+          write_(0), block_bytes_(0), open_size_(0)
+    {}
+
+    compressed_ring(const compressed_ring&) = delete;
+    compressed_ring& operator=(const compressed_ring&) = delete;
+
+    // Adds a sample, throwing away the oldest block if there is no room for the one it completes.
+    void push_back(T x)
+    {
+        open_[open_size_++] = x;
+        if (open_size_ == BlockSize) {
+            seal();
+        }
+    }
+
+    void clear() // [[assures: empty()]]
+    {
+        blocks_.clear();
+        write_ = block_bytes_ = open_size_ = 0;
+    }
+
+    size_type size() const
+    {
+        return blocks_.size() * BlockSize + open_size_;
+    }
+    bool empty() const
+    {
+        return size() == 0;
+    }
+    // The number of compressed blocks.
+    size_type block_count() const
+    {
+        return blocks_.size();
+    }
+    size_type byte_capacity() const
+    {
+        return byte_capacity_;
+    }
+    // What the samples take now: the compressed deltas and the headers of their blocks, and the open block.
+    size_type compressed_bytes() const
+    {
+        return block_bytes_ + blocks_.size() * sizeof(block_header) + open_size_ * sizeof(T);
+    }
+
+    T front() const // [[expects: !empty()]]
+    {
+        return blocks_.empty() ? open_[0] : blocks_.front().base;
+    }
+    T back() const // [[expects: !empty()]]
+    {
+        return open_size_ != 0 ? open_[open_size_ - 1] : last_sealed_;
+    }
+
+    // The i-th oldest sample. Decodes up to BlockSize - 1 deltas, so reading every sample this way costs
+    // BlockSize / 2 times as much as copy_to.
+    T operator[](size_type i) const // [[expects: i < size()]]
+    {
+        size_type block = i / BlockSize;
+        size_type k = i % BlockSize;
+        if (block == blocks_.size()) {
+            return open_[k];
+        }
+        const block_header& h = blocks_[block];
+        if (k == 0) {
+            return h.base;
+        }
+        T deltas[BlockSize - 1];
+        decode_deltas(bytes_.get() + h.offset, k, h.base, deltas);
+        return deltas[k - 1];
+    }
+
+    // Decodes the samples of a block (all BlockSize of them) into out.
+    void decode_block(size_type block, T* out) const // [[expects: block < block_count()]]
+    {
+        const block_header& h = blocks_[block];
+        out[0] = h.base;
+        decode_deltas(bytes_.get() + h.offset, BlockSize - 1, h.base, out + 1);
+    }
+
+    // Decodes every sample, oldest first, into out (which has room for size() of them). Returns the end.
+    T* copy_to(T* out) const
+    {
+        for (size_type b = 0; b != blocks_.size(); ++b) {
+            decode_block(b, out);
+            out += BlockSize;
+        }
+        if (open_size_ != 0) {
+            std::memcpy(out, open_, open_size_ * sizeof(T));
+        }
+        return out + open_size_;
+    }
+
+private:
+    // Compresses the full open block into bytes_.
+    void seal()
+    {
+        std::uint8_t encoded[max_block_bytes];
+        std::uint8_t* end = encoded;
+        for (size_type i = 1; i != BlockSize; ++i) {
+            unsigned_type delta = static_cast<unsigned_type>(static_cast<unsigned_type>(open_[i])
+                                                             - static_cast<unsigned_type>(open_[i - 1]));
+            end = write_varint(end, zigzag_encode(delta));
+        }
+        size_type length = static_cast<size_type>(end - encoded);
+        make_room(length);
+        std::memcpy(bytes_.get() + write_, encoded, length);
+        blocks_.push_back({ open_[0], write_, length });
+        write_ += length;
+        block_bytes_ += length;
+        last_sealed_ = open_[BlockSize - 1];
+        open_size_ = 0;
+    }
+
+    // Moves write_ to where length bytes are free, throwing away the oldest blocks until they are.
+    // The blocks follow each other from the oldest one round to write_, so the free bytes are those from write_
+    // to the oldest block, or to the end of the array if the oldest block is before write_.
+    void make_room(size_type length) // [[expects: length <= byte_capacity_]]
+    {
+        for (;;) {
+            if (blocks_.empty()) {
+                write_ = 0;
+                return;
+            }
+            size_type oldest = blocks_.front().offset;
+            if (oldest < write_) {
+                if (byte_capacity_ - write_ >= length) {
+                    return;
+                }
+                // The end of the array is too short: start over at the beginning (the bytes left at the end
+                // stay unused until we come round again).
+                write_ = 0;
+            }
+            else if (oldest - write_ >= length) {
+                return;
+            }
+            else {
+                block_bytes_ -= blocks_.front().length;
+                blocks_.pop_front();
+            }
+        }
+    }
+
+    size_type byte_capacity_;
+    std::unique_ptr<std::uint8_t[]> bytes_;
+    // The headers of the compressed blocks, oldest first.
+    circular_buffer<block_header> blocks_;
+    // Where the next block goes in bytes_.
+    size_type write_;
+    // The bytes the blocks take in bytes_.
+    size_type block_bytes_;
+    // The last sample of the newest block, for back() when the open block is empty.
+    T last_sealed_ {};
+    // The newest samples, not compressed yet.
+    T open_[BlockSize];
+    size_type open_size_;
+};
+
+#endif // !COMPRESSED_RING_GENERIC_PROGRAMMING
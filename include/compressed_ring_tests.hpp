@@ -0,0 +1,12 @@
+#ifndef COMPRESSED_RING_TESTS_GENERIC_PROGRAMMING
+#define COMPRESSED_RING_TESTS_GENERIC_PROGRAMMING
+
+#include "compressed_ring.hpp"
+
+bool test_varint_deltas();
+
+bool test_compressed_ring();
+
+void test_compressed_ring_performance();
+
+#endif // !COMPRESSED_RING_TESTS_GENERIC_PROGRAMMING
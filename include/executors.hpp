@@ -0,0 +1,154 @@
+#ifndef EXECUTORS_GENERIC_PROGRAMMING
+#define EXECUTORS_GENERIC_PROGRAMMING
+
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "circular_buffer.hpp"
+
+/// Coroutines and executors
+// A coroutine is a function which can stop half way (co_await something that is not ready yet) and be continued
+// later, from where it stopped, by whoever holds its handle. Its local variables live in a frame the compiler
+// allocates when the coroutine is first called, so suspending and resuming costs no more than a couple of
+// function calls: no thread blocks, and no stack is switched.
+// Something has to decide on which thread and when a suspended coroutine continues. That is an executor: a queue
+// of coroutine handles and something (one thread, several threads) resuming them. Whoever wakes a coroutine up
+// (a channel, see channel.hpp) does not resume it on the spot but hands it to the executor. That keeps the stack
+// from growing with every hand-off and lets the executor decide where it runs.
+//
+//     manual_executor     Resumes the queued coroutines on the thread calling run(), one after the other.
+//                         Nothing runs concurrently, so the channels need no locks (see null_mutex).
+//     threaded_executor   A few threads taking coroutines from a shared queue.
+//
+// The queues are circular buffers of handles that double when full, so scheduling allocates nothing once the
+// queue has reached its working size.
+
+class executor {
+public:
+    virtual ~executor() = default;
+    // Queues h to be resumed. Any thread may call it.
+    virtual void schedule(std::coroutine_handle<> h) = 0;
+};
+
+// The coroutine type for the coroutines we start on executors. It does not run when called, but once spawned:
+//     async_task producer(channel<int>& ch) { for (...) co_await ch.push(i); }
+//     spawn(exec, producer(ch));
+// The frame frees itself when the coroutine returns; nobody waits for it. Exceptions must not escape it.
+class async_task {
+public:
+    struct promise_type {
+        async_task get_return_object()
+        {
+            return async_task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept
+        {
+            return {};
+        }
+        std::suspend_never final_suspend() noexcept
+        {
+            return {};
+        }
+        void return_void()
+        {}
+        void unhandled_exception()
+        {
+            std::terminate();
+        }
+    };
+
+    async_task(async_task&& other) noexcept
+        : handle_(std::exchange(other.handle_, nullptr))
+    {}
+    async_task(const async_task&) = delete;
+    async_task& operator=(const async_task&) = delete;
+
+    // A task which was never spawned never ran, so its frame is still ours to free.
+    ~async_task()
+    {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    // Hands over the coroutine. Someone must resume it (once).
+    std::coroutine_handle<> release()
+    {
+        return std::exchange(handle_, nullptr);
+    }
+
+private:
+    explicit async_task(std::coroutine_handle<promise_type> h)
+        : handle_(h)
+    {}
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+inline void spawn(executor& e, async_task task)
+{
+    e.schedule(task.release());
+}
+
+class manual_executor : public executor {
+public:
+    explicit manual_executor(std::size_t capacity = 64);
+
+    void schedule(std::coroutine_handle<> h) override;
+
+    // Resumes queued coroutines, including those they schedule, until the queue is empty.
+    // Returns how many were resumed.
+    std::size_t run();
+    // Resumes the first queued coroutine, if any.
+    bool run_one();
+
+private:
+    circular_buffer<std::coroutine_handle<>> queue_;
+};
+
+class threaded_executor : public executor {
+public:
+    // A thread_count of zero means "as many threads as the hardware supports".
+    explicit threaded_executor(std::size_t thread_count = 0, std::size_t capacity = 64);
+
+    threaded_executor(const threaded_executor&) = delete;
+    threaded_executor& operator=(const threaded_executor&) = delete;
+
+    // Resumes whatever is still queued, then joins the threads. Coroutines that are suspended on something
+    // nobody will ever wake up are not in the queue and are never finished.
+    ~threaded_executor();
+
+    std::size_t size() const
+    {
+        return threads_.size();
+    }
+
+    void schedule(std::coroutine_handle<> h) override;
+
+private:
+    void worker_loop();
+
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    circular_buffer<std::coroutine_handle<>> queue_;
+    // Threads asleep on ready_: schedule only notifies if there are any.
+    std::size_t sleeping_;
+    bool stopping_;
+    std::vector<std::thread> threads_;
+};
+
+// Appends to a queue of handles, doubling its capacity when it is full instead of overwriting the oldest one.
+inline void push_growing(circular_buffer<std::coroutine_handle<>>& queue, std::coroutine_handle<> h)
+{
+    if (queue.size() == queue.capacity()) {
+        queue.reserve(queue.capacity() == 0 ? 64 : 2 * queue.capacity());
+    }
+    queue.push_back(h);
+}
+
+#endif // !EXECUTORS_GENERIC_PROGRAMMING
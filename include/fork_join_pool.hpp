@@ -0,0 +1,204 @@
+#ifndef FORK_JOIN_POOL_GENERIC_PROGRAMMING
+#define FORK_JOIN_POOL_GENERIC_PROGRAMMING
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "work_stealing_deque.hpp"
+
+/// Fork/join on work stealing deques
+// Divide and conquer algorithms split their work in pieces, work on the pieces in parallel and then wait for all
+// of them (fork, then join). In the style of Cilk:
+//     long long fib(int n)
+//     {
+//         if (n < 2) return n;
+//         long long x, y;
+//         task_group g;
+//         g.spawn([&]() { x = fib(n - 1); });   // may run on another thread
+//         y = fib(n - 2);                       // meanwhile, we do the other half
+//         g.sync();                             // wait for x
+//         return x + y;
+//     }
+//     fork_join_pool pool;
+//     long long f;
+//     pool.run([&]() { f = fib(30); });
+// Spawning is cheap because it only pushes a task onto the lock free deque (work_stealing_deque.hpp) of the
+// worker running the spawning task. Usually the same worker pops the task again in sync and runs it, like a
+// function call, as if it had never been spawned. Only idle workers steal, and they take the oldest task, which
+// in divide and conquer code is the biggest piece left. So tasks move between threads rarely, and then in big
+// pieces.
+// A worker waiting in sync does not block: it runs its own tasks, or steals others', until its group is done.
+//
+// Unlike thread_pool (whose mutex protected queues accept tasks from anybody), only workers may push to their
+// deques. Work from outside the pool comes in through run, which hands its task over under a lock once.
+// Outside of run, spawn simply calls the function (the program then runs serially, with the same result).
+// Tasks must not throw: there is nobody to catch the exception on a worker thread.
+
+// A spawned callable, with the counter of the group waiting for it.
+class fork_join_task {
+public:
+    explicit fork_join_task(std::atomic<std::size_t>* pending)
+        : pending_(pending)
+    {}
+    virtual ~fork_join_task() = default;
+
+    // Runs the task, frees it and then tells its group. The group may be gone right after that.
+    void run_and_release()
+    {
+        execute();
+        std::atomic<std::size_t>* pending = pending_;
+        delete this;
+        if (pending != nullptr) {
+            pending->fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+private:
+    virtual void execute() = 0;
+
+    std::atomic<std::size_t>* pending_;
+};
+
+template<typename F>
+class callable_task : public fork_join_task {
+public:
+    callable_task(std::atomic<std::size_t>* pending, F f)
+        : fork_join_task(pending), f_(std::move(f))
+    {}
+
+private:
+    void execute() override
+    {
+        f_();
+    }
+
+    F f_;
+};
+
+class fork_join_pool {
+public:
+    // A thread_count of zero means "as many threads as the hardware supports".
+    explicit fork_join_pool(std::size_t thread_count = 0);
+
+    fork_join_pool(const fork_join_pool&) = delete;
+    fork_join_pool& operator=(const fork_join_pool&) = delete;
+
+    // Joins all threads. There must not be a run in progress.
+    ~fork_join_pool();
+
+    std::size_t size() const
+    {
+        return workers_.size();
+    }
+
+    // Runs f on one of the workers (where it can spawn) and returns when it is done, along with everything it
+    // spawned. Called from one of our own workers, it simply calls f.
+    template<typename F>
+    // requires Callable<F>{}
+    void run(F f);
+
+    // True when called from one of the threads of this pool.
+    bool in_worker_thread() const;
+
+private:
+    friend class task_group;
+    struct worker;
+
+    // Pushes the task onto the deque of the calling worker. Returns false if the caller is not a worker of any pool.
+    static bool spawn(fork_join_task* task);
+    // Runs tasks on the calling worker until pending is zero.
+    static void sync(const std::atomic<std::size_t>& pending);
+
+    void inject(fork_join_task* task);
+    // Own deque first, then the tasks from run, then the deques of the others.
+    bool find_task(worker& self, fork_join_task*& task);
+    bool steal(worker& self, fork_join_task*& task);
+    void wake_one();
+    void worker_loop(std::size_t index);
+
+    // The worker (if any) the current thread is.
+    static thread_local worker* current_worker_;
+
+    std::vector<std::unique_ptr<worker>> worker_state_;
+    std::vector<std::thread> workers_;
+    // Tasks handed over by run from threads outside of the pool.
+    std::mutex injected_mutex_;
+    std::deque<fork_join_task*> injected_;
+    std::atomic<std::size_t> injected_count_;
+    // Idle workers sleep here after looking for work for a while. Spawning only notifies if somebody sleeps.
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_;
+    std::atomic<std::size_t> sleepers_;
+    std::atomic<bool> stopping_;
+};
+
+// The tasks spawned by one task (or by one call of a recursive function). The destructor waits for them.
+class task_group {
+public:
+    task_group()
+        : pending_(0)
+    {}
+
+    task_group(const task_group&) = delete;
+    task_group& operator=(const task_group&) = delete;
+
+    ~task_group()
+    {
+        sync();
+    }
+
+    // Lets f run, possibly on another worker, while we go on. The things f refers to must live until sync returns.
+    template<typename F>
+    // requires Callable<F>{}
+    void spawn(F f)
+    {
+        pending_.fetch_add(1, std::memory_order_relaxed);
+        callable_task<F>* task = new callable_task<F>(&pending_, std::move(f));
+        if (!fork_join_pool::spawn(task)) {
+            task->run_and_release();
+        }
+    }
+
+    // Waits until every task spawned so far is done. Their effects are visible afterwards.
+    void sync()
+    {
+        if (pending_.load(std::memory_order_acquire) != 0) {
+            fork_join_pool::sync(pending_);
+        }
+    }
+
+private:
+    std::atomic<std::size_t> pending_;
+};
+
+template<typename F>
+void fork_join_pool::run(F f)
+{
+    if (in_worker_thread()) {
+        f();
+        return;
+    }
+    // This state lives on our stack. The task only touches it under the lock, and we do not return before it
+    // has let go of the lock.
+    std::mutex done_mutex;
+    std::condition_variable done;
+    bool finished = false;
+    auto root = [&]() {
+        f();
+        std::lock_guard<std::mutex> lock(done_mutex);
+        finished = true;
+        done.notify_one();
+    };
+    inject(new callable_task<decltype(root)>(nullptr, root));
+    std::unique_lock<std::mutex> lock(done_mutex);
+    done.wait(lock, [&]() { return finished; });
+}
+
+#endif // !FORK_JOIN_POOL_GENERIC_PROGRAMMING
@@ -0,0 +1,15 @@
+#ifndef FORK_JOIN_TESTS_GENERIC_PROGRAMMING
+#define FORK_JOIN_TESTS_GENERIC_PROGRAMMING
+
+#include "fork_join_pool.hpp"
+#include "work_stealing_deque.hpp"
+
+bool test_work_stealing_deque();
+
+bool test_work_stealing_deque_concurrent();
+
+bool test_fork_join_pool();
+
+void test_fork_join_performance();
+
+#endif // !FORK_JOIN_TESTS_GENERIC_PROGRAMMING
@@ -0,0 +1,341 @@
+#ifndef HEAP_BUFFER_GENERIC_PROGRAMMING
+#define HEAP_BUFFER_GENERIC_PROGRAMMING
+
+#include <iostream>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "buffer.hpp"
+#include "buffer_kernels.hpp"
+#include "text_writer.hpp"
+
+/// Runtime sized buffer with small buffer optimization
+// buffer<T, N> needs to know its size when compiling. heap_buffer<T, InlineN> gets its size when it is
+// constructed, like std::vector, but it keeps up to InlineN elements inside the object itself. Only bigger
+// buffers allocate memory on the heap. Since most of our buffers are small, most of them never allocate.
+// (std::string uses the same trick for short strings.)
+//
+// The inline storage is raw memory, not an array of T: we construct exactly size() elements in it,
+// so a heap_buffer<std::string, 16> of size 2 holds two strings and not sixteen.
+// The arithmetic operators mirror those of buffer. Both operands must have the same size.
+template<typename T, int InlineN = 16>
+// requires SemiRegular<T>{}
+class heap_buffer {
+    static_assert(InlineN > 0, "heap_buffer needs room for at least one inline element");
+public:
+    using value_type = T;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    static constexpr int inline_capacity = InlineN;
+
+    // An empty buffer.
+    heap_buffer()
+        : data_(inline_data()), size_(0)
+    {}
+
+    // n value initialized elements (zero for arithmetic types, like the default constructor of buffer).
+    explicit heap_buffer(int n)
+        : heap_buffer(n, T {})
+    {}
+
+    // n elements initialized to a.
+    heap_buffer(int n, const T& a)
+        : data_(allocate(n)), size_(n)
+    {
+        construct([&]() { std::uninitialized_fill_n(data_, n, a); });
+    }
+
+    heap_buffer(const heap_buffer& other)
+        : data_(allocate(other.size_)), size_(other.size_)
+    {
+        construct([&]() { std::uninitialized_copy_n(other.data_, other.size_, data_); });
+    }
+
+    // A heap allocated buffer just gives us its memory. An inline one has to move its elements one by one,
+    // the memory is part of the other object after all. So moving cannot throw unless moving a T can, and then
+    // std::vector<heap_buffer> moves its elements when it grows instead of copying them.
+    heap_buffer(heap_buffer&& other) noexcept(std::is_nothrow_move_constructible<T>::value)
+        : data_(inline_data()), size_(0)
+    {
+        steal(other);
+    }
+
+    // Copy and Swap, as in circular_buffer: if copying throws, we are left as we were. So is swap, unless moving
+    // a T can throw as well (see swap).
+    heap_buffer& operator=(const heap_buffer& other)
+    {
+        if (this != &other) {
+            heap_buffer temp(other);
+            swap(temp);
+        }
+        return *this;
+    }
+
+    heap_buffer& operator=(heap_buffer&& other) noexcept(std::is_nothrow_move_constructible<T>::value)
+    {
+        if (this != &other) {
+            release();
+            steal(other);
+        }
+        return *this;
+    }
+
+    ~heap_buffer()
+    {
+        release();
+    }
+
+    // Two heap allocated buffers just exchange their memory. Inline elements cannot change places without being
+    // moved, so then we go through a third buffer. If moving a T throws half way, both buffers are still valid
+    // but we cannot say what they hold.
+    void swap(heap_buffer& other) noexcept(std::is_nothrow_move_constructible<T>::value)
+    {
+        if (on_heap() && other.on_heap()) {
+            std::swap(data_, other.data_);
+            std::swap(size_, other.size_);
+        }
+        else if (this != &other) {
+            heap_buffer temp(std::move(other));
+            other = std::move(*this);
+            *this = std::move(temp);
+        }
+    }
+
+    int size() const
+    {
+        return size_;
+    }
+    bool empty() const
+    {
+        return size_ == 0;
+    }
+    // True when the elements are stored inside the object.
+    bool is_inline() const
+    {
+        return !on_heap();
+    }
+
+    T& operator[](int n) // [[expects: 0 <= n && n < size()]]
+    {
+        return data_[n];
+    }
+    const T& operator[](int n) const // [[expects: 0 <= n && n < size()]]
+    {
+        return data_[n];
+    }
+
+    pointer data()
+    {
+        return data_;
+    }
+    const_pointer data() const
+    {
+        return data_;
+    }
+    iterator begin()
+    {
+        return data_;
+    }
+    iterator end()
+    {
+        return data_ + size_;
+    }
+    const_iterator begin() const
+    {
+        return data_;
+    }
+    const_iterator end() const
+    {
+        return data_ + size_;
+    }
+
+    // The same element wise operations as buffer, through the same kernels (see buffer_kernels.hpp).
+    heap_buffer& operator+=(const heap_buffer& other) // [[expects: size() == other.size()]]
+    {
+        buffer_kernels<T>::add(data_, other.data_, size_);
+        return *this;
+    }
+    heap_buffer& operator-=(const heap_buffer& other) // [[expects: size() == other.size()]]
+    {
+        buffer_kernels<T>::sub(data_, other.data_, size_);
+        return *this;
+    }
+    heap_buffer& operator*=(const heap_buffer& other) // [[expects: size() == other.size()]]
+    {
+        buffer_kernels<T>::mul(data_, other.data_, size_);
+        return *this;
+    }
+    heap_buffer& fma(const heap_buffer& a, const heap_buffer& b) // [[expects: size() == a.size() == b.size()]]
+    {
+        buffer_kernels<T>::fma(data_, a.data_, b.data_, size_);
+        return *this;
+    }
+
+private:
+    bool on_heap() const
+    {
+        return data_ != inline_data();
+    }
+    T* inline_data()
+    {
+        return reinterpret_cast<T*>(inline_storage_);
+    }
+    const T* inline_data() const
+    {
+        return reinterpret_cast<const T*>(inline_storage_);
+    }
+
+    // Raw memory for n elements: the inline storage if they fit, the heap if they do not.
+    T* allocate(int n)
+    {
+        if (n <= InlineN) {
+            return inline_data();
+        }
+        return static_cast<T*>(::operator new(sizeof(T) * n));
+    }
+
+    // Runs the construction of the elements and frees the memory if one of the constructors throws
+    // (the uninitialized_ algorithms already destroy whatever they managed to construct).
+    template<typename F>
+    void construct(F f)
+    {
+        try {
+            f();
+        }
+        catch (...) {
+            if (on_heap()) {
+                ::operator delete(data_);
+            }
+            throw;
+        }
+    }
+
+    // Takes over the elements of other and leaves it empty. Our own elements must already be released.
+    // If moving an element throws, we are empty (uninitialized_move_n destroys what it managed to construct)
+    // and other keeps its elements, some of them moved from.
+    void steal(heap_buffer& other)
+    {
+        if (other.on_heap()) {
+            data_ = other.data_;
+            size_ = other.size_;
+        }
+        else {
+            data_ = inline_data();
+            size_ = 0;
+            std::uninitialized_move_n(other.data_, other.size_, data_);
+            size_ = other.size_;
+            std::destroy_n(other.data_, other.size_);
+        }
+        other.data_ = other.inline_data();
+        other.size_ = 0;
+    }
+
+    void release()
+    {
+        std::destroy_n(data_, size_);
+        if (on_heap()) {
+            ::operator delete(data_);
+        }
+    }
+
+    // Points either to inline_storage_ or to memory on the heap.
+    T* data_;
+    int size_;
+    alignas(T) unsigned char inline_storage_[sizeof(T) * InlineN];
+};
+
+template<typename T, int InlineN>
+inline
+heap_buffer<T, InlineN> operator+(const heap_buffer<T, InlineN>& x, const heap_buffer<T, InlineN>& y)
+{
+    heap_buffer<T, InlineN> ret = x;
+    ret += y;
+    return ret;
+}
+
+template<typename T, int InlineN>
+inline
+heap_buffer<T, InlineN> operator-(const heap_buffer<T, InlineN>& x, const heap_buffer<T, InlineN>& y)
+{
+    heap_buffer<T, InlineN> ret = x;
+    ret -= y;
+    return ret;
+}
+
+template<typename T, int InlineN>
+inline
+heap_buffer<T, InlineN> operator*(const heap_buffer<T, InlineN>& x, const heap_buffer<T, InlineN>& y)
+{
+    heap_buffer<T, InlineN> ret = x;
+    ret *= y;
+    return ret;
+}
+
+// Every element times a scalar, on either side, like b * 2 for a buffer.
+template<typename T, int InlineN, typename S,
+         typename = std::enable_if_t<!std::is_same<S, heap_buffer<T, InlineN>>::value>>
+inline
+heap_buffer<T, InlineN> operator*(const heap_buffer<T, InlineN>& x, const S& s)
+{
+    heap_buffer<T, InlineN> ret = x;
+    for (T& a : ret) {
+        a = a * s;
+    }
+    return ret;
+}
+
+template<typename S, typename T, int InlineN,
+         typename = std::enable_if_t<!std::is_same<S, heap_buffer<T, InlineN>>::value>>
+inline
+heap_buffer<T, InlineN> operator*(const S& s, const heap_buffer<T, InlineN>& x)
+{
+    heap_buffer<T, InlineN> ret = x;
+    for (T& a : ret) {
+        a = s * a;
+    }
+    return ret;
+}
+
+// get<M> (see buffer.hpp) works as it is, since heap_buffer has a value_type and a subscript operator.
+
+template<typename T, int InlineN>
+// requires TextFormattable<T>{}
+void write_text(text_writer& writer, const heap_buffer<T, InlineN>& b)
+{
+    for (const T& x : b) {
+        writer.put_number(x);
+        writer.put(' ');
+    }
+    writer.put('\n');
+}
+
+template<typename T, int InlineN>
+// requires Streamable<T>{}
+std::ostream& print_buffer(std::ostream& out, const heap_buffer<T, InlineN>& b)
+{
+    if constexpr (is_text_formattable<T>::value) {
+        if (text_writer::compatible(out)) {
+            text_writer writer(out);
+            write_text(writer, b);
+            return out;
+        }
+    }
+    for (int i = 0; i != b.size(); ++i) {
+        out << b[i] << ' ';
+    }
+    out << '\n';
+    return out;
+}
+
+template<typename T, int InlineN>
+// requires Streamable<T>{}
+std::ostream& operator<<(std::ostream& out, const heap_buffer<T, InlineN>& b)
+{
+    return print_buffer(out, b);
+}
+
+#endif // !HEAP_BUFFER_GENERIC_PROGRAMMING
@@ -0,0 +1,207 @@
+#ifndef IMAGE_GENERIC_PROGRAMMING
+#define IMAGE_GENERIC_PROGRAMMING
+
+#include <cstddef>
+#include <vector>
+#include "color_kernels.hpp"
+#include "revision.hpp"
+#include "thread_pool.hpp"
+
+/// Tiled Image
+// The obvious way to store a 2D image is row after row. Walking along a row is then cache friendly but walking
+// down a column (or looking at a small neighbourhood) jumps a whole row ahead in memory with every step.
+// Here the image is cut into square tiles of TileSize x TileSize pixels and every tile is stored contiguously.
+// A 64 x 64 tile of color_rgba is 16 KB so a whole tile stays in the L1/L2 cache while we work on it.
+// Tiles are also a natural unit of work to give to different threads: they never share a cache line.
+//
+// Pixels of the edge tiles that fall outside the image are stored as well (they are just padding).
+// Whole tile operations may touch them, per pixel operations never do.
+
+// A view of a single tile. The valid pixels are the first columns() x rows() pixels of the tile and
+// consecutive rows are stride() pixels apart.
+template<typename T>
+struct image_tile {
+    using value_type = T;
+
+    T*          pixels;
+    std::size_t index;   // Position of the tile in the image (see image::tile).
+    std::size_t x;       // Image coordinates of the top left pixel.
+    std::size_t y;
+    std::size_t width;   // Number of valid columns and rows.
+    std::size_t height;
+    std::size_t tile_size;
+
+    std::size_t columns() const
+    {
+        return width;
+    }
+    std::size_t rows() const
+    {
+        return height;
+    }
+    std::size_t stride() const
+    {
+        return tile_size;
+    }
+    // All of the tile's storage, including padding.
+    array_segment<T> storage() const
+    {
+        return { pixels, tile_size * tile_size };
+    }
+    T& operator()(std::size_t column, std::size_t row) const // [[expects: column < columns() && row < rows()]]
+    {
+        return pixels[row * tile_size + column];
+    }
+};
+
+template<typename T, std::size_t TileSize = 64>
+// requires SemiRegular<T>{}
+class image {
+    static_assert(TileSize > 0, "tiles must have at least one pixel");
+public:
+    using value_type = T;
+    using reference = T&;
+    using const_reference = const T&;
+    using size_type = std::size_t;
+    using tile_type = image_tile<T>;
+    using const_tile_type = image_tile<const T>;
+
+    static constexpr size_type tile_size = TileSize;
+    static constexpr size_type tile_pixels = TileSize * TileSize;
+public:
+    image()
+        : width_(0), height_(0), tiles_x_(0), tiles_y_(0)
+    {}
+
+    image(size_type width, size_type height, const_reference val = value_type {})
+        : width_(width), height_(height),
+        tiles_x_((width + TileSize - 1) / TileSize), tiles_y_((height + TileSize - 1) / TileSize),
+        pixels_(tiles_x_ * tiles_y_ * tile_pixels, val)
+    {}
+
+    // Copy, move and destruction are handled by the vector.
+
+    size_type width() const
+    {
+        return width_;
+    }
+    size_type height() const
+    {
+        return height_;
+    }
+    size_type tiles_x() const
+    {
+        return tiles_x_;
+    }
+    size_type tiles_y() const
+    {
+        return tiles_y_;
+    }
+    size_type tile_count() const
+    {
+        return tiles_x_ * tiles_y_;
+    }
+
+    // Pixel access in image coordinates. Slower than going through the tiles, since we need to find the tile first.
+    reference operator()(size_type x, size_type y) // [[expects: x < width() && y < height()]]
+    {
+        return pixels_[offset(x, y)];
+    }
+    const_reference operator()(size_type x, size_type y) const // [[expects: x < width() && y < height()]]
+    {
+        return pixels_[offset(x, y)];
+    }
+
+    // Tiles are numbered row by row: tile i is at column i % tiles_x() and row i / tiles_x() of the tile grid.
+    tile_type tile(size_type i) // [[expects: i < tile_count()]]
+    {
+        return make_tile<T>(pixels_.data(), i);
+    }
+    const_tile_type tile(size_type i) const // [[expects: i < tile_count()]]
+    {
+        return make_tile<const T>(pixels_.data(), i);
+    }
+
+private:
+    size_type offset(size_type x, size_type y) const
+    {
+        size_type tile_index = (y / TileSize) * tiles_x_ + x / TileSize;
+        return tile_index * tile_pixels + (y % TileSize) * TileSize + x % TileSize;
+    }
+
+    template<typename U>
+    image_tile<U> make_tile(U* data, size_type i) const
+    {
+        size_type x = (i % tiles_x_) * TileSize;
+        size_type y = (i / tiles_x_) * TileSize;
+        size_type w = width_ - x < TileSize ? width_ - x : TileSize;
+        size_type h = height_ - y < TileSize ? height_ - y : TileSize;
+        return { data + i * tile_pixels, i, x, y, w, h, TileSize };
+    }
+
+    size_type width_;
+    size_type height_;
+    size_type tiles_x_;
+    size_type tiles_y_;
+    std::vector<T> pixels_;
+};
+
+
+/// Parallel passes over images
+// Every tile is handed to one thread of the pool. Tiles do not overlap so no synchronization is needed
+// as long as the function only touches the tile it is given.
+
+// Calls f(tile) for every tile of the image.
+template<typename T, std::size_t TileSize, typename F>
+// requires Callable<F, image_tile<T>>{}
+void for_each_tile(image<T, TileSize>& img, thread_pool& pool, F f)
+{
+    pool.parallel_for(img.tile_count(), [&](std::size_t i) { f(img.tile(i)); });
+}
+
+// Calls f(pixel) for every pixel of the image (padding excluded).
+template<typename T, std::size_t TileSize, typename F>
+// requires Callable<F, T&>{}
+void for_each_pixel(image<T, TileSize>& img, thread_pool& pool, F f)
+{
+    for_each_tile(img, pool, [&](image_tile<T> t) {
+        for (std::size_t row = 0; row != t.rows(); ++row) {
+            T* p = &t(0, row);
+            for (std::size_t column = 0; column != t.columns(); ++column) {
+                f(p[column]);
+            }
+        }
+    });
+}
+
+// The color passes use the batch kernels (see color_kernels.hpp) on whole tiles. Both images must have
+// the same dimensions, so their tiles line up and the padding is just along for the ride.
+
+template<std::size_t TileSize>
+void add_images(image<color_rgba, TileSize>& dst, const image<color_rgba, TileSize>& src,
+                thread_pool& pool) // [[expects: dst.width() == src.width() && dst.height() == src.height()]]
+{
+    for_each_tile(dst, pool, [&](image_tile<color_rgba> t) {
+        add_colors(t.storage(), src.tile(t.index).storage());
+    });
+}
+
+template<std::size_t TileSize>
+void subtract_images(image<color_rgba, TileSize>& dst, const image<color_rgba, TileSize>& src,
+                     thread_pool& pool) // [[expects: dst.width() == src.width() && dst.height() == src.height()]]
+{
+    for_each_tile(dst, pool, [&](image_tile<color_rgba> t) {
+        subtract_colors(t.storage(), src.tile(t.index).storage());
+    });
+}
+
+template<std::size_t TileSize>
+void scale_image(image<color_rgba, TileSize>& img, float s, thread_pool& pool)
+{
+    const color_scale factor(s);
+    for_each_tile(img, pool, [&](image_tile<color_rgba> t) {
+        scale_colors(t.storage(), factor);
+    });
+}
+
+#endif // !IMAGE_GENERIC_PROGRAMMING
@@ -0,0 +1,14 @@
+#ifndef IMAGE_TESTS_GENERIC_PROGRAMMING
+#define IMAGE_TESTS_GENERIC_PROGRAMMING
+
+#include "image.hpp"
+
+bool test_image_pixel_access();
+
+bool test_image_color_passes();
+
+bool test_image_for_each_pixel();
+
+void test_image_passes_performance();
+
+#endif // !IMAGE_TESTS_GENERIC_PROGRAMMING
@@ -0,0 +1,229 @@
+#ifndef MULTICAST_RING_GENERIC_PROGRAMMING
+#define MULTICAST_RING_GENERIC_PROGRAMMING
+
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include "array_segment.hpp"
+#include "storage_segments.hpp"
+
+/// Multicast ring
+// One producer, several consumers which all want every element (logging, metrics, replication...). Copying each
+// element into one queue per consumer costs a copy per consumer and that many times the memory. A multicast ring
+// holds every element once. Each consumer owns a cursor: the sequence number of the next element it wants
+// (as in sequence_cursor.hpp). The producer may only reuse a slot once every consumer is past it, so it is gated
+// on the slowest cursor. Nothing is ever lost; a slow consumer slows the producer down instead.
+// This is the design of the LMAX Disruptor.
+//
+// Nobody takes a lock:
+// - The producer fills slots and then publishes them by storing its sequence number (a release store).
+// - A consumer loads that number (an acquire load), reads every slot up to it and then stores its own cursor.
+// - The producer reads the cursors before it overwrites anything.
+// Each counter is written by one thread only. Each sits on its own cache line, so a consumer moving its cursor
+// does not make the others reload theirs.
+//
+// Both sides work in batches. The producer claims n slots, fills them in place and publishes them all with one
+// store. A consumer gets every element published so far as (at most) two plain arrays, and releases them with
+// one store. Under load the batches grow by themselves: a consumer that falls behind finds more elements waiting
+// and pays for the synchronization once for all of them.
+//
+// What a thread does while it waits (for space, or for elements) is a policy, the wait strategy:
+//     busy_spin_wait  never gives up the core. The lowest latency, but each waiting thread keeps a core busy;
+//                     only use it with a core for every thread.
+//     yield_wait      lets other threads run, then tries again.
+//     sleep_wait      spins and yields for a while, then sleeps. Uses the least CPU when idle but reacts the slowest.
+// The wait function is called with the number of times the thread has already waited in a row.
+
+struct busy_spin_wait {
+    void wait(unsigned) const
+    {}
+};
+
+struct yield_wait {
+    void wait(unsigned) const
+    {
+        std::this_thread::yield();
+    }
+};
+
+struct sleep_wait {
+    std::chrono::microseconds period { 50 };
+
+    void wait(unsigned attempt) const
+    {
+        if (attempt < 100) {
+            std::this_thread::yield();
+        }
+        else {
+            std::this_thread::sleep_for(period);
+        }
+    }
+};
+
+template<typename T, typename Wait = yield_wait>
+// requires SemiRegular<T>{} && WaitStrategy<Wait>{}
+class multicast_ring {
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+
+    // The capacity is rounded up to a power of two, so that finding a slot is a mask instead of a division.
+    multicast_ring(size_type capacity, size_type consumers, Wait wait = Wait {})
+    // [[expects: capacity > 0 && consumers > 0]]
+        : mask_(std::bit_ceil(capacity) - 1),
+          slots_(new T[mask_ + 1]),
+          consumers_(consumers),
+          cursors_(new padded_cursor[consumers]),
+          wait_(wait),
+          published_(0), claimed_(0), gate_(0)
+    {}
+
+    multicast_ring(const multicast_ring&) = delete;
+    multicast_ring& operator=(const multicast_ring&) = delete;
+
+    size_type capacity() const
+    {
+        return mask_ + 1;
+    }
+    size_type consumers() const
+    {
+        return consumers_;
+    }
+
+    /// Producer side
+    // Only one thread may produce.
+
+    // Claims the next n slots if every consumer is far enough ahead, without waiting. The slots are handed out
+    // in place, to be filled and then published.
+    bool try_claim(size_type n, storage_segments<T>& out) // [[expects: n <= capacity()]]
+    {
+        if (claimed_ + n > gate_ + capacity()) {
+            gate_ = slowest_cursor();
+            if (claimed_ + n > gate_ + capacity()) {
+                return false;
+            }
+        }
+        out = segments<T>(claimed_, n);
+        claimed_ += n;
+        return true;
+    }
+    // Waits for the slowest consumer to free n slots, then claims them.
+    storage_segments<T> claim(size_type n) // [[expects: n <= capacity()]]
+    {
+        storage_segments<T> out;
+        for (unsigned attempt = 0; !try_claim(n, out); ++attempt) {
+            wait_.wait(attempt);
+        }
+        return out;
+    }
+    // Makes everything claimed so far visible to the consumers.
+    void publish()
+    {
+        published_.store(claimed_, std::memory_order_release);
+    }
+
+    void push_back(const T& x)
+    {
+        storage_segments<T> s = claim(1);
+        s.one[0] = x;
+        publish();
+    }
+
+    // The number of elements published so far.
+    std::uint64_t published() const
+    {
+        return published_.load(std::memory_order_acquire);
+    }
+
+    /// Consumer side
+    // Consumer c (from 0 to consumers() - 1) must only ever be used by one thread at a time.
+
+    // The elements published which consumer c has not released yet, oldest first. Empty if there are none.
+    storage_segments<const T> try_available(size_type c) const // [[expects: c < consumers()]]
+    {
+        std::uint64_t next = cursors_[c].next.load(std::memory_order_relaxed);
+        std::uint64_t end = published_.load(std::memory_order_acquire);
+        return segments<const T>(next, static_cast<size_type>(end - next));
+    }
+    // Waits until there is at least one.
+    storage_segments<const T> wait_available(size_type c) const // [[expects: c < consumers()]]
+    {
+        storage_segments<const T> s = try_available(c);
+        for (unsigned attempt = 0; s.size() == 0; ++attempt) {
+            wait_.wait(attempt);
+            s = try_available(c);
+        }
+        return s;
+    }
+    // Tells the producer consumer c is done with its next n elements, so their slots may be reused.
+    void release(size_type c, size_type n) // [[expects: c < consumers() && n <= try_available(c).size()]]
+    {
+        std::uint64_t next = cursors_[c].next.load(std::memory_order_relaxed);
+        cursors_[c].next.store(next + n, std::memory_order_release);
+    }
+    // Waits for elements, calls f on every available one and releases them. Returns how many there were.
+    template<typename F>
+    // requires Function<F, const T&>{}
+    size_type consume(size_type c, F f) // [[expects: c < consumers()]]
+    {
+        storage_segments<const T> s = wait_available(c);
+        for (const T& x : s.one) {
+            f(x);
+        }
+        for (const T& x : s.two) {
+            f(x);
+        }
+        release(c, s.size());
+        return s.size();
+    }
+
+    // The sequence number of the next element consumer c will get, for monitoring how far behind it is.
+    std::uint64_t cursor(size_type c) const // [[expects: c < consumers()]]
+    {
+        return cursors_[c].next.load(std::memory_order_acquire);
+    }
+
+private:
+    // Each on a cache line of its own.
+    struct alignas(64) padded_cursor {
+        std::atomic<std::uint64_t> next { 0 };
+    };
+
+    std::uint64_t slowest_cursor() const
+    {
+        std::uint64_t slowest = cursors_[0].next.load(std::memory_order_acquire);
+        for (size_type c = 1; c != consumers_; ++c) {
+            std::uint64_t next = cursors_[c].next.load(std::memory_order_acquire);
+            if (next < slowest) {
+                slowest = next;
+            }
+        }
+        return slowest;
+    }
+
+    // The slots of the sequence numbers [first, first + n), which wrap around the end of the array at most once.
+    template<typename U>
+    storage_segments<U> segments(std::uint64_t first, size_type n) const // [[expects: n <= capacity()]]
+    {
+        size_type index = static_cast<size_type>(first) & mask_;
+        size_type n1 = n < capacity() - index ? n : capacity() - index;
+        return { { slots_.get() + index, n1 }, { slots_.get(), n - n1 } };
+    }
+
+    size_type mask_;
+    std::unique_ptr<T[]> slots_;
+    size_type consumers_;
+    std::unique_ptr<padded_cursor[]> cursors_;
+    Wait wait_;
+    // The consumers poll published_; the producer's own counters should not share its cache line.
+    alignas(64) std::atomic<std::uint64_t> published_;
+    // Only used by the producer: the end of what it has claimed, and the slowest cursor when it last looked.
+    alignas(64) std::uint64_t claimed_;
+    std::uint64_t gate_;
+};
+
+#endif // !MULTICAST_RING_GENERIC_PROGRAMMING
@@ -0,0 +1,12 @@
+#ifndef MULTICAST_RING_TESTS_GENERIC_PROGRAMMING
+#define MULTICAST_RING_TESTS_GENERIC_PROGRAMMING
+
+#include "multicast_ring.hpp"
+
+bool test_multicast_ring();
+
+bool test_multicast_ring_concurrent();
+
+void test_multicast_ring_performance();
+
+#endif // !MULTICAST_RING_TESTS_GENERIC_PROGRAMMING
@@ -0,0 +1,286 @@
+#ifndef PAIR_VECTOR_GENERIC_PROGRAMMING
+#define PAIR_VECTOR_GENERIC_PROGRAMMING
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+#include "array_segment.hpp"
+#include "revision_2.hpp"
+
+/// Vector of pairs as two arrays
+// A std::vector<simple_pair<T, U>> stores every first next to its second. Looking a key up means scanning the
+// firsts, but the cache lines we load hold the seconds as well: with 8 byte keys and 24 byte values, three quarters
+// of the memory we read is of no use to us.
+// pair_vector<T, U> keeps the firsts in one array and the seconds in another (the same "structure of arrays" idea
+// as soa_circular_buffer). A scan over the keys only reads the keys and the second of the pair we are looking for is
+// loaded once we found it.
+//
+// There is no simple_pair in memory anymore, so the elements are handed out through pair_reference, a pair of
+// references named first and second: p.first and p.second work just as they do on a simple_pair.
+
+template<typename T, typename U>
+struct pair_reference {
+    using first_type = T;
+    using second_type = U;
+
+    T& first;
+    U& second;
+
+    operator simple_pair<std::remove_const_t<T>, std::remove_const_t<U>>() const
+    {
+        return { first, second };
+    }
+
+    // Assigning writes through the references, like assigning to a reference to a pair would.
+    template<typename V, typename W>
+    const pair_reference& operator=(const simple_pair<V, W>& p) const
+    {
+        first = p.first;
+        second = p.second;
+        return *this;
+    }
+    const pair_reference& operator=(const pair_reference& other) const
+    {
+        first = other.first;
+        second = other.second;
+        return *this;
+    }
+};
+
+// Walks both arrays at the same time. It hands out proxies, so as with soa_iterator the standard library can only
+// treat it as an input iterator, even though it supports the operations of a random access iterator.
+template<typename T, typename U>
+class pair_iterator {
+public:
+    using self_type = pair_iterator<T, U>;
+    using value_type = simple_pair<std::remove_const_t<T>, std::remove_const_t<U>>;
+    using difference_type = std::ptrdiff_t;
+    using reference = pair_reference<T, U>;
+    using pointer = void;
+    using iterator_category = std::input_iterator_tag;
+public:
+    pair_iterator()
+        : first_(nullptr), second_(nullptr)
+    {}
+
+    pair_iterator(T* first, U* second)
+        : first_(first), second_(second)
+    {}
+
+    // An iterator to non const elements converts to one to const elements.
+    template<typename V, typename W>
+    pair_iterator(const pair_iterator<V, W>& other)
+        : first_(other.first_pointer()), second_(other.second_pointer())
+    {}
+
+    T* first_pointer() const
+    {
+        return first_;
+    }
+    U* second_pointer() const
+    {
+        return second_;
+    }
+
+    friend
+    bool operator==(const self_type& x, const self_type& y)
+    {
+        return x.first_ == y.first_;
+    }
+    friend
+    bool operator!=(const self_type& x, const self_type& y)
+    {
+        return !(x == y);
+    }
+    friend
+    bool operator<(const self_type& x, const self_type& y)
+    {
+        return x.first_ < y.first_;
+    }
+
+    reference operator*() const
+    {
+        return { *first_, *second_ };
+    }
+    reference operator[](difference_type n) const
+    {
+        return { first_[n], second_[n] };
+    }
+
+    self_type& operator++()
+    {
+        ++first_;
+        ++second_;
+        return *this;
+    }
+    self_type operator++(int)
+    {
+        self_type ret { *this };
+        ++(*this);
+        return ret;
+    }
+    self_type& operator--()
+    {
+        --first_;
+        --second_;
+        return *this;
+    }
+    self_type operator--(int)
+    {
+        self_type ret { *this };
+        --(*this);
+        return ret;
+    }
+    self_type& operator+=(difference_type n)
+    {
+        first_ += n;
+        second_ += n;
+        return *this;
+    }
+    friend
+    self_type operator+(self_type x, difference_type n)
+    {
+        return x += n;
+    }
+    friend
+    difference_type operator-(const self_type& x, const self_type& y)
+    {
+        return x.first_ - y.first_;
+    }
+
+private:
+    T* first_;
+    U* second_;
+};
+
+template<typename T, typename U>
+// requires SemiRegular<T>{} && SemiRegular<U>{}
+class pair_vector {
+    // std::vector<bool> packs its elements into bits: there is no bool to point or refer to, only proxy objects,
+    // so the references, iterators and segments of pair_vector could not be made of it. Use char or a small enum.
+    static_assert(!std::is_same<T, bool>::value && !std::is_same<U, bool>::value,
+                  "pair_vector cannot hold bool: std::vector<bool> has no bool& to refer to");
+
+public:
+    using value_type = simple_pair<T, U>;
+    using first_type = T;
+    using second_type = U;
+    using reference = pair_reference<T, U>;
+    using const_reference = pair_reference<const T, const U>;
+    using iterator = pair_iterator<T, U>;
+    using const_iterator = pair_iterator<const T, const U>;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+    pair_vector() = default;
+
+    size_type size() const
+    {
+        return firsts_.size();
+    }
+    bool empty() const
+    {
+        return firsts_.empty();
+    }
+    void reserve(size_type n)
+    {
+        firsts_.reserve(n);
+        seconds_.reserve(n);
+    }
+    void clear()
+    {
+        firsts_.clear();
+        seconds_.clear();
+    }
+
+    void push_back(const value_type& p)
+    {
+        push_back(p.first, p.second);
+    }
+    // If adding the second throws, the first is taken back out, so both arrays keep the same size.
+    void push_back(const T& first, const U& second)
+    {
+        firsts_.push_back(first);
+        try {
+            seconds_.push_back(second);
+        }
+        catch (...) {
+            firsts_.pop_back();
+            throw;
+        }
+    }
+    void pop_back() // [[expects: !empty()]]
+    {
+        firsts_.pop_back();
+        seconds_.pop_back();
+    }
+
+    reference operator[](size_type i) // [[expects: i < size()]]
+    {
+        return { firsts_[i], seconds_[i] };
+    }
+    const_reference operator[](size_type i) const // [[expects: i < size()]]
+    {
+        return { firsts_[i], seconds_[i] };
+    }
+
+    iterator begin()
+    {
+        return { firsts_.data(), seconds_.data() };
+    }
+    iterator end()
+    {
+        return begin() + static_cast<difference_type>(size());
+    }
+    const_iterator begin() const
+    {
+        return { firsts_.data(), seconds_.data() };
+    }
+    const_iterator end() const
+    {
+        return begin() + static_cast<difference_type>(size());
+    }
+
+    /// The two arrays
+    // For algorithms which only need one half of the pairs.
+    array_segment<T> firsts()
+    {
+        return { firsts_.data(), firsts_.size() };
+    }
+    array_segment<U> seconds()
+    {
+        return { seconds_.data(), seconds_.size() };
+    }
+    array_segment<const T> firsts() const
+    {
+        return { firsts_.data(), firsts_.size() };
+    }
+    array_segment<const U> seconds() const
+    {
+        return { seconds_.data(), seconds_.size() };
+    }
+
+    // The first pair whose first is equal to key, or end(). Only the firsts are read.
+    iterator find(const T& key)
+    {
+        return begin() + (std::find(firsts_.begin(), firsts_.end(), key) - firsts_.begin());
+    }
+    const_iterator find(const T& key) const
+    {
+        return begin() + (std::find(firsts_.begin(), firsts_.end(), key) - firsts_.begin());
+    }
+
+    // Bytes of element storage in use (not counting spare capacity), to compare with an array of pairs.
+    size_type memory_footprint() const
+    {
+        return size() * (sizeof(T) + sizeof(U));
+    }
+
+private:
+    std::vector<T> firsts_;
+    std::vector<U> seconds_;
+};
+
+#endif // !PAIR_VECTOR_GENERIC_PROGRAMMING
@@ -0,0 +1,12 @@
+#ifndef PAIR_VECTOR_TESTS_GENERIC_PROGRAMMING
+#define PAIR_VECTOR_TESTS_GENERIC_PROGRAMMING
+
+#include "pair_vector.hpp"
+
+bool test_simple_pair_compression();
+
+bool test_pair_vector();
+
+void test_pair_vector_performance();
+
+#endif // !PAIR_VECTOR_TESTS_GENERIC_PROGRAMMING
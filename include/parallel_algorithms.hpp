@@ -0,0 +1,184 @@
+#ifndef PARALLEL_ALGORITHMS_GENERIC_PROGRAMMING
+#define PARALLEL_ALGORITHMS_GENERIC_PROGRAMMING
+
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <vector>
+#include "array_segment.hpp"
+#include "buffer_kernels.hpp"
+#include "storage_segments.hpp"
+#include "thread_pool.hpp"
+
+/// Parallel Algorithms
+// for_each, transform and reduce on all threads of a thread_pool, for buffer and circular_buffer.
+// We do not split the elements by their logical index but by where they are in memory:
+// - The storage of the container is one (buffer) or two (circular_buffer) contiguous segments
+//   (see storage_segments.hpp).
+// - Every segment is cut into chunks of about parallel_chunk_bytes. The chunk borders are placed on cache line
+//   borders, so two threads never write to the same cache line (false sharing) and the chunks never wrap around.
+// - Every chunk is a task for the pool. The pool steals work between threads so uneven chunks are fine.
+// Inside a chunk we work on a plain array, so the loops are as fast (and as vectorizable) as ordinary array loops.
+//
+// The function objects are called concurrently from several threads. They must not modify shared state
+// (abs_int, square_add_3 and the like from revision_2.hpp are fine).
+
+// About 64 KB of elements per task: large enough that handing out a task costs nothing in comparison,
+// small enough that there are plenty of them for the threads to share.
+constexpr std::size_t parallel_chunk_bytes = 64 * 1024;
+
+/// Chunks
+// A piece of one segment. offset is the logical index of its first element.
+template<typename T>
+struct parallel_chunk {
+    T*          first;
+    std::size_t count;
+    std::size_t offset;
+};
+
+template<typename T>
+std::vector<parallel_chunk<T>> make_parallel_chunks(const storage_segments<T>& s,
+                                                    std::size_t chunk_bytes = parallel_chunk_bytes)
+{
+    // Chunks are whole cache lines, if an element fits a cache line evenly. Other element sizes cannot line up
+    // with cache lines anyway, there we just cut every chunk_bytes.
+    constexpr bool line_sized = buffer_cache_line % sizeof(T) == 0;
+    constexpr std::size_t line = line_sized ? buffer_cache_line / sizeof(T) : 1;
+    std::size_t chunk = chunk_bytes / sizeof(T);
+    chunk = chunk < line ? line : chunk / line * line;
+
+    std::vector<parallel_chunk<T>> chunks;
+    chunks.reserve(s.size() / chunk + 4);
+    std::size_t offset = 0;
+    for (const array_segment<T>& segment : { s.one, s.two }) {
+        T* p = segment.data();
+        std::size_t left = segment.size();
+        // The first chunk of a segment ends on the first cache line border after a whole chunk,
+        // all later borders are cache line borders as well.
+        std::size_t n = chunk;
+        std::uintptr_t address = reinterpret_cast<std::uintptr_t>(p);
+        if (line_sized && address % sizeof(T) == 0) {
+            n -= (address % buffer_cache_line) / sizeof(T);
+        }
+        while (left != 0) {
+            if (n > left) {
+                n = left;
+            }
+            chunks.push_back({ p, n, offset });
+            p += n;
+            offset += n;
+            left -= n;
+            n = chunk;
+        }
+    }
+    return chunks;
+}
+
+
+/// The algorithms
+
+// Calls f(x) for every element x of c. f may modify the elements if c is not const.
+template<typename C, typename F>
+// requires (Buffer<C>{} || CircularBuffer<C>{}) && Callable<F, typename C::value_type&>{}
+void parallel_for_each(thread_pool& pool, C& c, F f)
+{
+    auto chunks = make_parallel_chunks(make_storage_segments(c));
+    pool.parallel_for(chunks.size(), [&](std::size_t k) {
+        auto chunk = chunks[k];
+        for (std::size_t i = 0; i != chunk.count; ++i) {
+            f(chunk.first[i]);
+        }
+    });
+}
+
+// out[i] = f(in_1[i], ..., in_n[i]) for every i. The chunks follow the storage of out (the container we write to),
+// the inputs may wrap around at different places. Then a chunk is done in (at most a few) contiguous runs.
+// Used by the parallel_transform overloads bellow.
+template<typename Out, typename F, typename... In>
+void parallel_transform_into(thread_pool& pool, Out& out, F f, const In&... in)
+// [[expects: all inputs have out.size() elements]]
+{
+    auto chunks = make_parallel_chunks(make_storage_segments(out));
+    auto inputs = std::make_tuple(make_storage_segments(in)...);
+    pool.parallel_for(chunks.size(), [&](std::size_t k) {
+        auto chunk = chunks[k];
+        std::size_t done = 0;
+        while (done != chunk.count) {
+            std::size_t run = chunk.count - done;
+            // Every input shortens run to what it has contiguously from this index on.
+            auto sources = std::apply([&](const auto&... s) {
+                return std::make_tuple(contiguous_run(s, chunk.offset + done, run)...);
+            }, inputs);
+            auto* destination = chunk.first + done;
+            std::apply([&](const auto*... p) {
+                for (std::size_t i = 0; i != run; ++i) {
+                    destination[i] = f(p[i]...);
+                }
+            }, sources);
+            done += run;
+        }
+    });
+}
+
+// The argument order is the one of std::transform. in and out may be the same container.
+template<typename In, typename Out, typename F>
+// requires Callable<F, typename In::value_type>{}
+void parallel_transform(thread_pool& pool, const In& in, Out& out, F f) // [[expects: in.size() == out.size()]]
+{
+    parallel_transform_into(pool, out, f, in);
+}
+
+template<typename In1, typename In2, typename Out, typename F>
+// requires Callable<F, typename In1::value_type, typename In2::value_type>{}
+void parallel_transform(thread_pool& pool, const In1& in1, const In2& in2, Out& out, F f)
+// [[expects: in1.size() == in2.size() == out.size()]]
+{
+    parallel_transform_into(pool, out, f, in1, in2);
+}
+
+// For function objects with three arguments, like square_add_3.
+template<typename In1, typename In2, typename In3, typename Out, typename F>
+// requires Callable<F, typename In1::value_type, typename In2::value_type, typename In3::value_type>{}
+void parallel_transform(thread_pool& pool, const In1& in1, const In2& in2, const In3& in3, Out& out, F f)
+// [[expects: in1.size() == in2.size() == in3.size() == out.size()]]
+{
+    parallel_transform_into(pool, out, f, in1, in2, in3);
+}
+
+// Combines init and the transformed elements of c with reduce, like std::transform_reduce. Every chunk is reduced
+// on its own, starting from its first transformed element, and the partial results are combined in order. So
+// reduce must be associative (like +, * or max) but need not be commutative, and it combines Ts with Ts only:
+// a partial result is as much a T as a transformed element. Something like a sequential fold of a T with an
+// element of another type cannot be split into chunks, that is what transform is for.
+// For floating point numbers the result may differ slightly from a sequential loop, since the additions
+// are grouped differently.
+template<typename C, typename T, typename Reduce, typename Transform>
+// requires SemiRegular<T>{} && Callable<Reduce, T, T>{} && Callable<Transform, typename C::value_type>{}
+T parallel_transform_reduce(thread_pool& pool, const C& c, T init, Reduce reduce, Transform transform)
+{
+    auto chunks = make_parallel_chunks(make_storage_segments(c));
+    std::vector<T> partial(chunks.size());
+    pool.parallel_for(chunks.size(), [&](std::size_t k) {
+        auto chunk = chunks[k];
+        T s = transform(chunk.first[0]);
+        for (std::size_t i = 1; i != chunk.count; ++i) {
+            s = reduce(s, transform(chunk.first[i]));
+        }
+        partial[k] = s;
+    });
+    for (const T& s : partial) {
+        init = reduce(init, s);
+    }
+    return init;
+}
+
+// Combines init and all elements of c with op, the elements converted to T first.
+template<typename C, typename T, typename Op>
+// requires SemiRegular<T>{} && Callable<Op, T, T>{} && ConvertibleTo<typename C::value_type, T>{}
+T parallel_reduce(thread_pool& pool, const C& c, T init, Op op)
+{
+    using value_type = typename C::value_type;
+    return parallel_transform_reduce(pool, c, init, op, [](const value_type& x) { return static_cast<T>(x); });
+}
+
+#endif // !PARALLEL_ALGORITHMS_GENERIC_PROGRAMMING
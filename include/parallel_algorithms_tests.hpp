@@ -0,0 +1,12 @@
+#ifndef PARALLEL_ALGORITHMS_TESTS_GENERIC_PROGRAMMING
+#define PARALLEL_ALGORITHMS_TESTS_GENERIC_PROGRAMMING
+
+#include "parallel_algorithms.hpp"
+
+bool test_parallel_algorithms();
+
+bool test_parallel_algorithms_wrap_around();
+
+void test_parallel_algorithms_performance();
+
+#endif // !PARALLEL_ALGORITHMS_TESTS_GENERIC_PROGRAMMING
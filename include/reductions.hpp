@@ -0,0 +1,462 @@
+#ifndef REDUCTIONS_GENERIC_PROGRAMMING
+#define REDUCTIONS_GENERIC_PROGRAMMING
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include "array_segment.hpp"
+#include "buffer_kernels.hpp"
+#include "storage_segments.hpp"
+
+/// Reductions
+// sum, dot, sum_of_squares, min, max and minmax over pointer ranges, array segments, buffers and circular buffers.
+//
+// The obvious loop "s += a[i]" is a single chain of dependent operations: every addition has to wait for the
+// previous one to finish. A floating point addition takes about 4 cycles but the CPU can start two of them
+// every cycle, so the obvious loop uses an eighth of what the hardware can do. Here we keep several independent
+// accumulators (each one its own chain) and add them together at the end.
+// For floating point numbers this changes the order of the additions and so the rounding of the result, which is
+// why the compiler does not do it by itself. For them we also use a whole SIMD register per accumulator.
+// Integer arithmetic does not care about the order, the compiler vectorizes the unrolled integer loops for us.
+//
+// Integers are summed in 64 bits, since a sum of millions of 32 bit numbers easily overflows 32 bits.
+// Other types (like color_rgba) only need T {} and +=. For min and max, < is enough (NaNs give unspecified results).
+
+template<typename T>
+using sum_type = typename std::conditional<std::is_integral<T>::value,
+                                           typename std::conditional<std::is_signed<T>::value,
+                                                                     std::int64_t, std::uint64_t>::type,
+                                           T>::type;
+
+// Four independent accumulators and plain operators. Works for any type with the operators used.
+template<typename T>
+struct generic_reduction_kernels {
+    using result_type = sum_type<T>;
+
+    static result_type sum(const T* a, std::size_t n)
+    {
+        result_type s0 {}, s1 {}, s2 {}, s3 {};
+        const std::size_t unrolled = n - n % 4;
+        std::size_t i = 0;
+        for (; i != unrolled; i += 4) {
+            s0 += a[i];
+            s1 += a[i + 1];
+            s2 += a[i + 2];
+            s3 += a[i + 3];
+        }
+        for (; i < n; ++i) {
+            s0 += a[i];
+        }
+        s0 += s1;
+        s2 += s3;
+        s0 += s2;
+        return s0;
+    }
+    static result_type dot(const T* a, const T* b, std::size_t n)
+    {
+        result_type s0 {}, s1 {}, s2 {}, s3 {};
+        const std::size_t unrolled = n - n % 4;
+        std::size_t i = 0;
+        for (; i != unrolled; i += 4) {
+            s0 += static_cast<result_type>(a[i]) * b[i];
+            s1 += static_cast<result_type>(a[i + 1]) * b[i + 1];
+            s2 += static_cast<result_type>(a[i + 2]) * b[i + 2];
+            s3 += static_cast<result_type>(a[i + 3]) * b[i + 3];
+        }
+        for (; i < n; ++i) {
+            s0 += static_cast<result_type>(a[i]) * b[i];
+        }
+        s0 += s1;
+        s2 += s3;
+        s0 += s2;
+        return s0;
+    }
+    static result_type sum_of_squares(const T* a, std::size_t n)
+    {
+        return dot(a, a, n);
+    }
+    static T min(const T* a, std::size_t n) // [[expects: n > 0]]
+    {
+        T m0 = a[0], m1 = a[0], m2 = a[0], m3 = a[0];
+        std::size_t i = 1;
+        for (; i + 4 <= n; i += 4) {
+            m0 = a[i] < m0 ? a[i] : m0;
+            m1 = a[i + 1] < m1 ? a[i + 1] : m1;
+            m2 = a[i + 2] < m2 ? a[i + 2] : m2;
+            m3 = a[i + 3] < m3 ? a[i + 3] : m3;
+        }
+        for (; i < n; ++i) {
+            m0 = a[i] < m0 ? a[i] : m0;
+        }
+        m0 = m1 < m0 ? m1 : m0;
+        m2 = m3 < m2 ? m3 : m2;
+        return m2 < m0 ? m2 : m0;
+    }
+    static T max(const T* a, std::size_t n) // [[expects: n > 0]]
+    {
+        T m0 = a[0], m1 = a[0], m2 = a[0], m3 = a[0];
+        std::size_t i = 1;
+        for (; i + 4 <= n; i += 4) {
+            m0 = m0 < a[i] ? a[i] : m0;
+            m1 = m1 < a[i + 1] ? a[i + 1] : m1;
+            m2 = m2 < a[i + 2] ? a[i + 2] : m2;
+            m3 = m3 < a[i + 3] ? a[i + 3] : m3;
+        }
+        for (; i < n; ++i) {
+            m0 = m0 < a[i] ? a[i] : m0;
+        }
+        m0 = m0 < m1 ? m1 : m0;
+        m2 = m2 < m3 ? m3 : m2;
+        return m0 < m2 ? m2 : m0;
+    }
+    // One pass instead of two: every element is loaded once.
+    static std::pair<T, T> minmax(const T* a, std::size_t n) // [[expects: n > 0]]
+    {
+        T lo0 = a[0], lo1 = a[0], hi0 = a[0], hi1 = a[0];
+        std::size_t i = 1;
+        for (; i + 2 <= n; i += 2) {
+            lo0 = a[i] < lo0 ? a[i] : lo0;
+            hi0 = hi0 < a[i] ? a[i] : hi0;
+            lo1 = a[i + 1] < lo1 ? a[i + 1] : lo1;
+            hi1 = hi1 < a[i + 1] ? a[i + 1] : hi1;
+        }
+        for (; i < n; ++i) {
+            lo0 = a[i] < lo0 ? a[i] : lo0;
+            hi0 = hi0 < a[i] ? a[i] : hi0;
+        }
+        return { lo1 < lo0 ? lo1 : lo0, hi0 < hi1 ? hi1 : hi0 };
+    }
+};
+
+template<typename T>
+struct reduction_kernels : generic_reduction_kernels<T> {};
+
+#ifdef BUFFER_KERNELS_SSE2
+
+namespace buffer_simd {
+
+// Combines the lanes of a register with op.
+template<typename V, typename Op>
+typename V::value_type horizontal(typename V::type v, Op op)
+{
+    using T = typename V::value_type;
+    T lanes[V::width];
+    V::store(lanes, v);
+    T r = lanes[0];
+    for (int k = 1; k != V::width; ++k) {
+        r = op(r, lanes[k]);
+    }
+    return r;
+}
+
+// Four registers of V as accumulators, then single registers, then the rest one by one.
+template<typename V>
+struct simd_reduction_kernels {
+    using T = typename V::value_type;
+    using R = typename V::type;
+    using result_type = T;
+    static constexpr std::size_t W = V::width;
+
+    static T sum(const T* a, std::size_t n)
+    {
+        R s0 = V::zero(), s1 = V::zero(), s2 = V::zero(), s3 = V::zero();
+        std::size_t i = 0;
+        for (; i + 4 * W <= n; i += 4 * W) {
+            s0 = V::add(s0, V::load(a + i));
+            s1 = V::add(s1, V::load(a + i + W));
+            s2 = V::add(s2, V::load(a + i + 2 * W));
+            s3 = V::add(s3, V::load(a + i + 3 * W));
+        }
+        for (; i + W <= n; i += W) {
+            s0 = V::add(s0, V::load(a + i));
+        }
+        T s = horizontal<V>(V::add(V::add(s0, s1), V::add(s2, s3)), [](T x, T y) { return x + y; });
+        for (; i < n; ++i) {
+            s += a[i];
+        }
+        return s;
+    }
+    static T dot(const T* a, const T* b, std::size_t n)
+    {
+        R s0 = V::zero(), s1 = V::zero(), s2 = V::zero(), s3 = V::zero();
+        std::size_t i = 0;
+        for (; i + 4 * W <= n; i += 4 * W) {
+            s0 = V::fma(s0, V::load(a + i), V::load(b + i));
+            s1 = V::fma(s1, V::load(a + i + W), V::load(b + i + W));
+            s2 = V::fma(s2, V::load(a + i + 2 * W), V::load(b + i + 2 * W));
+            s3 = V::fma(s3, V::load(a + i + 3 * W), V::load(b + i + 3 * W));
+        }
+        for (; i + W <= n; i += W) {
+            s0 = V::fma(s0, V::load(a + i), V::load(b + i));
+        }
+        T s = horizontal<V>(V::add(V::add(s0, s1), V::add(s2, s3)), [](T x, T y) { return x + y; });
+        for (; i < n; ++i) {
+            s += a[i] * b[i];
+        }
+        return s;
+    }
+    static T sum_of_squares(const T* a, std::size_t n)
+    {
+        return dot(a, a, n);
+    }
+    static T min(const T* a, std::size_t n) // [[expects: n > 0]]
+    {
+        R m0 = V::set1(a[0]), m1 = m0, m2 = m0, m3 = m0;
+        std::size_t i = 0;
+        for (; i + 4 * W <= n; i += 4 * W) {
+            m0 = V::min(m0, V::load(a + i));
+            m1 = V::min(m1, V::load(a + i + W));
+            m2 = V::min(m2, V::load(a + i + 2 * W));
+            m3 = V::min(m3, V::load(a + i + 3 * W));
+        }
+        for (; i + W <= n; i += W) {
+            m0 = V::min(m0, V::load(a + i));
+        }
+        T m = horizontal<V>(V::min(V::min(m0, m1), V::min(m2, m3)), [](T x, T y) { return y < x ? y : x; });
+        for (; i < n; ++i) {
+            m = a[i] < m ? a[i] : m;
+        }
+        return m;
+    }
+    static T max(const T* a, std::size_t n) // [[expects: n > 0]]
+    {
+        R m0 = V::set1(a[0]), m1 = m0, m2 = m0, m3 = m0;
+        std::size_t i = 0;
+        for (; i + 4 * W <= n; i += 4 * W) {
+            m0 = V::max(m0, V::load(a + i));
+            m1 = V::max(m1, V::load(a + i + W));
+            m2 = V::max(m2, V::load(a + i + 2 * W));
+            m3 = V::max(m3, V::load(a + i + 3 * W));
+        }
+        for (; i + W <= n; i += W) {
+            m0 = V::max(m0, V::load(a + i));
+        }
+        T m = horizontal<V>(V::max(V::max(m0, m1), V::max(m2, m3)), [](T x, T y) { return x < y ? y : x; });
+        for (; i < n; ++i) {
+            m = m < a[i] ? a[i] : m;
+        }
+        return m;
+    }
+    static std::pair<T, T> minmax(const T* a, std::size_t n) // [[expects: n > 0]]
+    {
+        R lo0 = V::set1(a[0]), lo1 = lo0, hi0 = lo0, hi1 = lo0;
+        std::size_t i = 0;
+        for (; i + 2 * W <= n; i += 2 * W) {
+            R x = V::load(a + i);
+            R y = V::load(a + i + W);
+            lo0 = V::min(lo0, x);
+            hi0 = V::max(hi0, x);
+            lo1 = V::min(lo1, y);
+            hi1 = V::max(hi1, y);
+        }
+        T lo = horizontal<V>(V::min(lo0, lo1), [](T x, T y) { return y < x ? y : x; });
+        T hi = horizontal<V>(V::max(hi0, hi1), [](T x, T y) { return x < y ? y : x; });
+        for (; i < n; ++i) {
+            lo = a[i] < lo ? a[i] : lo;
+            hi = hi < a[i] ? a[i] : hi;
+        }
+        return { lo, hi };
+    }
+};
+
+} // namespace buffer_simd
+
+template<>
+struct reduction_kernels<float> : buffer_simd::simd_reduction_kernels<buffer_simd::f32_wide> {};
+
+template<>
+struct reduction_kernels<double> : buffer_simd::simd_reduction_kernels<buffer_simd::f64_wide> {};
+
+#endif // BUFFER_KERNELS_SSE2
+
+
+/// Pointer ranges
+
+template<typename T>
+sum_type<T> sum(const T* a, std::size_t n)
+{
+    return reduction_kernels<T>::sum(a, n);
+}
+
+template<typename T>
+sum_type<T> dot(const T* a, const T* b, std::size_t n)
+{
+    return reduction_kernels<T>::dot(a, b, n);
+}
+
+template<typename T>
+sum_type<T> sum_of_squares(const T* a, std::size_t n)
+{
+    return reduction_kernels<T>::sum_of_squares(a, n);
+}
+
+template<typename T>
+T min(const T* a, std::size_t n) // [[expects: n > 0]]
+{
+    return reduction_kernels<T>::min(a, n);
+}
+
+template<typename T>
+T max(const T* a, std::size_t n) // [[expects: n > 0]]
+{
+    return reduction_kernels<T>::max(a, n);
+}
+
+template<typename T>
+std::pair<T, T> minmax(const T* a, std::size_t n) // [[expects: n > 0]]
+{
+    return reduction_kernels<T>::minmax(a, n);
+}
+
+
+/// Array segments
+// T may be const (the segments of a const container), the results are always of the plain element type.
+
+template<typename T>
+sum_type<std::remove_const_t<T>> sum(array_segment<T> s)
+{
+    return sum(s.data(), s.size());
+}
+
+template<typename T>
+sum_type<std::remove_const_t<T>> dot(array_segment<T> x, array_segment<T> y) // [[expects: x.size() == y.size()]]
+{
+    return dot(x.data(), y.data(), x.size());
+}
+
+template<typename T>
+sum_type<std::remove_const_t<T>> sum_of_squares(array_segment<T> s)
+{
+    return sum_of_squares(s.data(), s.size());
+}
+
+template<typename T>
+std::remove_const_t<T> min(array_segment<T> s) // [[expects: !s.empty()]]
+{
+    return min(s.data(), s.size());
+}
+
+template<typename T>
+std::remove_const_t<T> max(array_segment<T> s) // [[expects: !s.empty()]]
+{
+    return max(s.data(), s.size());
+}
+
+template<typename T>
+std::pair<std::remove_const_t<T>, std::remove_const_t<T>> minmax(array_segment<T> s) // [[expects: !s.empty()]]
+{
+    return minmax(s.data(), s.size());
+}
+
+
+/// Containers
+// Anything make_storage_segments knows about (buffer and circular_buffer, see storage_segments.hpp).
+// The segments are reduced one after the other and the two results combined.
+
+template<typename T>
+sum_type<std::remove_const_t<T>> sum(const storage_segments<T>& s)
+{
+    sum_type<std::remove_const_t<T>> r = sum(s.one);
+    r += sum(s.two);
+    return r;
+}
+
+template<typename T>
+sum_type<std::remove_const_t<T>> sum_of_squares(const storage_segments<T>& s)
+{
+    sum_type<std::remove_const_t<T>> r = sum_of_squares(s.one);
+    r += sum_of_squares(s.two);
+    return r;
+}
+
+// The two containers may wrap around at different places, so we go through the runs they have in common.
+template<typename T>
+sum_type<std::remove_const_t<T>> dot(const storage_segments<T>& x, const storage_segments<T>& y)
+// [[expects: x.size() == y.size()]]
+{
+    sum_type<std::remove_const_t<T>> r {};
+    for (std::size_t i = 0; i != x.size();) {
+        std::size_t run = x.size() - i;
+        T* p = contiguous_run(x, i, run);
+        T* q = contiguous_run(y, i, run);
+        r += dot(p, q, run);
+        i += run;
+    }
+    return r;
+}
+
+template<typename T>
+std::remove_const_t<T> min(const storage_segments<T>& s) // [[expects: s.size() > 0]]
+{
+    std::remove_const_t<T> m = min(s.one);
+    if (!s.two.empty()) {
+        std::remove_const_t<T> m2 = min(s.two);
+        m = m2 < m ? m2 : m;
+    }
+    return m;
+}
+
+template<typename T>
+std::remove_const_t<T> max(const storage_segments<T>& s) // [[expects: s.size() > 0]]
+{
+    std::remove_const_t<T> m = max(s.one);
+    if (!s.two.empty()) {
+        std::remove_const_t<T> m2 = max(s.two);
+        m = m < m2 ? m2 : m;
+    }
+    return m;
+}
+
+template<typename T>
+std::pair<std::remove_const_t<T>, std::remove_const_t<T>> minmax(const storage_segments<T>& s)
+// [[expects: s.size() > 0]]
+{
+    auto m = minmax(s.one);
+    if (!s.two.empty()) {
+        auto m2 = minmax(s.two);
+        m.first = m2.first < m.first ? m2.first : m.first;
+        m.second = m.second < m2.second ? m2.second : m.second;
+    }
+    return m;
+}
+
+// The containers themselves. The default template argument takes these overloads out of the running
+// (SFINAE) for types make_storage_segments does not know.
+template<typename C, typename = decltype(make_storage_segments(std::declval<const C&>()))>
+sum_type<typename C::value_type> sum(const C& c)
+{
+    return sum(make_storage_segments(c));
+}
+
+template<typename C, typename = decltype(make_storage_segments(std::declval<const C&>()))>
+sum_type<typename C::value_type> dot(const C& x, const C& y) // [[expects: x.size() == y.size()]]
+{
+    return dot(make_storage_segments(x), make_storage_segments(y));
+}
+
+template<typename C, typename = decltype(make_storage_segments(std::declval<const C&>()))>
+sum_type<typename C::value_type> sum_of_squares(const C& c)
+{
+    return sum_of_squares(make_storage_segments(c));
+}
+
+template<typename C, typename = decltype(make_storage_segments(std::declval<const C&>()))>
+typename C::value_type min(const C& c) // [[expects: c.size() > 0]]
+{
+    return min(make_storage_segments(c));
+}
+
+template<typename C, typename = decltype(make_storage_segments(std::declval<const C&>()))>
+typename C::value_type max(const C& c) // [[expects: c.size() > 0]]
+{
+    return max(make_storage_segments(c));
+}
+
+template<typename C, typename = decltype(make_storage_segments(std::declval<const C&>()))>
+std::pair<typename C::value_type, typename C::value_type> minmax(const C& c) // [[expects: c.size() > 0]]
+{
+    return minmax(make_storage_segments(c));
+}
+
+#endif // !REDUCTIONS_GENERIC_PROGRAMMING
@@ -0,0 +1,12 @@
+#ifndef REDUCTIONS_TESTS_GENERIC_PROGRAMMING
+#define REDUCTIONS_TESTS_GENERIC_PROGRAMMING
+
+#include "reductions.hpp"
+
+bool test_reductions();
+
+bool test_reductions_containers();
+
+void test_reductions_performance();
+
+#endif // !REDUCTIONS_TESTS_GENERIC_PROGRAMMING
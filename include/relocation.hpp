@@ -0,0 +1,45 @@
+#ifndef RELOCATION_GENERIC_PROGRAMMING
+#define RELOCATION_GENERIC_PROGRAMMING
+
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+/// Trivial relocation
+// Moving an object to a new address and destroying the old one is called relocating it. For most types,
+// relocating is the same as copying the bytes of the object and forgetting the old ones: a std::unique_ptr or a
+// struct holding one is just a pointer, wherever it lives. Those types are trivially relocatable, even though
+// they are not trivially copyable (copying the bytes and keeping both objects would free the memory twice).
+// Not every type is like this: an object which points into itself (std::string with its short string buffer,
+// in some standard libraries) breaks when its bytes are moved. The compiler cannot tell the difference, so types
+// opt in by specializing the trait:
+//     template<>
+//     struct is_trivially_relocatable<my_handle> : std::true_type {};
+// Trivially copyable types are trivially relocatable already.
+template<typename T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+
+// Exchanges the bytes of the objects in [a, a + n) and [b, b + n), which must not overlap. For a trivially
+// relocatable type this swaps the objects (a swap is three relocations), with bulk copies instead of n calls
+// to swap. The bytes go through a small block on the stack.
+template<typename T>
+// requires TriviallyRelocatable<T>{}
+void swap_object_bytes(T* a, T* b, std::size_t n)
+{
+    static_assert(is_trivially_relocatable<T>::value, "only trivially relocatable objects can be swapped as bytes");
+    unsigned char block[4096];
+    unsigned char* x = reinterpret_cast<unsigned char*>(a);
+    unsigned char* y = reinterpret_cast<unsigned char*>(b);
+    std::size_t bytes = n * sizeof(T);
+    while (bytes != 0) {
+        std::size_t k = bytes < sizeof block ? bytes : sizeof block;
+        std::memcpy(block, x, k);
+        std::memcpy(x, y, k);
+        std::memcpy(y, block, k);
+        x += k;
+        y += k;
+        bytes -= k;
+    }
+}
+
+#endif // !RELOCATION_GENERIC_PROGRAMMING
@@ -4,9 +4,47 @@
 #include <string>
 #include <cctype>
 #include <iostream>
+#include <type_traits>
 
 using namespace std;
 
+/// Callable objects in C++
+// 1) Free Functions
+// 2) Member functions
+// 3) Classes/structs overloading the () operator
+
+// Defining a function object is very simple. We just need to overload the function call
+// operator, also known as (). Here are several examples:
+// A simple function object imitating a function.
+struct abs_int {
+    int operator()(int a) const
+    {
+        return a < 0 ? -a : a;
+    }
+};
+
+// A function object can be useful when you need to store some state. 
+// Store a number at construction and then use that number to compare
+// integers passed to it later.
+struct less_than_n {
+    int n;
+    less_than_n(int m) : n{m} {}
+    bool operator()(int a) const
+    {
+        return a < n;
+    }
+};
+
+// Unlike the other ordinary operators, the function call operator can take in an arbitrary
+// number of operators.
+// Square three numbers and add them together.
+struct square_add_3 {
+    int operator()(int a, int b, int c) const
+    {
+        return (a*a + b*b + c*c);
+    }
+};
+
 // Test functions
 
 void test_function_objects();
@@ -40,8 +78,53 @@ int compare(const T& x, const T& y)     // (see presentation for definition of c
 // Once again, the types we use in the template clause are valid for the entire class/struct body.
 // Note that we can have as many parameterized types as we want. 
 // This is an example of an object holding two objects of arbitrary types
+
+// Every object takes at least one byte, even an object of an empty type (a struct without data members), so a pair
+// with an empty member would waste a byte plus the padding after it: simple_pair<int, empty_element> would
+// take 8 bytes instead of 4. The old trick to avoid this is the empty base optimization (an empty base class takes
+// no room) which forces us to give up the first and second members. C++20 has an attribute for members doing the
+// same thing, [[no_unique_address]], which GCC and Clang already honor in C++17 (and MSVC under its own name).
+// We put it only on empty members. On a non empty one it would let the other member move into its padding,
+// and then copying sizeof(T) bytes into first would overwrite second.
+#if defined(_MSC_VER)
+#define NO_UNIQUE_ADDRESS [[msvc::no_unique_address]]
+#elif defined(__has_cpp_attribute)
+#if __has_cpp_attribute(no_unique_address)
+#define NO_UNIQUE_ADDRESS [[no_unique_address]]
+#endif
+#endif
+#ifndef NO_UNIQUE_ADDRESS
+#define NO_UNIQUE_ADDRESS
+#endif
+
+template<typename T, typename U, bool = std::is_empty<T>::value, bool = std::is_empty<U>::value>
+struct simple_pair_storage {
+    T first;
+    U second;
+};
+
+template<typename T, typename U>
+struct simple_pair_storage<T, U, true, false> {
+    NO_UNIQUE_ADDRESS T first;
+    U second;
+};
+
 template<typename T, typename U>
-struct simple_pair {
+struct simple_pair_storage<T, U, false, true> {
+    T first;
+    NO_UNIQUE_ADDRESS U second;
+};
+
+template<typename T, typename U>
+struct simple_pair_storage<T, U, true, true> {
+    NO_UNIQUE_ADDRESS T first;
+    NO_UNIQUE_ADDRESS U second;
+};
+
+// The members come from the storage base. simple_pair is still an aggregate: simple_pair<int, double> p { 1, 2.0 }
+// initializes the members of the base (the braces around them can be left out).
+template<typename T, typename U>
+struct simple_pair : simple_pair_storage<T, U> {
     // This is a called type alias or an associated type. We can use the scope resolution operator (::) to access this
     // type alias for any simple_pair object. See the test_simple_pair function in revision_2.cpp for an example
     // if how to use it. Type aliases are essentially type functions - they take in some type T and give you
@@ -51,9 +134,6 @@ struct simple_pair {
     // it has different syntax.
     using first_type = T;
     using second_type = U;
-
-    T first;
-    U second;
 };
 
 void test_pair();
@@ -6,5 +6,23 @@ void test_buffer();
 void revision_test_2();
 void revision_test();
 
+bool test_color_kernels();
+void test_color_kernels_performance();
+
+bool test_buffer_expressions();
+void test_buffer_expressions_performance();
+
+bool test_buffer_kernels();
+void test_buffer_kernels_performance();
+
+bool test_heap_buffer();
+void test_heap_buffer_performance();
+
+bool test_buffer_construction();
+void test_buffer_copy_performance();
+
+bool test_singleton_operators();
+void test_singleton_performance();
+
 #endif // !REVISION_TESTS_GENERIC_PROGRAMMING
 
@@ -0,0 +1,73 @@
+#ifndef RING_MEMORY_GENERIC_PROGRAMMING
+#define RING_MEMORY_GENERIC_PROGRAMMING
+
+#include <cstddef>
+
+/// Huge pages and NUMA placement for big rings
+// The processor translates every address through the page tables, and keeps the translations it used last in
+// the TLB: a couple of thousand entries, one per page. With 4 KB pages that covers a few megabytes, so random
+// accesses into a ring of gigabytes nearly all miss the TLB and walk the page tables first (which are themselves
+// too big for the caches). With 2 MB pages the same TLB covers gigabytes, and a walk is one level shorter.
+// Linux gives huge pages in two ways:
+//     explicit     mmap with MAP_HUGETLB takes them from a pool the administrator reserved up front
+//                  (vm.nr_hugepages). Guaranteed huge, but fails if the pool is too small.
+//     transparent  madvise(MADV_HUGEPAGE) asks the kernel to back ordinary memory with huge pages whenever it
+//                  can find 2 MB of contiguous physical memory. Nothing to set up, but nothing guaranteed.
+// We try what was asked for and fall back to the next best thing: explicit, then transparent, then normal pages.
+//
+// On a machine with several sockets each has its own memory, and reaching the memory of the other socket is
+// slower. By default a page lands on the node of the thread that first writes to it (first touch), which for a
+// ring is whichever thread happens to push first. The placement option sets a policy on the memory instead:
+//     local        the node of the thread touching it (the default policy, made explicit),
+//     interleave   pages spread over all nodes in turn, for rings every socket uses equally,
+//     bind         all pages on the given node.
+// A policy only applies to pages which are not there yet, so prefault touches every page right after setting it,
+// while the constructing thread is the one touching them. That also takes the page faults (and the zeroing of
+// the pages) out of the first pass over the ring. If the policy cannot be set (a kernel without NUMA support,
+// a node which does not exist) the memory is used as it is.
+//
+// The memory comes from mmap on POSIX systems (the placement only on Linux), from operator new elsewhere.
+
+enum class page_kind { normal, transparent_huge, explicit_huge };
+enum class numa_placement { any, local, interleave, bind };
+
+const char* to_string(page_kind k);
+
+struct ring_memory_options {
+    page_kind pages = page_kind::normal;
+    numa_placement placement = numa_placement::any;
+    // The node for numa_placement::bind.
+    int node = 0;
+    // Touch every page when allocating.
+    bool prefault = false;
+
+    // With the defaults containers just use new[].
+    bool is_default() const
+    {
+        return pages == page_kind::normal && placement == numa_placement::any && !prefault;
+    }
+};
+
+// Memory we got from allocate_ring_memory, and what it ended up being.
+struct ring_memory_block {
+    void* data = nullptr;
+    // The bytes mapped, a whole number of pages.
+    std::size_t length = 0;
+    // What backs it: an explicit_huge request may get transparent_huge or normal pages.
+    page_kind pages = page_kind::normal;
+    // Whether the placement policy was applied.
+    bool placed = false;
+};
+
+// What a container keeps to allocate with the options again (when it grows or is copied) and to free the
+// memory. Behind a pointer, so that containers which do not use options only pay for a null pointer.
+struct ring_memory {
+    ring_memory_options options;
+    ring_memory_block block;
+};
+
+// At least bytes of zeroed memory, aligned to a page. Throws std::bad_alloc if there is no memory at all.
+ring_memory_block allocate_ring_memory(std::size_t bytes, const ring_memory_options& options);
+void free_ring_memory(const ring_memory_block& block);
+
+#endif // !RING_MEMORY_GENERIC_PROGRAMMING
@@ -0,0 +1,10 @@
+#ifndef RING_MEMORY_TESTS_GENERIC_PROGRAMMING
+#define RING_MEMORY_TESTS_GENERIC_PROGRAMMING
+
+#include "ring_memory.hpp"
+
+bool test_ring_memory();
+
+void test_ring_memory_performance();
+
+#endif // !RING_MEMORY_TESTS_GENERIC_PROGRAMMING
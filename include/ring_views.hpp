@@ -0,0 +1,306 @@
+#ifndef RING_VIEWS_GENERIC_PROGRAMMING
+#define RING_VIEWS_GENERIC_PROGRAMMING
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include "circular_buffer.hpp"
+#include "storage_segments.hpp"
+
+/// Lazy views over circular buffers
+// Filtering a ring, transforming what is left and keeping the result is three loops if every step builds a new
+// circular_buffer: three allocations, and every element is written to memory and read back between the steps.
+// A view instead only remembers what is to be done. Views are combined with |, like commands in a shell:
+//     auto v = cb | take_last(1000) | filter(less_than_n { 0 }) | transform(abs_int {});
+// builds a description of the pipeline and allocates nothing. Only when we ask for the elements
+// (for_each, reduce, count, collect) does it run, as a single pass: every element of the ring goes through all
+// of the steps, one after the other, while it is in a register. The ring itself is walked as its two physical
+// segments, so the innermost loops are loops over plain arrays.
+//
+// The elements are pushed through the pipeline (each view calls the next step for every element it produces)
+// instead of being pulled by iterators. A filter would need an iterator that skips ahead on every ++ and checks
+// for the end, a loop over two segments needs to check for the jump between them; pushing needs neither.
+//
+// The steps:
+//     filter(p)       the elements x for which p(x) is true.
+//     transform(f)    f(x) for every element x.
+//     take_last(n)    the newest n elements of the ring (all of them if there are fewer).
+//     window(k)       every run of k consecutive elements, oldest first, as storage_segments<const T>.
+//                     The functions in reductions.hpp accept them: cb | window(8) | transform(sum_of_window).
+// take_last and window pick positions in the ring, so they come first, straight after the ring
+// (take_last can be followed by window). filter and transform can follow anything.
+//
+// A view points into the ring: the ring must outlive it and must not change while the view is used.
+
+// Views derive from ring_view_base, so that | only applies to them.
+struct ring_view_base {};
+
+template<typename V>
+using is_ring_view = std::is_base_of<ring_view_base, V>;
+
+
+/// Sources
+
+// The elements of a ring (or of a part of it), in order.
+template<typename T>
+class segments_view : public ring_view_base {
+public:
+    using value_type = T;
+
+    explicit segments_view(storage_segments<const T> s)
+        : segments_(s)
+    {}
+
+    const storage_segments<const T>& segments() const
+    {
+        return segments_;
+    }
+    // The most elements the view can produce.
+    std::size_t size_bound() const
+    {
+        return segments_.size();
+    }
+
+    template<typename F>
+    void for_each(F&& f) const
+    {
+        for (const T& x : segments_.one) {
+            f(x);
+        }
+        for (const T& x : segments_.two) {
+            f(x);
+        }
+    }
+
+private:
+    storage_segments<const T> segments_;
+};
+
+// Every run of k consecutive elements. A run which straddles the end of the underlying array
+// is in two segments, like the ring itself.
+template<typename T>
+class window_view : public ring_view_base {
+public:
+    using value_type = storage_segments<const T>;
+
+    window_view(storage_segments<const T> s, std::size_t k) // [[expects: k > 0]]
+        : segments_(s), k_(k)
+    {}
+
+    std::size_t size_bound() const
+    {
+        return segments_.size() < k_ ? 0 : segments_.size() - k_ + 1;
+    }
+
+    template<typename F>
+    void for_each(F&& f) const
+    {
+        std::size_t n = size_bound();
+        for (std::size_t i = 0; i != n; ++i) {
+            f(subsegments(segments_, i, k_));
+        }
+    }
+
+private:
+    storage_segments<const T> segments_;
+    std::size_t k_;
+};
+
+
+/// Steps
+
+template<typename V, typename P>
+class filter_view : public ring_view_base {
+public:
+    using value_type = typename V::value_type;
+
+    filter_view(V base, P p)
+        : base_(std::move(base)), p_(std::move(p))
+    {}
+
+    std::size_t size_bound() const
+    {
+        return base_.size_bound();
+    }
+
+    template<typename F>
+    void for_each(F&& f) const
+    {
+        base_.for_each([&](const value_type& x) {
+            if (p_(x)) {
+                f(x);
+            }
+        });
+    }
+
+private:
+    V base_;
+    P p_;
+};
+
+template<typename V, typename Op>
+class transform_view : public ring_view_base {
+public:
+    using value_type = std::decay_t<decltype(std::declval<const Op&>()(std::declval<const typename V::value_type&>()))>;
+
+    transform_view(V base, Op op)
+        : base_(std::move(base)), op_(std::move(op))
+    {}
+
+    std::size_t size_bound() const
+    {
+        return base_.size_bound();
+    }
+
+    template<typename F>
+    void for_each(F&& f) const
+    {
+        base_.for_each([&](const typename V::value_type& x) {
+            f(op_(x));
+        });
+    }
+
+private:
+    V base_;
+    Op op_;
+};
+
+
+/// Adaptors and pipes
+// filter(p) and friends only store their argument. | combines them with the view on the left.
+
+template<typename P>
+struct filter_adaptor {
+    P p;
+};
+
+template<typename Op>
+struct transform_adaptor {
+    Op op;
+};
+
+struct take_last_adaptor {
+    std::size_t n;
+};
+
+struct window_adaptor {
+    std::size_t k;
+};
+
+template<typename P>
+// requires Predicate<P>{}
+filter_adaptor<P> filter(P p)
+{
+    return { std::move(p) };
+}
+
+template<typename Op>
+// requires RegularFunction<Op>{}
+transform_adaptor<Op> transform(Op op)
+{
+    return { std::move(op) };
+}
+
+inline take_last_adaptor take_last(std::size_t n)
+{
+    return { n };
+}
+
+inline window_adaptor window(std::size_t k) // [[expects: k > 0]]
+{
+    return { k };
+}
+
+// A ring starts a pipeline as the view of all of its elements.
+template<typename T>
+segments_view<T> all(const circular_buffer<T>& cb)
+{
+    return segments_view<T>(make_storage_segments(cb));
+}
+
+template<typename T, typename A>
+auto operator|(const circular_buffer<T>& cb, A adaptor) -> decltype(all(cb) | adaptor)
+{
+    return all(cb) | adaptor;
+}
+
+// The view would point into a temporary which is gone by the end of the statement.
+template<typename T, typename A>
+void operator|(const circular_buffer<T>&& cb, A adaptor) = delete;
+
+template<typename V, typename P, typename = std::enable_if_t<is_ring_view<V>::value>>
+filter_view<V, P> operator|(V v, filter_adaptor<P> a)
+{
+    return { std::move(v), std::move(a.p) };
+}
+
+template<typename V, typename Op, typename = std::enable_if_t<is_ring_view<V>::value>>
+transform_view<V, Op> operator|(V v, transform_adaptor<Op> a)
+{
+    return { std::move(v), std::move(a.op) };
+}
+
+template<typename T>
+segments_view<T> operator|(const segments_view<T>& v, take_last_adaptor a)
+{
+    std::size_t size = v.segments().size();
+    std::size_t n = a.n < size ? a.n : size;
+    return segments_view<T>(subsegments(v.segments(), size - n, n));
+}
+
+template<typename T>
+window_view<T> operator|(const segments_view<T>& v, window_adaptor a)
+{
+    return window_view<T>(v.segments(), a.k);
+}
+
+
+/// Running a view
+// These are the only places where the pipeline actually runs.
+
+template<typename V, typename F, typename = std::enable_if_t<is_ring_view<V>::value>>
+void for_each(const V& v, F f)
+{
+    v.for_each(f);
+}
+
+template<typename V, typename T, typename Op, typename = std::enable_if_t<is_ring_view<V>::value>>
+T reduce(const V& v, T init, Op op)
+{
+    v.for_each([&](const typename V::value_type& x) {
+        init = op(init, x);
+    });
+    return init;
+}
+
+template<typename V, typename = std::enable_if_t<is_ring_view<V>::value>>
+std::size_t count(const V& v)
+{
+    std::size_t n = 0;
+    v.for_each([&](const typename V::value_type&) {
+        ++n;
+    });
+    return n;
+}
+
+// Appends the elements to out, with the usual semantics of push_back (the oldest elements of out are
+// overwritten once it is full). Nothing is allocated.
+template<typename V, typename U, typename = std::enable_if_t<is_ring_view<V>::value>>
+void collect(const V& v, circular_buffer<U>& out)
+{
+    v.for_each([&](const typename V::value_type& x) {
+        out.push_back(x);
+    });
+}
+
+// A new ring with the elements. Its capacity is the most the view can produce (the size of its source),
+// which is more than needed after a filter, but it saves a second pass to count the elements first.
+template<typename V, typename = std::enable_if_t<is_ring_view<V>::value>>
+circular_buffer<typename V::value_type> collect(const V& v)
+{
+    circular_buffer<typename V::value_type> out(v.size_bound());
+    collect(v, out);
+    return out;
+}
+
+#endif // !RING_VIEWS_GENERIC_PROGRAMMING
@@ -0,0 +1,12 @@
+#ifndef RING_VIEWS_TESTS_GENERIC_PROGRAMMING
+#define RING_VIEWS_TESTS_GENERIC_PROGRAMMING
+
+#include "ring_views.hpp"
+
+bool test_ring_views();
+
+bool test_ring_views_take_last_and_window();
+
+void test_ring_views_performance();
+
+#endif // !RING_VIEWS_TESTS_GENERIC_PROGRAMMING
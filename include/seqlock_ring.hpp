@@ -0,0 +1,166 @@
+#ifndef SEQLOCK_RING_GENERIC_PROGRAMMING
+#define SEQLOCK_RING_GENERIC_PROGRAMMING
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include "circular_buffer.hpp"
+
+/// Single writer ring with lock free snapshots
+// One thread pushes into the ring as fast as it can, other threads now and then want a consistent copy of the
+// newest elements (to show them, to compute statistics...). With a mutex, every snapshot stops the writer for
+// as long as the copy takes, and the writer pays for the lock on every push even when nobody reads.
+//
+// seqlock_ring uses a sequence lock instead. A single counter, seq, is even while the ring is at rest and odd
+// while a push is under way; seq / 2 is the number of finished pushes. The writer never waits for anybody: it
+// makes seq odd, writes the slot and makes seq even again. A reader notes seq, copies the elements it wants, then
+// looks at seq again: if the writer got around to overwriting any slot it copied in the meantime the copy may be
+// torn, so it throws it away and tries again. Readers never write anything shared, so any number of them can read
+// at once without slowing the writer down (other than by sharing the cache lines).
+//
+// The elements are copied while the writer may be writing them, which is a data race (undefined behavior) for
+// ordinary memory even if we throw the result away. So the slots are arrays of atomic words accessed with relaxed
+// loads and stores, which compile to the same plain moves but are allowed to race.
+// The elements must therefore be trivially copyable.
+//
+// A snapshot of n elements only succeeds if the writer does not push capacity() - n elements while it is being
+// taken, so the capacity should be comfortably larger than the snapshots.
+
+// The widest word that divides the size of T, to copy T with as few atomic operations as possible. The alignment
+// of T does not matter: an element goes through a local array of words with memcpy, and the slots are atomic
+// words, aligned as words.
+template<typename T>
+using seqlock_word = std::conditional_t<sizeof(T) % 8 == 0, std::uint64_t,
+                     std::conditional_t<sizeof(T) % 4 == 0, std::uint32_t,
+                     std::conditional_t<sizeof(T) % 2 == 0, std::uint16_t, std::uint8_t>>>;
+
+template<typename T>
+// requires SemiRegular<T>{} && TriviallyCopyable<T>{}
+class seqlock_ring {
+    static_assert(std::is_trivially_copyable<T>::value, "seqlock_ring copies its elements as raw words");
+
+    using word = seqlock_word<T>;
+    static constexpr std::size_t words_per_element = sizeof(T) / sizeof(word);
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+
+    // The capacity is rounded up to a power of two, so that finding a slot is a mask instead of a division.
+    explicit seqlock_ring(size_type capacity) // [[expects: capacity > 0]]
+        : mask_(std::bit_ceil(capacity) - 1),
+          words_(new std::atomic<word>[(mask_ + 1) * words_per_element]()),
+          seq_(0), pushes_(0)
+    {}
+
+    seqlock_ring(const seqlock_ring&) = delete;
+    seqlock_ring& operator=(const seqlock_ring&) = delete;
+
+    size_type capacity() const
+    {
+        return mask_ + 1;
+    }
+
+    /// Writer side
+    // Only one thread may push.
+    void push_back(const T& x)
+    {
+        std::uint64_t k = pushes_;
+        seq_.store(2 * k + 1, std::memory_order_relaxed);
+        // Anyone who sees the new slot contents must also see seq odd (or later): then the check in try_snapshot
+        // catches the overwrite.
+        std::atomic_thread_fence(std::memory_order_release);
+        store(slot(k), x);
+        seq_.store(2 * k + 2, std::memory_order_release);
+        pushes_ = k + 1;
+    }
+
+    // The number of elements ever pushed. Only meaningful in the writer thread (readers get theirs from the
+    // snapshots).
+    std::uint64_t pushes() const
+    {
+        return pushes_;
+    }
+
+    /// Reader side
+    // Any number of threads may take snapshots at the same time, and at the same time as the writer pushes.
+
+    // One attempt at copying the newest n elements (fewer if the ring holds fewer), oldest first, to out.
+    // Returns false if the writer overwrote some of them during the copy; then out holds garbage.
+    // count is set to the number of elements copied.
+    bool try_snapshot(T* out, size_type n, size_type& count) const
+    {
+        std::uint64_t before = seq_.load(std::memory_order_acquire);
+        std::uint64_t published = before / 2;
+        std::uint64_t held = published < capacity() ? published : capacity();
+        // The slot of a push which has started but not finished may be half written already.
+        if (before % 2 != 0 && held == capacity()) {
+            --held;
+        }
+        count = n < held ? n : static_cast<size_type>(held);
+        std::uint64_t first = published - count;
+        for (std::uint64_t k = first; k != published; ++k) {
+            *out++ = load(slot(k));
+        }
+        // The loads above must not move after the second look at seq.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        std::uint64_t after = seq_.load(std::memory_order_relaxed);
+        // Pushes started by now: after / 2, plus one if one is under way. Push number k + capacity() is the first
+        // to overwrite the slot of push k, so all of our slots are intact if fewer than first + capacity() started.
+        std::uint64_t started = (after + 1) / 2;
+        return started <= first + capacity();
+    }
+
+    // Tries until it gets a consistent copy. Never blocks the writer; returns the number of elements copied.
+    size_type snapshot(T* out, size_type n) const
+    {
+        size_type count = 0;
+        while (!try_snapshot(out, n, count)) {}
+        return count;
+    }
+
+    // The newest n elements as a circular_buffer of capacity n.
+    circular_buffer<T> snapshot(size_type n) const
+    {
+        circular_buffer<T> result(n);
+        size_type count = snapshot(result.assign_in_place(n).data(), n);
+        result.assign_in_place(count);
+        return result;
+    }
+
+private:
+    std::atomic<word>* slot(std::uint64_t k) const
+    {
+        return words_.get() + (static_cast<size_type>(k) & mask_) * words_per_element;
+    }
+
+    static void store(std::atomic<word>* s, const T& x)
+    {
+        word w[words_per_element];
+        std::memcpy(w, &x, sizeof(T));
+        for (std::size_t i = 0; i != words_per_element; ++i) {
+            s[i].store(w[i], std::memory_order_relaxed);
+        }
+    }
+    static T load(const std::atomic<word>* s)
+    {
+        word w[words_per_element];
+        for (std::size_t i = 0; i != words_per_element; ++i) {
+            w[i] = s[i].load(std::memory_order_relaxed);
+        }
+        T x;
+        std::memcpy(&x, w, sizeof(T));
+        return x;
+    }
+
+    size_type mask_;
+    std::unique_ptr<std::atomic<word>[]> words_;
+    // The readers poll seq_ all the time, the writer's own counter should not share its cache line.
+    alignas(64) std::atomic<std::uint64_t> seq_;
+    alignas(64) std::uint64_t pushes_;
+};
+
+#endif // !SEQLOCK_RING_GENERIC_PROGRAMMING
@@ -0,0 +1,12 @@
+#ifndef SEQLOCK_RING_TESTS_GENERIC_PROGRAMMING
+#define SEQLOCK_RING_TESTS_GENERIC_PROGRAMMING
+
+#include "seqlock_ring.hpp"
+
+bool test_seqlock_ring();
+
+bool test_seqlock_ring_concurrent_snapshots();
+
+void test_seqlock_ring_performance();
+
+#endif // !SEQLOCK_RING_TESTS_GENERIC_PROGRAMMING
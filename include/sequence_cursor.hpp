@@ -0,0 +1,85 @@
+#ifndef SEQUENCE_CURSOR_GENERIC_PROGRAMMING
+#define SEQUENCE_CURSOR_GENERIC_PROGRAMMING
+
+#include <cstddef>
+#include <cstdint>
+#include "circular_buffer.hpp"
+#include "storage_segments.hpp"
+
+/// Consumer cursors
+// A producer pushes into a circular_buffer and any number of consumers read from it, each at its own pace. A
+// consumer which falls behind by more than the capacity loses the oldest elements to overwrites; with sequence
+// numbers (see circular_buffer::first_seq) it knows exactly how many. A cursor is nothing but the sequence number of
+// the next element the consumer wants, so a consumer costs 8 bytes and the buffer does not know it exists:
+//     sequence_cursor c { cb.end_seq() };          // only what is pushed from now on
+//     ...
+//     std::uint64_t missed = catch_up(c, cb);       // report it, resynchronize...
+//     for (; c.next != cb.end_seq(); ++c.next) {
+//         use(cb.at_seq(c.next));
+//     }
+// read does the same in one call, walking the two segments of the buffer instead of calling at_seq every time.
+// The cursors are for consumers in the same thread as the producer (or behind the same lock); across threads see
+// seqlock_ring.hpp.
+
+struct sequence_cursor {
+    std::uint64_t next;
+};
+
+// How many elements the cursor has lost: those it has not read which are no longer in the buffer.
+template<typename T>
+std::uint64_t lost(const sequence_cursor& c, const circular_buffer<T>& cb)
+{
+    return c.next < cb.first_seq() ? cb.first_seq() - c.next : 0;
+}
+
+// How far behind the producer the cursor is, counting the lost elements. For lag monitoring.
+template<typename T>
+std::uint64_t lag(const sequence_cursor& c, const circular_buffer<T>& cb) // [[expects: c.next <= cb.end_seq()]]
+{
+    return cb.end_seq() - c.next;
+}
+
+// Moves the cursor past the lost elements (if any) to the oldest one still in the buffer.
+// Returns how many were lost.
+template<typename T>
+std::uint64_t catch_up(sequence_cursor& c, const circular_buffer<T>& cb)
+{
+    std::uint64_t n = lost(c, cb);
+    c.next += n;
+    return n;
+}
+
+// The elements the cursor has not read yet which are still in the buffer, oldest first. They stay valid until the
+// buffer changes; the functions in reductions.hpp accept them.
+template<typename T>
+storage_segments<const T> unread(const sequence_cursor& c, const circular_buffer<T>& cb)
+// [[expects: c.next <= cb.end_seq()]]
+{
+    std::uint64_t first = c.next < cb.first_seq() ? cb.first_seq() : c.next;
+    return subsegments(make_storage_segments(cb), static_cast<std::size_t>(first - cb.first_seq()),
+                       static_cast<std::size_t>(cb.end_seq() - first));
+}
+
+struct read_result {
+    std::uint64_t lost;
+    std::size_t read;
+};
+
+// Calls f on every unread element, oldest first, and moves the cursor to the end of the buffer.
+template<typename T, typename F>
+// requires Function<F, const T&>{}
+read_result read(sequence_cursor& c, const circular_buffer<T>& cb, F f) // [[expects: c.next <= cb.end_seq()]]
+{
+    storage_segments<const T> s = unread(c, cb);
+    read_result result { lost(c, cb), s.size() };
+    for (const T& x : s.one) {
+        f(x);
+    }
+    for (const T& x : s.two) {
+        f(x);
+    }
+    c.next = cb.end_seq();
+    return result;
+}
+
+#endif // !SEQUENCE_CURSOR_GENERIC_PROGRAMMING
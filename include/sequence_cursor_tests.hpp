@@ -0,0 +1,12 @@
+#ifndef SEQUENCE_CURSOR_TESTS_GENERIC_PROGRAMMING
+#define SEQUENCE_CURSOR_TESTS_GENERIC_PROGRAMMING
+
+#include "sequence_cursor.hpp"
+
+bool test_sequence_numbers();
+
+bool test_sequence_cursor();
+
+void test_sequence_cursor_performance();
+
+#endif // !SEQUENCE_CURSOR_TESTS_GENERIC_PROGRAMMING
@@ -1,6 +1,9 @@
 #ifndef SINGLETON_GENERIC_PROGRAMMING
 #define SINGLETON_GENERIC_PROGRAMMING
 
+#include <concepts>
+#include <type_traits>
+
 template <typename T>
 // requires SemiRegular<T> || Regular<T> || TotallyOrdered<T>
 struct singleton {
@@ -12,18 +15,19 @@ struct singleton {
     // Explicit means that we have to explicitly call the constructor (by name) to invoke it.
     // We will remove it to allow to implicit conversions between type. See mai.cpp for and example.
     // explicit
-    singleton(const T& x) : value(x) {}
+    constexpr singleton(const T& x) noexcept(std::is_nothrow_copy_constructible<T>::value) : value(x) {}
     // The conversion singleton<T> -> T is done through a conversion operator.
     // What you do is just write operator and the name of the type you want to convert to.
     // explicit
-    operator T() const
+    constexpr operator T() const noexcept(std::is_nothrow_copy_constructible<T>::value)
     { 
         return value; 
     }
     // This is a template function inside a template class. It is well defined for all types U
     // such that U is convertible to T
     template <typename U>
-    singleton(const singleton<U>& x) : value(x.value) {}
+    constexpr singleton(const singleton<U>& x) noexcept(std::is_nothrow_constructible<T, const U&>::value)
+        : value(x.value) {}
 
     // What follow are requirement for singleton<T> being semi-regular.
     // Default constructor, copy constructor, move constructor, 
@@ -40,12 +44,12 @@ struct singleton {
     // We define the functions as friends so as not to define them outside the class and
     // to still be free functions.
     friend
-    bool operator==(const singleton& x, const singleton& y)
+    constexpr bool operator==(const singleton& x, const singleton& y) noexcept(noexcept(x.value == y.value))
     {
         return x.value == y.value;
     }
     friend
-    bool operator!=(const singleton& x, const singleton& y)
+    constexpr bool operator!=(const singleton& x, const singleton& y) noexcept(noexcept(x == y))
     {
         // Remember, define functions in terms of others if possible.
         return !(x == y);
@@ -53,26 +57,164 @@ struct singleton {
     // What follow are requirement for singleton<T> being totally-ordered.
     // Same as before.
     friend
-    bool operator<(const singleton& x, const singleton& y)
+    constexpr bool operator<(const singleton& x, const singleton& y) noexcept(noexcept(x.value < y.value))
     {
         return x.value < y.value;
     }
     friend
-        bool operator>(const singleton& x, const singleton& y)
+    constexpr bool operator>(const singleton& x, const singleton& y) noexcept(noexcept(x < y))
     {
         return y < x;
     }
     friend
-        bool operator<=(const singleton& x, const singleton& y)
+    constexpr bool operator<=(const singleton& x, const singleton& y) noexcept(noexcept(x < y))
     {
         return !(y < x);
     }
     friend
-        bool operator>=(const singleton& x, const singleton& y)
+    constexpr bool operator>=(const singleton& x, const singleton& y) noexcept(noexcept(x < y))
     {
         return !(x < y);
     }
+
+    // Arithmetic.
+    // Without these, a + b still compiles: both singletons are converted to T, added as Ts and the sum is a T.
+    // The compiler sees through that round trip, but the result has the wrong type (a T, not a singleton<T>)
+    // and any T converts back silently. So we forward the operators of T instead, the same way as the comparisons.
+    // A singleton and a T can be mixed too. The operators are templates which only accept exactly a singleton or
+    // exactly a T: template arguments are deduced, never converted to. Otherwise a + 1.5 on a singleton<int> would
+    // be ambiguous between our operator+ (converting 1.5 to an int and then to a singleton) and the built in
+    // one (converting a to an int), and GCC would pick ours, which drops the .5. With any other type than T
+    // our operators do not apply, and a + 1.5 goes through the conversion to T as before: it is 4.5, a double.
+    // Like all members of a class template, they are only instantiated if used: singleton<std::string> has
+    // an operator- as long as nobody calls it.
+    constexpr singleton& operator+=(const singleton& x) noexcept(noexcept(value += x.value))
+    {
+        value += x.value;
+        return *this;
+    }
+    constexpr singleton& operator-=(const singleton& x) noexcept(noexcept(value -= x.value))
+    {
+        value -= x.value;
+        return *this;
+    }
+    constexpr singleton& operator*=(const singleton& x) noexcept(noexcept(value *= x.value))
+    {
+        value *= x.value;
+        return *this;
+    }
+    constexpr singleton& operator/=(const singleton& x) noexcept(noexcept(value /= x.value))
+    {
+        value /= x.value;
+        return *this;
+    }
+
+    template<typename S>
+        requires std::same_as<S, singleton>
+    friend
+    constexpr singleton operator+(S x, const S& y) noexcept(noexcept(x += y))
+    {
+        return x += y;
+    }
+    template<typename S>
+        requires std::same_as<S, singleton>
+    friend
+    constexpr singleton operator-(S x, const S& y) noexcept(noexcept(x -= y))
+    {
+        return x -= y;
+    }
+    template<typename S>
+        requires std::same_as<S, singleton>
+    friend
+    constexpr singleton operator*(S x, const S& y) noexcept(noexcept(x *= y))
+    {
+        return x *= y;
+    }
+    template<typename S>
+        requires std::same_as<S, singleton>
+    friend
+    constexpr singleton operator/(S x, const S& y) noexcept(noexcept(x /= y))
+    {
+        return x /= y;
+    }
+    friend
+    constexpr singleton operator-(const singleton& x) noexcept(noexcept(-x.value))
+    {
+        return singleton(-x.value);
+    }
+
+    template<typename U>
+        requires std::same_as<U, T>
+    friend
+    constexpr singleton operator+(singleton x, const U& y) noexcept(noexcept(x.value += y))
+    {
+        x.value += y;
+        return x;
+    }
+    template<typename U>
+        requires std::same_as<U, T>
+    friend
+    constexpr singleton operator+(const U& x, singleton y) noexcept(noexcept(y.value = x + y.value))
+    {
+        y.value = x + y.value;
+        return y;
+    }
+    template<typename U>
+        requires std::same_as<U, T>
+    friend
+    constexpr singleton operator-(singleton x, const U& y) noexcept(noexcept(x.value -= y))
+    {
+        x.value -= y;
+        return x;
+    }
+    template<typename U>
+        requires std::same_as<U, T>
+    friend
+    constexpr singleton operator-(const U& x, singleton y) noexcept(noexcept(y.value = x - y.value))
+    {
+        y.value = x - y.value;
+        return y;
+    }
+    template<typename U>
+        requires std::same_as<U, T>
+    friend
+    constexpr singleton operator*(singleton x, const U& y) noexcept(noexcept(x.value *= y))
+    {
+        x.value *= y;
+        return x;
+    }
+    template<typename U>
+        requires std::same_as<U, T>
+    friend
+    constexpr singleton operator*(const U& x, singleton y) noexcept(noexcept(y.value = x * y.value))
+    {
+        y.value = x * y.value;
+        return y;
+    }
+    template<typename U>
+        requires std::same_as<U, T>
+    friend
+    constexpr singleton operator/(singleton x, const U& y) noexcept(noexcept(x.value /= y))
+    {
+        x.value /= y;
+        return x;
+    }
+    template<typename U>
+        requires std::same_as<U, T>
+    friend
+    constexpr singleton operator/(const U& x, singleton y) noexcept(noexcept(y.value = x / y.value))
+    {
+        y.value = x / y.value;
+        return y;
+    }
 };
 
+// The promise of singleton is that it costs nothing over a bare T. For the types we wrap, the compiler has to
+// be able to copy it with memcpy and keep it in a register, exactly like a T (see singleton_codegen.cpp).
+static_assert(std::is_trivially_copyable<singleton<int>>::value, "singleton<int> must be trivially copyable");
+static_assert(std::is_trivially_copyable<singleton<double>>::value, "singleton<double> must be trivially copyable");
+static_assert(std::is_standard_layout<singleton<int>>::value && sizeof(singleton<int>) == sizeof(int),
+              "singleton<int> must have the layout of an int");
+
 #endif // !SINGLETON_GENERIC_PROGRAMMING
 
@@ -0,0 +1,272 @@
+#ifndef SNAPSHOT_GENERIC_PROGRAMMING
+#define SNAPSHOT_GENERIC_PROGRAMMING
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include "array_segment.hpp"
+#include "buffer.hpp"
+#include "circular_buffer.hpp"
+
+/// Binary snapshots
+// Saving a container as text and reading it back means formatting and parsing every element, and pushing them
+// into the container one by one. A snapshot instead stores the bytes of the elements as they are in memory:
+// a fixed size header, then the storage segments of the container (oldest element first).
+// For trivially copyable types saving is one write per segment and loading is a single read straight into
+// the storage of the new container. A snapshot file can also be mapped into memory (mapped_snapshot) and used
+// in place, without any reading at all.
+//
+// Snapshots are meant to be read back on the same kind of machine: the header records the byte order and the
+// element size and loading refuses anything that does not match.
+
+// The header is 64 bytes, so the elements that follow it are aligned to a cache line in a mapped file.
+struct snapshot_header {
+    static constexpr std::uint32_t current_version = 1;
+    static constexpr std::uint32_t byte_order_mark = 0x01020304;
+
+    enum container_kind : std::uint32_t { buffer_kind = 1, circular_buffer_kind = 2 };
+    enum encoding_kind : std::uint32_t { raw_encoding = 0, element_encoding = 1 };
+
+    char          magic[8];
+    std::uint32_t byte_order;
+    std::uint32_t version;
+    std::uint32_t container;
+    std::uint32_t encoding;
+    std::uint64_t element_size;
+    std::uint64_t size;      // Number of elements.
+    std::uint64_t capacity;  // Capacity of a circular_buffer, size of a buffer.
+    std::uint64_t reserved[2];
+};
+
+static_assert(sizeof(snapshot_header) == 64, "snapshot_header must stay 64 bytes");
+
+enum class snapshot_status {
+    ok,
+    io_error,             // The stream failed or the data ended early.
+    not_a_snapshot,       // Wrong magic bytes.
+    unsupported_version,  // Written by a newer version of this code.
+    wrong_byte_order,
+    type_mismatch,        // A different container, element size or encoding.
+    size_mismatch         // A buffer snapshot with a different N.
+};
+
+const char* to_string(snapshot_status s);
+
+snapshot_header make_snapshot_header(snapshot_header::container_kind container,
+                                     snapshot_header::encoding_kind encoding,
+                                     std::size_t element_size, std::size_t size, std::size_t capacity);
+
+bool write_snapshot_header(std::ostream& out, const snapshot_header& h);
+
+// Reads the header and checks everything that does not depend on the type we load into.
+snapshot_status read_snapshot_header(std::istream& in, snapshot_header& h);
+
+// The checks against the container and element type we load into.
+snapshot_status check_snapshot_header(const snapshot_header& h, snapshot_header::container_kind container,
+                                      snapshot_header::encoding_kind encoding, std::size_t element_size);
+
+// A circular_buffer is allocated for the capacity in the header before any element is read, so a corrupt (or
+// hostile) header could make us allocate gigabytes, or throw std::bad_alloc. Loading refuses capacities of more
+// bytes than this, unless the caller allows more.
+constexpr std::uint64_t snapshot_max_capacity_bytes = std::uint64_t(1) << 30;
+
+// The checks of the element count and capacity of a circular_buffer snapshot, before allocating anything:
+// the size fits the capacity, the capacity fits max_capacity_bytes and, for raw elements from a stream which
+// knows its length (a file, a string), the rest of the stream holds all of the elements.
+snapshot_status check_snapshot_sizes(std::istream& in, const snapshot_header& h, std::uint64_t max_capacity_bytes);
+
+
+/// Customization point
+// Trivially copyable types are stored as raw bytes. Any other type has to say how to store it, by specializing
+// snapshot_traits with raw = false and a write and a read function, like the one for std::string bellow:
+//     template<>
+//     struct snapshot_traits<my_type> {
+//         static constexpr bool raw = false;
+//         static bool write(std::ostream& out, const my_type& x);
+//         static bool read(std::istream& in, my_type& x);
+//     };
+// Types with neither cannot be snapshotted (the compiler says so when we try).
+template<typename T, typename = void>
+struct snapshot_traits {};
+
+template<typename T>
+struct snapshot_traits<T, std::enable_if_t<std::is_trivially_copyable<T>::value>> {
+    static constexpr bool raw = true;
+};
+
+// A length followed by the characters.
+template<>
+struct snapshot_traits<std::string> {
+    static constexpr bool raw = false;
+    static bool write(std::ostream& out, const std::string& x);
+    static bool read(std::istream& in, std::string& x);
+};
+
+template<typename T>
+constexpr snapshot_header::encoding_kind snapshot_encoding()
+{
+    return snapshot_traits<T>::raw ? snapshot_header::raw_encoding : snapshot_header::element_encoding;
+}
+
+// The elements of a segment, either all their bytes at once or one by one through the traits.
+template<typename T>
+bool write_snapshot_elements(std::ostream& out, array_segment<const T> s)
+{
+    if constexpr (snapshot_traits<T>::raw) {
+        out.write(reinterpret_cast<const char*>(s.data()), static_cast<std::streamsize>(s.size() * sizeof(T)));
+    }
+    else {
+        for (const T& x : s) {
+            if (!snapshot_traits<T>::write(out, x)) {
+                return false;
+            }
+        }
+    }
+    return static_cast<bool>(out);
+}
+
+template<typename T>
+bool read_snapshot_elements(std::istream& in, array_segment<T> s)
+{
+    if constexpr (snapshot_traits<T>::raw) {
+        std::streamsize bytes = static_cast<std::streamsize>(s.size() * sizeof(T));
+        in.read(reinterpret_cast<char*>(s.data()), bytes);
+        return in.gcount() == bytes;
+    }
+    else {
+        for (T& x : s) {
+            if (!snapshot_traits<T>::read(in, x)) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+
+/// Saving and loading
+// The streams should be opened in binary mode.
+
+template<typename T, int N>
+snapshot_status save_snapshot(std::ostream& out, const buffer<T, N>& b)
+{
+    auto h = make_snapshot_header(snapshot_header::buffer_kind, snapshot_encoding<T>(), sizeof(T), N, N);
+    if (!write_snapshot_header(out, h) || !write_snapshot_elements<T>(out, { b.data(), N })) {
+        return snapshot_status::io_error;
+    }
+    return snapshot_status::ok;
+}
+
+template<typename T>
+snapshot_status save_snapshot(std::ostream& out, const circular_buffer<T>& cb)
+{
+    auto h = make_snapshot_header(snapshot_header::circular_buffer_kind, snapshot_encoding<T>(), sizeof(T),
+                                  cb.size(), cb.capacity());
+    if (!write_snapshot_header(out, h) || !write_snapshot_elements(out, cb.array_one())
+        || !write_snapshot_elements(out, cb.array_two())) {
+        return snapshot_status::io_error;
+    }
+    return snapshot_status::ok;
+}
+
+// A buffer has no room for a snapshot of a different size, so the N must match.
+// The elements are read straight into b (big buffers do not fit on the stack, so there is no room for a copy
+// either). If reading fails half way through, the elements of b are a mix of old and new ones.
+template<typename T, int N>
+snapshot_status load_snapshot(std::istream& in, buffer<T, N>& b)
+{
+    snapshot_header h;
+    snapshot_status s = read_snapshot_header(in, h);
+    if (s == snapshot_status::ok) {
+        s = check_snapshot_header(h, snapshot_header::buffer_kind, snapshot_encoding<T>(), sizeof(T));
+    }
+    if (s != snapshot_status::ok) {
+        return s;
+    }
+    if (h.size != static_cast<std::uint64_t>(N)) {
+        return snapshot_status::size_mismatch;
+    }
+    if (!read_snapshot_elements<T>(in, { b.data(), N })) {
+        return snapshot_status::io_error;
+    }
+    return snapshot_status::ok;
+}
+
+// The ring gets the capacity it had when it was saved, with its elements from the beginning of the array.
+// It is loaded to the side, so cb stays as it was if loading fails. The new array is allocated with the
+// ring_memory_options of cb, and the sequence numbers of cb carry on: the loaded elements count as pushed after
+// the ones it had (see circular_buffer::replace_contents).
+template<typename T>
+snapshot_status load_snapshot(std::istream& in, circular_buffer<T>& cb,
+                              std::uint64_t max_capacity_bytes = snapshot_max_capacity_bytes)
+{
+    snapshot_header h;
+    snapshot_status s = read_snapshot_header(in, h);
+    if (s == snapshot_status::ok) {
+        s = check_snapshot_header(h, snapshot_header::circular_buffer_kind, snapshot_encoding<T>(), sizeof(T));
+    }
+    if (s != snapshot_status::ok) {
+        return s;
+    }
+    s = check_snapshot_sizes(in, h, max_capacity_bytes);
+    if (s != snapshot_status::ok) {
+        return s;
+    }
+    circular_buffer<T> temp(static_cast<std::size_t>(h.capacity), cb.memory_options());
+    if (!read_snapshot_elements(in, temp.assign_in_place(static_cast<std::size_t>(h.size)))) {
+        return snapshot_status::io_error;
+    }
+    cb.replace_contents(temp);
+    return snapshot_status::ok;
+}
+
+
+/// Mapped snapshots
+// Maps a snapshot file into memory and gives out its elements in place: loading costs nothing up front,
+// the operating system reads the pages in when they are first touched. Only for raw snapshots (trivially
+// copyable elements), and the elements are read only. Needs mmap, so it is only there on POSIX systems.
+#if defined(__unix__) || defined(__APPLE__)
+#define SNAPSHOT_HAS_MMAP
+
+class mapped_snapshot {
+public:
+    explicit mapped_snapshot(const char* path);
+
+    mapped_snapshot(const mapped_snapshot&) = delete;
+    mapped_snapshot& operator=(const mapped_snapshot&) = delete;
+
+    ~mapped_snapshot();
+
+    snapshot_status status() const
+    {
+        return status_;
+    }
+    const snapshot_header& header() const // [[expects: status() == snapshot_status::ok]]
+    {
+        return *static_cast<const snapshot_header*>(data_);
+    }
+
+    // The elements, oldest first. Empty if the snapshot does not hold raw elements of type T.
+    template<typename T>
+    array_segment<const T> elements() const
+    {
+        if (status_ != snapshot_status::ok || header().encoding != snapshot_header::raw_encoding
+            || header().element_size != sizeof(T)) {
+            return { nullptr, 0 };
+        }
+        const char* first = static_cast<const char*>(data_) + sizeof(snapshot_header);
+        return { reinterpret_cast<const T*>(first), static_cast<std::size_t>(header().size) };
+    }
+
+private:
+    void* data_;
+    std::size_t length_;
+    snapshot_status status_;
+};
+
+#endif
+
+#endif // !SNAPSHOT_GENERIC_PROGRAMMING
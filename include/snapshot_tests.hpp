@@ -0,0 +1,14 @@
+#ifndef SNAPSHOT_TESTS_GENERIC_PROGRAMMING
+#define SNAPSHOT_TESTS_GENERIC_PROGRAMMING
+
+#include "snapshot.hpp"
+
+bool test_snapshot_round_trip();
+
+bool test_snapshot_errors();
+
+bool test_mapped_snapshot();
+
+void test_snapshot_performance();
+
+#endif // !SNAPSHOT_TESTS_GENERIC_PROGRAMMING
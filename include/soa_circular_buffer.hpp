@@ -0,0 +1,444 @@
+#ifndef SOA_CIRCULAR_BUFFER_GENERIC_PROGRAMMING
+#define SOA_CIRCULAR_BUFFER_GENERIC_PROGRAMMING
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "array_segment.hpp"
+#include "revision.hpp"
+
+/// Structure of Arrays Circular Buffer
+/// circular_buffer<color_rgba> stores whole colors next to each other (an "array of structures").
+/// If we only want to look at the red channel we still drag green, blue and alpha through the cache.
+/// soa_circular_buffer<T> instead keeps one ring per data member of T (a "structure of arrays"). All of the
+/// rings share the same head and size so element i is made of the i-th entry of every ring.
+/// Since there is no T object in memory anymore, operator[] returns a proxy that behaves like a reference to T:
+/// it converts to T, can be assigned a T and gives access to the individual fields.
+
+/// Customization point
+// For each type T that we want to store we need to tell the container what the data members of T are.
+// This is done by specializing soa_traits and providing a tuple of pointers to the data members.
+// T must be default constructible since elements are gathered member by member.
+template<typename T>
+struct soa_traits;
+
+template<>
+struct soa_traits<color_rgba> {
+    static constexpr auto fields = std::make_tuple(&color_rgba::r, &color_rgba::g, &color_rgba::b, &color_rgba::a);
+};
+
+// Type function giving the type of a data member from a pointer to data member type.
+template<typename M>
+struct member_pointer_traits;
+
+template<typename C, typename F>
+struct member_pointer_traits<F C::*> {
+    using class_type = C;
+    using member_type = F;
+};
+
+template<typename T, std::size_t I>
+using soa_field_type = typename member_pointer_traits<
+    std::decay_t<std::tuple_element_t<I, std::decay_t<decltype(soa_traits<T>::fields)>>>>::member_type;
+
+template<typename T>
+constexpr std::size_t soa_field_count = std::tuple_size<std::decay_t<decltype(soa_traits<T>::fields)>>::value;
+
+template<typename CB>
+class soa_reference;
+
+template<typename CB>
+class soa_iterator;
+
+template<typename T>
+// requires SemiRegular<T>{} && SoaDescribed<T>{}
+class soa_circular_buffer {
+public:
+    using value_type = T;
+    using reference = soa_reference<soa_circular_buffer<T>>;
+    using const_reference = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using self_type = soa_circular_buffer<T>;
+    using iterator = soa_iterator<self_type>;
+
+    template<std::size_t I>
+    using field_type = soa_field_type<T, I>;
+
+    static constexpr std::size_t field_count = soa_field_count<T>;
+private:
+    using indices = std::make_index_sequence<field_count>;
+
+    template<std::size_t... Is>
+    static std::tuple<field_type<Is>*...> pointer_tuple(std::index_sequence<Is...>);
+
+    using arrays_type = decltype(pointer_tuple(indices {}));
+public:
+    soa_circular_buffer()
+        : arrays_ {}, array_size_(0), head_(0), contents_size_(0)
+    {}
+
+    explicit soa_circular_buffer(size_type capacity)
+        : arrays_ {}, array_size_(capacity), head_(0), contents_size_(0)
+    {
+        allocate(arrays_, capacity, indices {});
+    }
+
+    soa_circular_buffer(const soa_circular_buffer& other)
+        : soa_circular_buffer(other.array_size_)
+    {
+        head_ = other.head_;
+        contents_size_ = other.contents_size_;
+        // Every field array is copied as a whole. It does not matter that some slots are not in use.
+        copy_arrays(other, indices {});
+    }
+    soa_circular_buffer& operator=(const soa_circular_buffer& other)
+    {
+        // Copy and Swap, same as in circular_buffer.
+        soa_circular_buffer temp(other);
+        this->swap(temp);
+        return *this;
+    }
+
+    void swap(soa_circular_buffer& other)
+    {
+        using std::swap;
+        swap(this->arrays_, other.arrays_);
+        swap(this->array_size_, other.array_size_);
+        swap(this->head_, other.head_);
+        swap(this->contents_size_, other.contents_size_);
+    }
+
+    ~soa_circular_buffer()
+    {
+        deallocate(arrays_, indices {});
+    }
+
+    iterator begin()
+    {
+        return iterator(*this, 0);
+    }
+    iterator end()
+    {
+        return iterator(*this, size());
+    }
+
+    reference front() // [[expects: !empty()]]
+    {
+        return (*this)[0];
+    }
+    reference back() // [[expects: !empty()]]
+    {
+        return (*this)[size() - 1];
+    }
+    const_reference front() const // [[expects: !empty()]]
+    {
+        return (*this)[0];
+    }
+    const_reference back() const // [[expects: !empty()]]
+    {
+        return (*this)[size() - 1];
+    }
+
+    void clear() // [[assures: empty()]]
+    {
+        head_ = contents_size_ = 0;
+    }
+
+    // Same semantics as circular_buffer::push_back, we override the oldest element on overflow.
+    void push_back(const_reference val) // [[assures: !empty()]]
+    {
+        if (contents_size_ == array_size_) {
+            store(head_, val);
+            increment_head();
+        }
+        else {
+            store(physical_index(contents_size_), val);
+            ++contents_size_;
+        }
+    }
+    void pop_front() // [[expects: !empty()]]
+    {
+        increment_head();
+        --contents_size_;
+    }
+
+    size_type size() const
+    {
+        return contents_size_;
+    }
+    size_type capacity() const
+    {
+        return array_size_;
+    }
+    bool empty() const
+    {
+        return contents_size_ == 0;
+    }
+
+    reference operator[](size_type i) // [[expects: i < size()]]
+    {
+        return reference(*this, physical_index(i));
+    }
+    // There is no T stored anywhere that we could return a reference to, so we return a copy.
+    const_reference operator[](size_type i) const // [[expects: i < size()]]
+    {
+        return load(physical_index(i));
+    }
+
+    /// Per channel access
+    // The I-th field of the stored elements forms a ring of its own. Just like the whole container,
+    // the valid part of it is split into at most two contiguous segments. channel_one gives the older
+    // elements (from head to the end of the array), channel_two the newer ones (from the beginning of the array).
+    // Together, in this order, they hold the I-th field of elements [0, size()).
+    template<std::size_t I>
+    array_segment<field_type<I>> channel_one()
+    {
+        return { field_array<I>() + head_, first_segment_size() };
+    }
+    template<std::size_t I>
+    array_segment<field_type<I>> channel_two()
+    {
+        return { field_array<I>(), contents_size_ - first_segment_size() };
+    }
+    template<std::size_t I>
+    array_segment<const field_type<I>> channel_one() const
+    {
+        return { field_array<I>() + head_, first_segment_size() };
+    }
+    template<std::size_t I>
+    array_segment<const field_type<I>> channel_two() const
+    {
+        return { field_array<I>(), contents_size_ - first_segment_size() };
+    }
+
+    // Direct access to a single field of an element. Used by the reference proxy.
+    template<std::size_t I>
+    field_type<I>& field_at_physical(size_type index)
+    {
+        return field_array<I>()[index];
+    }
+    template<std::size_t I>
+    const field_type<I>& field_at_physical(size_type index) const
+    {
+        return field_array<I>()[index];
+    }
+
+    // Gather and scatter of whole elements at a physical index. Used by the reference proxy.
+    value_type load(size_type index) const
+    {
+        value_type ret {};
+        load_fields(ret, index, indices {});
+        return ret;
+    }
+    void store(size_type index, const_reference val)
+    {
+        store_fields(index, val, indices {});
+    }
+
+private:
+    template<std::size_t I>
+    field_type<I>* field_array() const
+    {
+        return std::get<I>(arrays_);
+    }
+
+    template<std::size_t... Is>
+    static void allocate(arrays_type& arrays, size_type n, std::index_sequence<Is...>)
+    {
+        ((std::get<Is>(arrays) = new field_type<Is>[n]), ...);
+    }
+    template<std::size_t... Is>
+    static void deallocate(arrays_type& arrays, std::index_sequence<Is...>)
+    {
+        (delete[] std::get<Is>(arrays), ...);
+    }
+    template<std::size_t... Is>
+    void copy_arrays(const soa_circular_buffer& other, std::index_sequence<Is...>)
+    {
+        (std::copy(other.field_array<Is>(), other.field_array<Is>() + array_size_, field_array<Is>()), ...);
+    }
+    template<std::size_t... Is>
+    void load_fields(value_type& val, size_type index, std::index_sequence<Is...>) const
+    {
+        ((val.*std::get<Is>(soa_traits<T>::fields) = field_array<Is>()[index]), ...);
+    }
+    template<std::size_t... Is>
+    void store_fields(size_type index, const_reference val, std::index_sequence<Is...>)
+    {
+        ((field_array<Is>()[index] = val.*std::get<Is>(soa_traits<T>::fields)), ...);
+    }
+
+    size_type first_segment_size() const
+    {
+        size_type till_end = array_size_ - head_;
+        return contents_size_ < till_end ? contents_size_ : till_end;
+    }
+    size_type physical_index(size_type i) const
+    {
+        size_type index = head_ + i;
+        return index >= array_size_ ? index - array_size_ : index;
+    }
+    void increment_head()
+    {
+        ++head_;
+        if (head_ == array_size_) {
+            head_ = 0;
+        }
+    }
+
+    // One array per data member of T.
+    arrays_type arrays_;
+    // The size of each of the underlying arrays.
+    size_type  array_size_;
+    // The index of the first element.
+    size_type  head_;
+    // Number of (valid) elements stored in the buffer.
+    size_type  contents_size_;
+};
+
+
+// The proxy returned by soa_circular_buffer::operator[]. It remembers where the element lives and
+// reads or writes the separate fields on demand. Copying the proxy does not copy the element.
+template<typename CB>
+class soa_reference {
+public:
+    using container_type = CB;
+    using value_type = typename CB::value_type;
+    using size_type = typename CB::size_type;
+public:
+    soa_reference(container_type& cb, size_type index)
+        : cb_ptr_(&cb), index_(index)
+    {}
+    soa_reference(const soa_reference& other) = default;
+
+    // Reading the element as a whole.
+    operator value_type() const
+    {
+        return cb_ptr_->load(index_);
+    }
+
+    // Writing the element as a whole. Assigning one proxy to another copies the element, not the proxy,
+    // just like assigning one reference to another would.
+    soa_reference& operator=(const value_type& val)
+    {
+        cb_ptr_->store(index_, val);
+        return *this;
+    }
+    soa_reference& operator=(const soa_reference& other)
+    {
+        return *this = static_cast<value_type>(other);
+    }
+
+    // Compound assignment is forwarded to the operators of the element type (if it has them).
+    template<typename U>
+    soa_reference& operator+=(const U& u)
+    {
+        value_type val = *this;
+        val += u;
+        return *this = val;
+    }
+    template<typename U>
+    soa_reference& operator-=(const U& u)
+    {
+        value_type val = *this;
+        val -= u;
+        return *this = val;
+    }
+    template<typename U>
+    soa_reference& operator*=(const U& u)
+    {
+        value_type val = *this;
+        val *= u;
+        return *this = val;
+    }
+
+    // Access to a single field without touching the others.
+    template<std::size_t I>
+    typename CB::template field_type<I>& get() const
+    {
+        return cb_ptr_->template field_at_physical<I>(index_);
+    }
+
+private:
+    container_type* cb_ptr_;
+    size_type index_;
+};
+
+// Free function version of soa_reference::get, in the spirit of get<M> for buffers.
+template<std::size_t I, typename CB>
+inline
+typename CB::template field_type<I>& get(const soa_reference<CB>& ref)
+{
+    return ref.template get<I>();
+}
+
+
+// The iterator hands out proxies, so it can only be an input iterator as far as the standard library is concerned
+// (its reference type is not a real reference).
+template<typename CB>
+class soa_iterator {
+public:
+    using container_type = CB;
+    using self_type = soa_iterator<CB>;
+    using value_type = typename CB::value_type;
+    using difference_type = typename CB::difference_type;
+    using reference = typename CB::reference;
+    using pointer = void;
+    using iterator_category = std::input_iterator_tag;
+public:
+    soa_iterator()
+        : cb_ptr_(nullptr), index_(0)
+    {}
+
+    soa_iterator(container_type& cb, difference_type index)
+        : cb_ptr_(&cb), index_(index)
+    {}
+
+    friend
+    bool operator==(const self_type& x, const self_type& y)
+    {
+        return (x.cb_ptr_ == y.cb_ptr_) && (x.index_ == y.index_);
+    }
+    friend
+    bool operator!=(const self_type& x, const self_type& y)
+    {
+        return !(x == y);
+    }
+
+    reference operator*() const
+    {
+        return (*cb_ptr_)[index_];
+    }
+
+    self_type& operator++()
+    {
+        ++index_;
+        return *this;
+    }
+    self_type operator++(int)
+    {
+        self_type ret { *this };
+        ++(*this);
+        return ret;
+    }
+    self_type& operator--()
+    {
+        --index_;
+        return *this;
+    }
+    self_type operator--(int)
+    {
+        self_type ret { *this };
+        --(*this);
+        return ret;
+    }
+private:
+    container_type* cb_ptr_;
+    difference_type index_;
+};
+
+#endif // !SOA_CIRCULAR_BUFFER_GENERIC_PROGRAMMING
@@ -0,0 +1,221 @@
+#ifndef SORTING_NETWORKS_GENERIC_PROGRAMMING
+#define SORTING_NETWORKS_GENERIC_PROGRAMMING
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include "buffer.hpp"
+#include "revision_2.hpp"
+
+/// Sorting networks
+// std::sort is built for big arrays: it picks pivots, recurses, switches to insertion sort at the bottom...
+// For a handful of elements all of that is overhead, and its comparisons are unpredictable branches.
+// A sorting network is a fixed list of compare-exchange steps (put the smaller of a[i] and a[j] at i) which
+// sorts any input. The list does not depend on the data, so we build it at compile time for every N and unroll it
+// completely: no loops, no branches, the elements stay in registers.
+//
+// The networks are Batcher's odd-even merge sort networks. They are not the smallest known, but close:
+//     N:            4   8  16   32
+//     Batcher:      5  19  63  191 compare-exchanges
+//     best known:   5  19  60  185
+// For larger N, sort, partial_sort and nth_element fall back to the standard introsort based algorithms.
+//
+// The comparator has the contract of compare<T> in revision_2.hpp: cmp(x, y) is positive if x goes before y,
+// negative if y goes before x and zero if they are equivalent.
+
+constexpr int sorting_network_max_size = 32;
+
+// The default comparator: compare<T> itself, which orders with <.
+struct compare_function {
+    template<typename T>
+    int operator()(const T& x, const T& y) const
+    {
+        return compare(x, y);
+    }
+};
+
+struct network_comparator {
+    int i;  // i < j: the smaller element ends up at i.
+    int j;
+};
+
+struct comparator_network {
+    // Batcher's network for 32 elements has 191 comparators.
+    static constexpr int capacity = 192;
+
+    network_comparator comparators[capacity];
+    int size;
+};
+
+// Batcher's odd-even merge sort for any n, written as a loop (see Knuth, The Art of Computer Programming 5.3.4).
+// Sort runs of p elements, merge pairs of them into runs of 2p and so on; the comparators that would reach past
+// the end are left out, which is the same as padding the input with elements bigger than all others.
+constexpr comparator_network make_sorting_network(int n)
+{
+    comparator_network net {};
+    for (int p = 1; p < n; p *= 2) {
+        for (int k = p; k >= 1; k /= 2) {
+            for (int j = k % p; j + k < n; j += 2 * k) {
+                for (int i = 0; i < k && i + j + k < n; ++i) {
+                    if ((i + j) / (2 * p) == (i + j + k) / (2 * p)) {
+                        net.comparators[net.size++] = { i + j, i + j + k };
+                    }
+                }
+            }
+        }
+    }
+    return net;
+}
+
+// Only the comparators that can change what ends up in positions [first, last). We walk the network backwards
+// and keep a comparator if one of its outputs is still needed, which makes both of its inputs needed.
+// The kept comparators put the same elements in [first, last) as the whole network.
+constexpr comparator_network prune_network(const comparator_network& net, int first, int last)
+{
+    bool needed[sorting_network_max_size] {};
+    for (int k = first; k < last; ++k) {
+        needed[k] = true;
+    }
+    comparator_network reversed {};
+    for (int c = net.size - 1; c >= 0; --c) {
+        network_comparator x = net.comparators[c];
+        if (needed[x.i] || needed[x.j]) {
+            needed[x.i] = needed[x.j] = true;
+            reversed.comparators[reversed.size++] = x;
+        }
+    }
+    comparator_network pruned {};
+    for (int c = reversed.size - 1; c >= 0; --c) {
+        pruned.comparators[pruned.size++] = reversed.comparators[c];
+    }
+    return pruned;
+}
+
+// The networks for N elements, computed once per N when compiling.
+template<int N>
+struct sorting_network {
+    static_assert(0 <= N && N <= sorting_network_max_size, "sorting networks are only generated for N <= 32");
+    static constexpr comparator_network value = make_sorting_network(N);
+};
+
+// Puts the right elements in [First, Last) in sorted order, the others somewhere after or before them.
+template<int N, int First, int Last>
+struct pruned_sorting_network {
+    static constexpr comparator_network value = prune_network(sorting_network<N>::value, First, Last);
+};
+
+// The comparisons of a sorting network are as unpredictable as those of std::sort, so a compare-exchange must not
+// branch. Compilers are reluctant to use conditional moves for a pair of selects (GCC 12 branches around them), so
+// with the default comparator we spell it out: integers swap with an xor mask, floating point numbers use the
+// min and max instructions. Other small trivially copyable types select both elements from one comparison and
+// hope for conditional moves. For types like strings copying both would cost more than a mispredicted branch,
+// so we swap only when needed.
+template<typename T, typename Compare>
+inline void compare_exchange(T& x, T& y, Compare& cmp)
+{
+    if constexpr (std::is_integral<T>::value && std::is_same<Compare, compare_function>::value) {
+        T a = x;
+        T b = y;
+        T mask = static_cast<T>(-static_cast<T>(b < a));
+        T flip = static_cast<T>((a ^ b) & mask);
+        x = static_cast<T>(a ^ flip);
+        y = static_cast<T>(b ^ flip);
+    }
+    else if constexpr (std::is_floating_point<T>::value && std::is_same<Compare, compare_function>::value) {
+        // Two equal elements come out as two copies of the first one, which only shows for 0.0 and -0.0.
+        T a = x;
+        T b = y;
+        x = std::min(a, b);
+        y = std::max(a, b);
+    }
+    else if constexpr (std::is_trivially_copyable<T>::value && sizeof(T) <= 16) {
+        bool swap = cmp(y, x) > 0;
+        T first = swap ? y : x;
+        T second = swap ? x : y;
+        x = first;
+        y = second;
+    }
+    else {
+        if (cmp(y, x) > 0) {
+            using std::swap;
+            swap(x, y);
+        }
+    }
+}
+
+// The network unrolled: one compare_exchange per comparator, with the indices known when compiling.
+// The networks for 0 and 1 elements have no comparators, and then a and cmp are not used.
+template<typename Network, typename T, typename Compare, std::size_t... C>
+inline void apply_network([[maybe_unused]] T* a, [[maybe_unused]] Compare& cmp, std::index_sequence<C...>)
+{
+    (compare_exchange(a[Network::value.comparators[C].i], a[Network::value.comparators[C].j], cmp), ...);
+}
+
+template<typename Network, typename T, typename Compare>
+inline void apply_network(T* a, Compare& cmp)
+{
+    apply_network<Network>(a, cmp, std::make_index_sequence<Network::value.size>{});
+}
+
+// The standard algorithms want a "less than" predicate.
+template<typename Compare>
+struct compare_as_less {
+    Compare& cmp;
+
+    template<typename T>
+    bool operator()(const T& x, const T& y) const
+    {
+        return cmp(x, y) > 0;
+    }
+};
+
+
+/// Sorting buffers
+
+template<typename T, int N, typename Compare = compare_function>
+// requires Comparator<Compare, T>{}
+void sort(buffer<T, N>& b, Compare cmp = Compare {})
+{
+    if constexpr (N <= sorting_network_max_size) {
+        apply_network<sorting_network<N>>(b.data(), cmp);
+    }
+    else {
+        std::sort(b.data(), b.data() + N, compare_as_less<Compare> { cmp });
+    }
+}
+
+// Puts the K first elements of the sorted order, sorted, at the front. The rest are in unspecified order.
+template<int K, typename T, int N, typename Compare = compare_function>
+// requires Comparator<Compare, T>{}
+void partial_sort(buffer<T, N>& b, Compare cmp = Compare {})
+{
+    static_assert(0 <= K && K <= N, "partial_sort needs 0 <= K <= N");
+    if constexpr (N <= sorting_network_max_size) {
+        apply_network<pruned_sorting_network<N, 0, K>>(b.data(), cmp);
+    }
+    else {
+        std::partial_sort(b.data(), b.data() + K, b.data() + N, compare_as_less<Compare> { cmp });
+    }
+}
+
+// Puts the element which would be at position K after sorting there, with no element after it going before it
+// and no element before it going after it.
+// A network which sorts [0, K] (or [K, N)) does this; we take the one with fewer comparators.
+template<int K, typename T, int N, typename Compare = compare_function>
+// requires Comparator<Compare, T>{}
+void nth_element(buffer<T, N>& b, Compare cmp = Compare {})
+{
+    static_assert(0 <= K && K < N, "nth_element needs 0 <= K < N");
+    if constexpr (N <= sorting_network_max_size) {
+        using front = pruned_sorting_network<N, 0, K + 1>;
+        using back = pruned_sorting_network<N, K, N>;
+        using network = std::conditional_t<(front::value.size <= back::value.size), front, back>;
+        apply_network<network>(b.data(), cmp);
+    }
+    else {
+        std::nth_element(b.data(), b.data() + K, b.data() + N, compare_as_less<Compare> { cmp });
+    }
+}
+
+#endif // !SORTING_NETWORKS_GENERIC_PROGRAMMING
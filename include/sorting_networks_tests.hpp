@@ -0,0 +1,12 @@
+#ifndef SORTING_NETWORKS_TESTS_GENERIC_PROGRAMMING
+#define SORTING_NETWORKS_TESTS_GENERIC_PROGRAMMING
+
+#include "sorting_networks.hpp"
+
+bool test_sorting_networks();
+
+bool test_partial_sort_and_nth_element();
+
+void test_sorting_networks_performance();
+
+#endif // !SORTING_NETWORKS_TESTS_GENERIC_PROGRAMMING
@@ -0,0 +1,240 @@
+#ifndef STATIC_CIRCULAR_BUFFER_GENERIC_PROGRAMMING
+#define STATIC_CIRCULAR_BUFFER_GENERIC_PROGRAMMING
+
+#include <cstddef>
+#include <iterator>
+#include <utility>
+
+/// Fixed Capacity Circular Buffer
+/// This is the sibling of circular_buffer (see circular_buffer.hpp) where the capacity is a non-type template argument,
+/// just like the size of buffer<T, N>. Since the storage is a plain array inside the object, no memory is ever
+/// allocated and every operation can be marked constexpr. That means we can push elements through the ring while
+/// the compiler is running and use the result as a constant (think of lookup tables or the initial state of a filter).
+/// The semantics of the operations are the same as in circular_buffer: push_back overwrites the oldest element
+/// when the buffer is full and indexing is relative to the first (oldest) element.
+
+template<typename CB>
+class static_circular_buffer_iterator;
+
+template<typename T, std::size_t N>
+// requires SemiRegular<T>{} && Literal<T>{}
+class static_circular_buffer {
+    static_assert(N > 0, "static_circular_buffer needs a capacity of at least one element");
+public:
+    using value_type = T;
+    using reference = T&;
+    using const_reference = const T&;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using self_type = static_circular_buffer<T, N>;
+    using iterator = static_circular_buffer_iterator<self_type>;
+    using const_iterator = static_circular_buffer_iterator<const self_type>;
+public:
+    // All elements of the underlying array are value initialized. This is required for constexpr evaluation
+    // since the compiler does not allow reading (or even leaving) uninitialized memory.
+    constexpr static_circular_buffer()
+        : array_ {}, head_(0), contents_size_(0)
+    {}
+
+    // Copy, move and destruction are all implicitly defined. The object holds no resources so the
+    // compiler generated versions do exactly what we want (and stay constexpr and trivial when T is).
+
+    constexpr iterator begin()
+    {
+        return iterator(*this, 0);
+    }
+    constexpr iterator end()
+    {
+        return iterator(*this, size());
+    }
+    constexpr const_iterator begin() const
+    {
+        return const_iterator(*this, 0);
+    }
+    constexpr const_iterator end() const
+    {
+        return const_iterator(*this, size());
+    }
+    constexpr const_iterator cbegin() const
+    {
+        return begin();
+    }
+    constexpr const_iterator cend() const
+    {
+        return end();
+    }
+
+    constexpr reference front() // [[expects: !empty()]]
+    {
+        return array_[head_];
+    }
+    constexpr const_reference front() const // [[expects: !empty()]]
+    {
+        return array_[head_];
+    }
+    constexpr reference back() // [[expects: !empty()]]
+    {
+        return (*this)[contents_size_ - 1];
+    }
+    constexpr const_reference back() const // [[expects: !empty()]]
+    {
+        return (*this)[contents_size_ - 1];
+    }
+
+    constexpr void clear() // [[assures: empty()]]
+    {
+        head_ = contents_size_ = 0;
+    }
+
+    // Adds an element at the back, overwriting the oldest one if the buffer is full.
+    constexpr void push_back(const_reference val) // [[assures: !empty()]]
+    {
+        array_[physical_index(contents_size_ == N ? 0 : contents_size_)] = val;
+        if (contents_size_ == N) {
+            increment_head();
+        }
+        else {
+            ++contents_size_;
+        }
+    }
+    constexpr void push_back(value_type&& val) // [[assures: !empty()]]
+    {
+        array_[physical_index(contents_size_ == N ? 0 : contents_size_)] = std::move(val);
+        if (contents_size_ == N) {
+            increment_head();
+        }
+        else {
+            ++contents_size_;
+        }
+    }
+    constexpr void pop_front() // [[expects: !empty()]]
+    {
+        increment_head();
+        --contents_size_;
+    }
+
+    constexpr size_type size() const
+    {
+        return contents_size_;
+    }
+    constexpr size_type capacity() const
+    {
+        return N;
+    }
+    constexpr bool empty() const
+    {
+        return contents_size_ == 0;
+    }
+    constexpr bool full() const
+    {
+        return contents_size_ == N;
+    }
+    constexpr size_type max_size() const
+    {
+        return N;
+    }
+
+    constexpr reference operator[](size_type i) // [[expects: i < size()]]
+    {
+        return array_[physical_index(i)];
+    }
+    constexpr const_reference operator[](size_type i) const // [[expects: i < size()]]
+    {
+        return array_[physical_index(i)];
+    }
+
+private:
+    // Since the index is always smaller than 2 * N a single subtraction is enough to loop around.
+    constexpr size_type physical_index(size_type i) const
+    {
+        size_type index = head_ + i;
+        return index >= N ? index - N : index;
+    }
+    constexpr void increment_head()
+    {
+        ++head_;
+        if (head_ == N) {
+            head_ = 0;
+        }
+    }
+
+    value_type array_[N];
+    // The index of the first element.
+    size_type  head_;
+    // Number of (valid) elements stored in the buffer.
+    size_type  contents_size_;
+};
+
+
+// The iterator follows the same idea as circular_buffer_iterator: it holds a pointer to the container and a
+// logical index. When CB is const qualified we get a const iterator since the reference type is deduced
+// from the container's subscript operator.
+template<typename CB>
+class static_circular_buffer_iterator {
+public:
+    using container_type = CB;
+    using self_type = static_circular_buffer_iterator<CB>;
+    using value_type = typename CB::value_type;
+    using difference_type = typename CB::difference_type;
+    using reference = decltype(std::declval<CB&>()[0]);
+    using pointer = decltype(&std::declval<reference>());
+    using iterator_category = std::bidirectional_iterator_tag;
+public:
+    constexpr static_circular_buffer_iterator()
+        : cb_ptr_(nullptr), index_(0)
+    {}
+
+    constexpr static_circular_buffer_iterator(container_type& cb, difference_type index)
+        : cb_ptr_(&cb), index_(index)
+    {}
+
+    friend
+    constexpr bool operator==(const self_type& x, const self_type& y)
+    {
+        return (x.cb_ptr_ == y.cb_ptr_) && (x.index_ == y.index_);
+    }
+    friend
+    constexpr bool operator!=(const self_type& x, const self_type& y)
+    {
+        return !(x == y);
+    }
+
+    constexpr reference operator*() const
+    {
+        return (*cb_ptr_)[index_];
+    }
+    constexpr pointer operator->() const
+    {
+        return &(this->operator*());
+    }
+
+    constexpr self_type& operator++()
+    {
+        ++index_;
+        return *this;
+    }
+    constexpr self_type operator++(int)
+    {
+        self_type ret { *this };
+        ++(*this);
+        return ret;
+    }
+    constexpr self_type& operator--()
+    {
+        --index_;
+        return *this;
+    }
+    constexpr self_type operator--(int)
+    {
+        self_type ret { *this };
+        --(*this);
+        return ret;
+    }
+private:
+    container_type* cb_ptr_;
+    difference_type index_;
+};
+
+#endif // !STATIC_CIRCULAR_BUFFER_GENERIC_PROGRAMMING
@@ -0,0 +1,80 @@
+#ifndef STORAGE_SEGMENTS_GENERIC_PROGRAMMING
+#define STORAGE_SEGMENTS_GENERIC_PROGRAMMING
+
+#include <cstddef>
+#include "array_segment.hpp"
+#include "buffer.hpp"
+#include "circular_buffer.hpp"
+
+/// Storage segments
+// The physical storage of a container as (at most) two contiguous segments. Logical index i is in the first
+// segment if i < one.size() and in the second one otherwise. The first segment is only empty if both are.
+// Algorithms that work on the storage of a container directly (parallel_algorithms.hpp, reductions.hpp)
+// support every container for which make_storage_segments is overloaded.
+template<typename T>
+struct storage_segments {
+    array_segment<T> one;
+    array_segment<T> two;
+
+    std::size_t size() const
+    {
+        return one.size() + two.size();
+    }
+};
+
+template<typename T, int N>
+storage_segments<T> make_storage_segments(buffer<T, N>& b)
+{
+    return { { b.data(), N }, { b.data() + N, 0 } };
+}
+
+template<typename T, int N>
+storage_segments<const T> make_storage_segments(const buffer<T, N>& b)
+{
+    return { { b.data(), N }, { b.data() + N, 0 } };
+}
+
+template<typename T>
+storage_segments<T> make_storage_segments(circular_buffer<T>& cb)
+{
+    return { cb.array_one(), cb.array_two() };
+}
+
+template<typename T>
+storage_segments<const T> make_storage_segments(const circular_buffer<T>& cb)
+{
+    return { cb.array_one(), cb.array_two() };
+}
+
+// The address of logical element i. run is shortened (if needed) to the number of elements that follow
+// it contiguously in memory.
+template<typename T>
+T* contiguous_run(const storage_segments<T>& s, std::size_t i, std::size_t& run) // [[expects: i < s.size()]]
+{
+    if (i < s.one.size()) {
+        if (s.one.size() - i < run) {
+            run = s.one.size() - i;
+        }
+        return s.one.data() + i;
+    }
+    i -= s.one.size();
+    if (s.two.size() - i < run) {
+        run = s.two.size() - i;
+    }
+    return s.two.data() + i;
+}
+
+// The logical elements [first, first + count) as segments of their own (still at most two of them).
+template<typename T>
+storage_segments<T> subsegments(const storage_segments<T>& s, std::size_t first, std::size_t count)
+// [[expects: first + count <= s.size()]]
+{
+    std::size_t n1 = s.one.size();
+    if (first >= n1) {
+        return { { s.two.data() + (first - n1), count }, { s.two.data() + (first - n1) + count, 0 } };
+    }
+    std::size_t in_one = n1 - first < count ? n1 - first : count;
+    return { { s.one.data() + first, in_one }, { s.two.data(), count - in_one } };
+}
+
+#endif // !STORAGE_SEGMENTS_GENERIC_PROGRAMMING
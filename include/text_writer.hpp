@@ -0,0 +1,110 @@
+#ifndef TEXT_WRITER_GENERIC_PROGRAMMING
+#define TEXT_WRITER_GENERIC_PROGRAMMING
+
+#include <charconv>
+#include <cstddef>
+#include <ostream>
+#include <type_traits>
+
+/// Bulk text output
+// out << x goes through a lot of machinery for every single number: a sentry object (which checks the stream
+// state and flushes tied streams), the locale's num_put facet, virtual calls into the stream buffer...
+// For a handful of numbers this does not matter, for a container with millions of them it takes seconds.
+//
+// text_writer formats numbers with std::to_chars (no locale, no virtual calls, no allocation) into a block of
+// memory it owns and hands the block to an ostream (or writes it to a file descriptor) only when it is full.
+// The output is byte for byte what operator<< produces, as long as the stream uses the default formatting
+// (see compatible): decimal integers, floating point numbers as printf's %g with the stream's precision.
+// The block is reused, so one writer can format any number of containers one after the other.
+
+// The element types text_writer can format: the arithmetic types, except the wide character types
+// (which ostream does not print as numbers).
+template<typename T>
+struct is_text_formattable
+    : std::integral_constant<bool, std::is_arithmetic<T>::value && !std::is_same<T, wchar_t>::value
+                                   && !std::is_same<T, char16_t>::value && !std::is_same<T, char32_t>::value> {};
+
+class text_writer {
+public:
+    static constexpr std::size_t capacity = 16 * 1024;
+    // Enough for any number with a precision up to max_precision.
+    static constexpr std::size_t max_number_size = 128;
+    static constexpr std::streamsize max_precision = 64;
+
+    // Writes to the stream, with the stream's precision for floating point numbers.
+    explicit text_writer(std::ostream& out);
+    // Writes to a file descriptor (POSIX write), with the default precision of 6.
+    explicit text_writer(int fd);
+
+    // The writer owns a block of pending output, copying it would output it twice.
+    text_writer(const text_writer&) = delete;
+    text_writer& operator=(const text_writer&) = delete;
+
+    // Writes out whatever is still pending.
+    ~text_writer();
+
+    // True if out << x and put_number(x) produce the same characters for every formattable x.
+    static bool compatible(const std::ostream& out);
+
+    void put(char c)
+    {
+        make_room(1);
+        data_[size_++] = c;
+    }
+    void write(const char* s, std::size_t n);
+
+    // The same characters as out << x.
+    template<typename T>
+    // requires TextFormattable<T>{}
+    void put_number(T x);
+
+    // Hands the pending output over to the stream or the file descriptor.
+    void flush();
+
+    // True once writing to a file descriptor has failed (stream errors are in the stream's state, as usual).
+    bool failed() const
+    {
+        return failed_;
+    }
+
+private:
+    void make_room(std::size_t n)
+    {
+        if (capacity - size_ < n) {
+            flush();
+        }
+    }
+
+    std::ostream* out_;
+    int fd_;
+    int precision_;
+    bool failed_;
+    std::size_t size_;
+    char data_[capacity];
+};
+
+template<typename T>
+void text_writer::put_number(T x)
+{
+    static_assert(is_text_formattable<T>::value, "text_writer only formats arithmetic types");
+    make_room(max_number_size);
+    char* first = data_ + size_;
+    char* last = data_ + capacity;
+    if constexpr (std::is_same<T, bool>::value) {
+        *first++ = x ? '1' : '0';
+    }
+    // All three char types are printed as characters, not as numbers.
+    else if constexpr (std::is_same<T, char>::value || std::is_same<T, signed char>::value
+                       || std::is_same<T, unsigned char>::value) {
+        *first++ = static_cast<char>(x);
+    }
+    else if constexpr (std::is_integral<T>::value) {
+        first = std::to_chars(first, last, x).ptr;
+    }
+    else {
+        first = std::to_chars(first, last, x, std::chars_format::general, precision_).ptr;
+    }
+    size_ = first - data_;
+}
+
+#endif // !TEXT_WRITER_GENERIC_PROGRAMMING
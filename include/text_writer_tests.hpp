@@ -0,0 +1,12 @@
+#ifndef TEXT_WRITER_TESTS_GENERIC_PROGRAMMING
+#define TEXT_WRITER_TESTS_GENERIC_PROGRAMMING
+
+#include "text_writer.hpp"
+
+bool test_text_writer_numbers();
+
+bool test_text_writer_containers();
+
+void test_text_output_performance();
+
+#endif // !TEXT_WRITER_TESTS_GENERIC_PROGRAMMING
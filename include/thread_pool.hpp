@@ -0,0 +1,126 @@
+#ifndef THREAD_POOL_GENERIC_PROGRAMMING
+#define THREAD_POOL_GENERIC_PROGRAMMING
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// Work Stealing Thread Pool
+// Starting a thread is expensive (it is a system call and a new stack), so instead of creating threads for
+// every parallel operation we create a fixed number of them once and hand them work.
+// Every worker has its own queue of tasks. A worker takes tasks from the back of its own queue (the most recently
+// added work, whose data is likely still in its cache) and, when it runs out, steals from the front of the queues
+// of the other workers (the oldest work, which is usually the biggest piece left). Workers with nothing to do
+// sleep on a condition variable until a new task is submitted.
+// Tasks must not throw: there is nobody to catch the exception on a worker thread.
+class thread_pool {
+public:
+    // A thread_count of zero means "as many threads as the hardware supports".
+    explicit thread_pool(std::size_t thread_count = 0);
+
+    // A pool owns its threads, copying it makes no sense.
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    // Waits for the queued tasks to finish and joins all threads.
+    ~thread_pool();
+
+    std::size_t size() const
+    {
+        return workers_.size();
+    }
+
+    // Queue a task to be run by one of the workers at some point. Tasks submitted from a worker of this pool
+    // go to that worker's own queue, others are spread over the queues in turn.
+    void submit(std::function<void()> task);
+
+    // Runs one queued task on the calling thread, if there is one. Returns false if all queues were empty.
+    bool run_pending_task();
+
+    // True when called from one of the threads of this pool.
+    bool in_worker_thread() const;
+
+    // Calls f(i) for every i in [0, count) using all threads of the pool and returns when all calls are done.
+    // The indices are handed out one by one so a slow index does not hold up the others.
+    // It may be called from inside a task: the calling worker then takes part in the work and runs other
+    // tasks while it waits, instead of blocking a thread the pool needs.
+    template<typename F>
+    // requires Callable<F, std::size_t>{}
+    void parallel_for(std::size_t count, F f);
+
+private:
+    struct worker_queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    // Own queue first (from the back), then the others (from the front).
+    bool pop_task(std::size_t self, std::function<void()>& task);
+    void worker_loop(std::size_t index);
+
+    std::vector<std::unique_ptr<worker_queue>> queues_;
+    std::vector<std::thread> workers_;
+    std::atomic<std::size_t> next_queue_;
+    // Number of tasks sitting in the queues. Sleeping workers are woken up when it becomes positive.
+    std::size_t pending_;
+    std::mutex sleep_mutex_;
+    std::condition_variable task_available_;
+    bool stopping_;
+};
+
+template<typename F>
+void thread_pool::parallel_for(std::size_t count, F f)
+{
+    if (count == 0) {
+        return;
+    }
+    // All of this state lives on our stack. It is safe since we do not return before every helper is finished.
+    std::atomic<std::size_t> next { 0 };
+    std::size_t helpers = count < size() ? count : size();
+    std::size_t running = helpers;
+    std::mutex done_mutex;
+    std::condition_variable done;
+
+    auto work = [&]() {
+        for (std::size_t i = next++; i < count; i = next++) {
+            f(i);
+        }
+    };
+
+    for (std::size_t k = 0; k != helpers; ++k) {
+        submit([&]() {
+            work();
+            std::lock_guard<std::mutex> lock(done_mutex);
+            if (--running == 0) {
+                done.notify_one();
+            }
+        });
+    }
+
+    if (in_worker_thread()) {
+        // Nested use: help out and keep the pool busy until our helpers are done.
+        work();
+        for (;;) {
+            {
+                std::lock_guard<std::mutex> lock(done_mutex);
+                if (running == 0) {
+                    return;
+                }
+            }
+            if (!run_pending_task()) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(done_mutex);
+    done.wait(lock, [&]() { return running == 0; });
+}
+
+#endif // !THREAD_POOL_GENERIC_PROGRAMMING
@@ -0,0 +1,313 @@
+#ifndef TIMING_WHEEL_GENERIC_PROGRAMMING
+#define TIMING_WHEEL_GENERIC_PROGRAMMING
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+/// Hierarchical timing wheel
+// A server with a million connections has a million timeouts, nearly all of which are cancelled or pushed back
+// before they expire (every packet restarts the idle timeout of its connection). A priority queue of deadlines
+// costs O(log n) for every one of those operations, walks all over memory doing it, and cannot cancel at all
+// (the usual trick is to leave cancelled entries in and skip them when they come out).
+//
+// A timing wheel is a ring of slots, one per tick, like a clock face: a timer expiring k ticks from now goes in the
+// slot k places ahead of the current one, and every tick the current slot expires. Scheduling is indexing into an
+// array and cancelling is unlinking from a list: O(1), whatever the number of timers.
+// A single wheel needs as many slots as the longest timeout has ticks, so the wheel is hierarchical, like the
+// digits of a number: level 0 has a slot per tick, level 1 a slot per 256 ticks, level 2 per 65536 ticks...
+// A timer goes in the lowest level which can tell its deadline apart from now (the level of the highest digit in
+// which they differ), in the slot given by that digit of its deadline. Whenever a digit of now rolls over to zero,
+// the slot of the next level up which has just come due is emptied and its timers are put back in: they now go
+// to lower levels, closer to their deadline (this is called cascading). A timer cascades at most once per level,
+// and most are cancelled before they cascade at all. Deadlines too far away for the top level wait in an overflow
+// list which is looked at whenever the top level rolls over.
+// Each level is a fixed ring of 1 << SlotBits slots indexed by masking, like static_circular_buffer.
+// A bitmap per level marks the slots which may hold timers (cancelling does not bother to clear the mark; the
+// slot is found empty when its time comes). With it, advance jumps straight to the next tick at which something
+// can happen, instead of visiting every empty slot: the occupied slots of a level are always ahead of the current
+// digit, and those of lower levels come due first.
+//
+// The timers are intrusive: a timer_node lives inside the object it times out (a connection, typically, as a base
+// class or a member), and the slots are doubly linked lists through the nodes. The wheel allocates nothing after
+// construction, and touching a timer touches the memory of its owner, which the caller is about to use anyway.
+// Time is in ticks; how long a tick is (1 ms, 10 ms...) is up to the caller.
+
+struct timer_node {
+    timer_node* prev = nullptr;
+    timer_node* next = nullptr;
+    std::uint64_t deadline = 0;
+
+    bool scheduled() const
+    {
+        return next != nullptr;
+    }
+};
+
+// A circular doubly linked list of timer nodes, around a sentinel node which is never a timer.
+class timer_list {
+public:
+    timer_list()
+    {
+        head_.prev = head_.next = &head_;
+    }
+
+    // The nodes point at the sentinel, so the list cannot move.
+    timer_list(const timer_list&) = delete;
+    timer_list& operator=(const timer_list&) = delete;
+
+    bool empty() const
+    {
+        return head_.next == &head_;
+    }
+    // Walks the list.
+    std::size_t count() const
+    {
+        std::size_t n = 0;
+        for (const timer_node* t = head_.next; t != &head_; t = t->next) {
+            ++n;
+        }
+        return n;
+    }
+
+    void push_back(timer_node& t)
+    {
+        t.prev = head_.prev;
+        t.next = &head_;
+        head_.prev->next = &t;
+        head_.prev = &t;
+    }
+    // Takes the first node out of the list, or returns nullptr if there is none.
+    timer_node* pop_front()
+    {
+        if (empty()) {
+            return nullptr;
+        }
+        timer_node* t = head_.next;
+        // Not unlink(*t), which would go through t->prev: g++ 12 at -O2 loses track of the sentinel of a list
+        // allocated in a loop being the first node's prev, and miscompiles the usual drain loop.
+        head_.next = t->next;
+        t->next->prev = &head_;
+        t->prev = t->next = nullptr;
+        return t;
+    }
+    // Moves all of the nodes of other to the end of this list, in O(1).
+    void splice_back(timer_list& other)
+    {
+        if (other.empty()) {
+            return;
+        }
+        timer_node* first = other.head_.next;
+        timer_node* last = other.head_.prev;
+        first->prev = head_.prev;
+        head_.prev->next = first;
+        last->next = &head_;
+        head_.prev = last;
+        other.head_.prev = other.head_.next = &other.head_;
+    }
+
+    // Takes t out of whatever list it is in.
+    static void unlink(timer_node& t) // [[expects: t.scheduled()]]
+    {
+        t.prev->next = t.next;
+        t.next->prev = t.prev;
+        t.prev = t.next = nullptr;
+    }
+
+private:
+    timer_node head_;
+};
+
+template<int SlotBits = 8, int Levels = 4>
+class timing_wheel {
+    static_assert(SlotBits > 0 && Levels > 0 && SlotBits * Levels < 64, "the levels must fit in the 64 bit ticks");
+
+    static constexpr std::uint64_t slot_count = std::uint64_t(1) << SlotBits;
+    static constexpr std::uint64_t slot_mask = slot_count - 1;
+    static constexpr std::size_t mark_words = (slot_count + 63) / 64;
+public:
+    using size_type = std::size_t;
+
+    explicit timing_wheel(std::uint64_t now = 0)
+        : marks_ {}, now_(now), size_(0)
+    {}
+
+    timing_wheel(const timing_wheel&) = delete;
+    timing_wheel& operator=(const timing_wheel&) = delete;
+
+    std::uint64_t now() const
+    {
+        return now_;
+    }
+    // The number of timers waiting to expire.
+    size_type size() const
+    {
+        return size_;
+    }
+    bool empty() const
+    {
+        return size_ == 0;
+    }
+
+    // t expires after the given number of ticks (at least one: the earliest it can expire is the next tick).
+    // A timer which is already scheduled is moved, which is how timeouts are restarted.
+    void schedule(timer_node& t, std::uint64_t delay)
+    {
+        schedule_at(t, now_ + (delay == 0 ? 1 : delay));
+    }
+    void schedule_at(timer_node& t, std::uint64_t deadline)
+    {
+        cancel(t);
+        t.deadline = deadline > now_ ? deadline : now_ + 1;
+        insert(t);
+        ++size_;
+    }
+
+    // Returns false if t was not scheduled. It may be called from the expiry callback, for any timer.
+    bool cancel(timer_node& t)
+    {
+        if (!t.scheduled()) {
+            return false;
+        }
+        timer_list::unlink(t);
+        // Timers in the batch being expired are no longer counted.
+        if (t.deadline > now_) {
+            --size_;
+        }
+        return true;
+    }
+
+    // Moves the time forward by the given number of ticks. For every tick in which timers expire, on_expired is
+    // called once with the list of those timers. It takes them out with pop_front (and may schedule them again,
+    // or schedule and cancel any other timer); whatever it leaves in the list is unscheduled afterwards.
+    // Returns the number of timers which expired.
+    template<typename F>
+    // requires Callable<F, timer_list&>{}
+    size_type advance(std::uint64_t ticks, F on_expired)
+    {
+        size_type expired = 0;
+        const std::uint64_t end = now_ + ticks;
+        while (now_ != end) {
+            // Nothing happens in the ticks in between.
+            std::uint64_t next = size_ == 0 ? end : next_event();
+            if (next > end) {
+                now_ = end;
+                break;
+            }
+            now_ = next;
+            if ((now_ & slot_mask) == 0) {
+                cascade();
+            }
+            take_slot(0, now_ & slot_mask, batch_);
+            if (batch_.empty()) {
+                continue;
+            }
+            size_type n = batch_.count();
+            size_ -= n;
+            expired += n;
+            on_expired(batch_);
+            while (batch_.pop_front() != nullptr) {}
+        }
+        return expired;
+    }
+
+private:
+    // The level of a deadline: the highest digit (of SlotBits bits) in which it differs from now.
+    // Levels means the overflow list.
+    int level_of(std::uint64_t deadline) const // [[expects: deadline > now_]]
+    {
+        int level = (std::bit_width(deadline ^ now_) - 1) / SlotBits;
+        return level < Levels ? level : Levels;
+    }
+
+    void insert(timer_node& t)
+    {
+        if (t.deadline == now_) {
+            // Only while cascading: the timer expires in this very tick.
+            batch_.push_back(t);
+            return;
+        }
+        int level = level_of(t.deadline);
+        if (level == Levels) {
+            overflow_.push_back(t);
+        }
+        else {
+            std::uint64_t slot = (t.deadline >> (SlotBits * level)) & slot_mask;
+            levels_[level][slot].push_back(t);
+            marks_[level][slot / 64] |= std::uint64_t(1) << (slot % 64);
+        }
+    }
+
+    // Moves the timers of a slot to out and clears its mark.
+    void take_slot(int level, std::uint64_t slot, timer_list& out)
+    {
+        out.splice_back(levels_[level][slot]);
+        marks_[level][slot / 64] &= ~(std::uint64_t(1) << (slot % 64));
+    }
+
+    // The first marked slot of the level from index first on, or slot_count if there is none.
+    std::uint64_t first_marked(int level, std::uint64_t first) const
+    {
+        for (std::size_t w = first / 64; w < mark_words; ++w) {
+            std::uint64_t bits = marks_[level][w];
+            if (w == first / 64) {
+                bits &= ~std::uint64_t(0) << (first % 64);
+            }
+            if (bits != 0) {
+                return w * 64 + std::countr_zero(bits);
+            }
+        }
+        return slot_count;
+    }
+
+    // The next tick at which a timer may expire or a slot may cascade (always after now).
+    std::uint64_t next_event() const
+    {
+        for (int level = 0; level != Levels; ++level) {
+            int shift = SlotBits * level;
+            std::uint64_t slot = first_marked(level, ((now_ >> shift) & slot_mask) + 1);
+            if (slot != slot_count) {
+                return (now_ >> (shift + SlotBits) << (shift + SlotBits)) | (slot << shift);
+            }
+        }
+        if (!overflow_.empty()) {
+            return ((now_ >> (SlotBits * Levels)) + 1) << (SlotBits * Levels);
+        }
+        return std::numeric_limits<std::uint64_t>::max();
+    }
+
+    // Called when the lowest digit of now has rolled over to zero. Every level whose lower digits are all zero
+    // has come to a new slot; those are emptied from the highest level down, so that timers can fall through
+    // more than one level in the same tick.
+    void cascade()
+    {
+        int top = 1;
+        while (top < Levels && (now_ & ((std::uint64_t(1) << (SlotBits * (top + 1))) - 1)) == 0) {
+            ++top;
+        }
+        for (int level = top; level >= 1; --level) {
+            timer_list due;
+            if (level == Levels) {
+                due.splice_back(overflow_);
+            }
+            else {
+                take_slot(level, (now_ >> (SlotBits * level)) & slot_mask, due);
+            }
+            while (timer_node* t = due.pop_front()) {
+                insert(*t);
+            }
+        }
+    }
+
+    std::array<std::array<timer_list, slot_count>, Levels> levels_;
+    std::array<std::array<std::uint64_t, mark_words>, Levels> marks_;
+    timer_list overflow_;
+    // The timers expiring in the current tick.
+    timer_list batch_;
+    std::uint64_t now_;
+    size_type size_;
+};
+
+#endif // !TIMING_WHEEL_GENERIC_PROGRAMMING
@@ -0,0 +1,12 @@
+#ifndef TIMING_WHEEL_TESTS_GENERIC_PROGRAMMING
+#define TIMING_WHEEL_TESTS_GENERIC_PROGRAMMING
+
+#include "timing_wheel.hpp"
+
+bool test_timing_wheel();
+
+bool test_timing_wheel_random();
+
+void test_timing_wheel_performance();
+
+#endif // !TIMING_WHEEL_TESTS_GENERIC_PROGRAMMING
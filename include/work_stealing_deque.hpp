@@ -0,0 +1,170 @@
+#ifndef WORK_STEALING_DEQUE_GENERIC_PROGRAMMING
+#define WORK_STEALING_DEQUE_GENERIC_PROGRAMMING
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+/// Lock free work stealing deque
+// The queue of a work stealing scheduler is used in a very lopsided way. Its owner pushes and pops at the bottom
+// all the time (every spawn and most syncs), other threads only steal from the top when they run out of work,
+// which should be rare. The mutex of thread_pool's queues makes the owner pay for a lock on every operation
+// just in case a thief shows up.
+// Chase and Lev's deque makes the owner's operations plain loads and stores in the common case. The elements are
+// in a circular array like circular_buffer's, between two ever growing indices: top (where thieves take) and
+// bottom (where the owner pushes and pops), so an element's slot is its index masked by the capacity.
+// Only the owner writes bottom and only a compare and swap on top takes an element from the top, so the two
+// sides only have to agree when they go after the same, last, element: then the owner also uses the compare and
+// swap and exactly one of them wins.
+// When the array is full the owner copies the elements into one twice as big. A thief may still be reading the
+// old array, so it is kept until the deque is destroyed (the arrays only ever double, so all of them together
+// are less than twice the size of the last one).
+// The memory orderings are those of Le, Pop, Cohen and Zappa Nardelli, "Correct and Efficient Work-Stealing for
+// Weak Memory Models" (2013), except that push publishes with a release store instead of a release fence followed
+// by a relaxed store: the same instructions, but thread sanitizer understands it.
+//
+// The elements are read by thieves while the owner may be overwriting their slot (the thief then loses the
+// compare and swap and throws what it read away), so the slots are atomic and T must be trivially copyable and
+// small: pointers to tasks, typically.
+
+template<typename T>
+// requires TriviallyCopyable<T>{}
+class work_stealing_deque {
+    static_assert(std::is_trivially_copyable<T>::value, "the slots of a work_stealing_deque are atomic");
+
+    struct ring_array {
+        explicit ring_array(std::int64_t capacity) // [[expects: capacity is a power of two]]
+            : mask(capacity - 1), slots(new std::atomic<T>[static_cast<std::size_t>(capacity)])
+        {}
+
+        std::int64_t capacity() const
+        {
+            return mask + 1;
+        }
+        T get(std::int64_t i) const
+        {
+            return slots[static_cast<std::size_t>(i & mask)].load(std::memory_order_relaxed);
+        }
+        void put(std::int64_t i, T x)
+        {
+            slots[static_cast<std::size_t>(i & mask)].store(x, std::memory_order_relaxed);
+        }
+
+        std::int64_t mask;
+        std::unique_ptr<std::atomic<T>[]> slots;
+    };
+
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+
+    // The capacity is rounded up to a power of two; the deque grows past it when needed.
+    explicit work_stealing_deque(size_type capacity = 256)
+        : top_(0), bottom_(0)
+    {
+        arrays_.push_back(std::make_unique<ring_array>(static_cast<std::int64_t>(std::bit_ceil(capacity))));
+        array_.store(arrays_.back().get(), std::memory_order_relaxed);
+    }
+
+    work_stealing_deque(const work_stealing_deque&) = delete;
+    work_stealing_deque& operator=(const work_stealing_deque&) = delete;
+
+    /// Owner side
+    // Only the thread owning the deque may push and pop.
+
+    void push(T x)
+    {
+        std::int64_t b = bottom_.load(std::memory_order_relaxed);
+        std::int64_t t = top_.load(std::memory_order_acquire);
+        ring_array* a = array_.load(std::memory_order_relaxed);
+        if (b - t > a->capacity() - 1) {
+            a = grow(a, t, b);
+        }
+        a->put(b, x);
+        // A thief that sees the new bottom must see the element too (and whatever it points to).
+        bottom_.store(b + 1, std::memory_order_release);
+    }
+
+    // Takes the most recently pushed element. Returns false if the deque is empty (or a thief got the last one).
+    bool pop(T& x)
+    {
+        std::int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+        ring_array* a = array_.load(std::memory_order_relaxed);
+        bottom_.store(b, std::memory_order_relaxed);
+        // Thieves must see the smaller bottom before we look at top, or we could both take the same element.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t t = top_.load(std::memory_order_relaxed);
+        if (t > b) {
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+        x = a->get(b);
+        if (t == b) {
+            // The last element: race the thieves for it.
+            bool won = top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    /// Thief side
+    // Any thread may steal, at any time.
+
+    // Takes the oldest element. Returns false if the deque is empty or another thread took the element first
+    // (then trying again may succeed).
+    bool steal(T& x)
+    {
+        std::int64_t t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t b = bottom_.load(std::memory_order_acquire);
+        if (t >= b) {
+            return false;
+        }
+        ring_array* a = array_.load(std::memory_order_acquire);
+        x = a->get(t);
+        return top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    }
+
+    // Only a hint when other threads are using the deque.
+    size_type size() const
+    {
+        std::int64_t b = bottom_.load(std::memory_order_relaxed);
+        std::int64_t t = top_.load(std::memory_order_relaxed);
+        return b > t ? static_cast<size_type>(b - t) : 0;
+    }
+    bool empty() const
+    {
+        return size() == 0;
+    }
+    size_type capacity() const
+    {
+        return static_cast<size_type>(array_.load(std::memory_order_relaxed)->capacity());
+    }
+
+private:
+    // Called by the owner only.
+    ring_array* grow(ring_array* a, std::int64_t t, std::int64_t b)
+    {
+        arrays_.push_back(std::make_unique<ring_array>(2 * a->capacity()));
+        ring_array* bigger = arrays_.back().get();
+        for (std::int64_t i = t; i != b; ++i) {
+            bigger->put(i, a->get(i));
+        }
+        array_.store(bigger, std::memory_order_release);
+        return bigger;
+    }
+
+    // Thieves hammer top_ while the owner works on bottom_: keep them on separate cache lines.
+    alignas(64) std::atomic<std::int64_t> top_;
+    alignas(64) std::atomic<std::int64_t> bottom_;
+    std::atomic<ring_array*> array_;
+    // Every array the deque has had, the current one last. Only the owner touches the vector.
+    std::vector<std::unique_ptr<ring_array>> arrays_;
+};
+
+#endif // !WORK_STEALING_DEQUE_GENERIC_PROGRAMMING
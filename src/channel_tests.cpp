@@ -0,0 +1,322 @@
+#include "channel_tests.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+#include "channel.hpp"
+#include "circular_buffer.hpp"
+#include "executors.hpp"
+
+using std::cout;
+
+namespace {
+
+template<typename Channel>
+async_task produce(Channel& ch, int first, int count, std::atomic<int>& done)
+{
+    for (int i = first; i != first + count; ++i) {
+        co_await ch.push(i);
+    }
+    ++done;
+}
+
+// Adds up what it gets until the channel is closed.
+template<typename Channel>
+async_task consume(Channel& ch, long long& sum, std::atomic<int>& done)
+{
+    while (std::optional<int> x = co_await ch.pop()) {
+        sum += *x;
+    }
+    ++done;
+}
+
+// Records the order of the elements.
+async_task record(channel<int, null_mutex>& ch, std::vector<int>& out, int count)
+{
+    for (int i = 0; i != count; ++i) {
+        std::optional<int> x = co_await ch.pop();
+        out.push_back(x ? *x : -1);
+    }
+}
+
+// Ping-pong: one round trip is a message to the other side and its answer.
+template<typename Channel>
+async_task ping(Channel& to, Channel& from, int rounds, std::atomic<int>& done)
+{
+    for (int i = 0; i != rounds; ++i) {
+        co_await to.push(i);
+        co_await from.pop();
+    }
+    to.close();
+    ++done;
+}
+
+template<typename Channel>
+async_task pong(Channel& from, Channel& to, std::atomic<int>& done)
+{
+    while (std::optional<int> x = co_await from.pop()) {
+        co_await to.push(*x);
+    }
+    ++done;
+}
+
+void wait_for(const std::atomic<int>& done, int n)
+{
+    while (done.load() != n) {
+        std::this_thread::yield();
+    }
+}
+
+// What we compare against: a circular_buffer behind a mutex, with threads blocking on condition variables.
+class blocking_queue {
+public:
+    explicit blocking_queue(std::size_t capacity)
+        : buffer_(capacity)
+    {}
+
+    void push(int x)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [&]() { return buffer_.size() != buffer_.capacity(); });
+        buffer_.push_back(x);
+        lock.unlock();
+        not_empty_.notify_one();
+    }
+    int pop()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [&]() { return !buffer_.empty(); });
+        int x = buffer_.front();
+        buffer_.pop_front();
+        lock.unlock();
+        not_full_.notify_one();
+        return x;
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable not_full_;
+    std::condition_variable not_empty_;
+    circular_buffer<int> buffer_;
+};
+
+double nanoseconds_per(std::chrono::high_resolution_clock::duration d, long long n)
+{
+    return std::chrono::duration_cast<std::chrono::duration<double, std::nano>>(d).count() / n;
+}
+
+}
+
+bool test_channel()
+{
+    bool result = true;
+    manual_executor exec;
+    channel<int, null_mutex> ch(4, exec);
+
+    // The producer fills the channel and waits; the consumer gets everything in order.
+    std::atomic<int> done { 0 };
+    spawn(exec, produce(ch, 0, 10, done));
+    exec.run();
+    result = result && ch.size() == 4 && done == 0;
+    std::vector<int> out;
+    spawn(exec, record(ch, out, 10));
+    exec.run();
+    result = result && done == 1 && ch.size() == 0 && out == std::vector<int> { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+
+    // A waiting consumer gets the element handed over directly.
+    out.clear();
+    spawn(exec, record(ch, out, 2));
+    exec.run();
+    spawn(exec, produce(ch, 100, 2, done));
+    exec.run();
+    result = result && out == std::vector<int> { 100, 101 } && ch.size() == 0 && done == 2;
+
+    // Closing wakes up the consumers, after they have drained the channel.
+    long long sum = 0;
+    spawn(exec, produce(ch, 1, 3, done));
+    spawn(exec, consume(ch, sum, done));
+    exec.run();
+    result = result && sum == 6 && done == 3;
+    ch.close();
+    exec.run();
+    result = result && done == 4;
+
+    // Pushing into a closed channel fails.
+    bool pushed = true;
+    auto try_push = [](channel<int, null_mutex>& c, bool& ok) -> async_task {
+        ok = co_await c.push(1);
+    };
+    spawn(exec, try_push(ch, pushed));
+    exec.run();
+    result = result && !pushed;
+
+    // Move-only elements: into the buffer, into the place a pop frees for a waiting push, and handed over to a
+    // waiting pop.
+    channel<std::unique_ptr<int>, null_mutex> owners(1, exec);
+    auto push_owned = [](channel<std::unique_ptr<int>, null_mutex>& c, int first, int count) -> async_task {
+        for (int i = first; i != first + count; ++i) {
+            co_await c.push(std::make_unique<int>(i));
+        }
+    };
+    auto pop_owned = [](channel<std::unique_ptr<int>, null_mutex>& c, std::vector<int>& values,
+                        int count) -> async_task {
+        for (int i = 0; i != count; ++i) {
+            std::optional<std::unique_ptr<int>> x = co_await c.pop();
+            values.push_back(x && *x ? **x : -1);
+        }
+    };
+    out.clear();
+    spawn(exec, push_owned(owners, 1, 2));
+    exec.run();
+    spawn(exec, pop_owned(owners, out, 3));
+    exec.run();
+    spawn(exec, push_owned(owners, 3, 1));
+    exec.run();
+    result = result && out == std::vector<int> { 1, 2, 3 } && owners.size() == 0;
+
+    // Ping-pong on one thread.
+    channel<int, null_mutex> a(1, exec);
+    channel<int, null_mutex> b(1, exec);
+    done = 0;
+    spawn(exec, ping(a, b, 1000, done));
+    spawn(exec, pong(a, b, done));
+    exec.run();
+    result = result && done == 2;
+    return result;
+}
+
+bool test_channel_threaded()
+{
+    const int producers = 4;
+    const int consumers = 3;
+    const int per_producer = 100'000;
+    std::vector<long long> sums(consumers, 0);
+    std::atomic<int> produced { 0 };
+    std::atomic<int> consumed { 0 };
+    {
+        threaded_executor exec(4);
+        channel<int> ch(16, exec);
+        for (int c = 0; c != consumers; ++c) {
+            spawn(exec, consume(ch, sums[c], consumed));
+        }
+        for (int p = 0; p != producers; ++p) {
+            spawn(exec, produce(ch, p * per_producer, per_producer, produced));
+        }
+        wait_for(produced, producers);
+        ch.close();
+        wait_for(consumed, consumers);
+    }
+    long long n = static_cast<long long>(producers) * per_producer;
+    long long total = 0;
+    for (long long s : sums) {
+        total += s;
+    }
+    return total == n * (n - 1) / 2;
+}
+
+void test_channel_performance()
+{
+    using namespace std::chrono;
+    high_resolution_clock clock {};
+    const int rounds = 200'000;
+    const int messages = 5'000'000;
+
+    // Ping-pong latency: the time of a round trip.
+    {
+        manual_executor exec;
+        channel<int, null_mutex> a(1, exec);
+        channel<int, null_mutex> b(1, exec);
+        std::atomic<int> done { 0 };
+        auto start = clock.now();
+        spawn(exec, ping(a, b, rounds, done));
+        spawn(exec, pong(a, b, done));
+        exec.run();
+        cout << "Ping-pong, coroutines on manual_executor: " << nanoseconds_per(clock.now() - start, rounds)
+             << " ns per round trip\n";
+    }
+    {
+        threaded_executor exec(2);
+        channel<int> a(1, exec);
+        channel<int> b(1, exec);
+        std::atomic<int> done { 0 };
+        auto start = clock.now();
+        spawn(exec, ping(a, b, rounds, done));
+        spawn(exec, pong(a, b, done));
+        wait_for(done, 2);
+        cout << "Ping-pong, coroutines on threaded_executor(2): " << nanoseconds_per(clock.now() - start, rounds)
+             << " ns per round trip\n";
+    }
+    {
+        blocking_queue a(1);
+        blocking_queue b(1);
+        auto start = clock.now();
+        std::thread other([&]() {
+            for (int i = 0; i != rounds; ++i) {
+                b.push(a.pop());
+            }
+        });
+        for (int i = 0; i != rounds; ++i) {
+            a.push(i);
+            b.pop();
+        }
+        other.join();
+        cout << "Ping-pong, threads on mutex + condition variable queues: "
+             << nanoseconds_per(clock.now() - start, rounds) << " ns per round trip\n";
+    }
+
+    // Throughput: one producer, one consumer, a channel of 1024.
+    long long expected = static_cast<long long>(messages) * (messages - 1) / 2;
+    {
+        manual_executor exec;
+        channel<int, null_mutex> ch(1024, exec);
+        std::atomic<int> done { 0 };
+        long long sum = 0;
+        auto start = clock.now();
+        spawn(exec, consume(ch, sum, done));
+        spawn(exec, produce(ch, 0, messages, done));
+        exec.run();
+        ch.close();
+        exec.run();
+        cout << "Throughput, manual_executor: " << nanoseconds_per(clock.now() - start, messages) << " ns per message"
+             << (sum == expected ? "" : " WRONG RESULT") << "\n";
+    }
+    {
+        long long sum = 0;
+        std::atomic<int> done { 0 };
+        auto start = clock.now();
+        {
+            threaded_executor exec(2);
+            channel<int> ch(1024, exec);
+            spawn(exec, consume(ch, sum, done));
+            spawn(exec, produce(ch, 0, messages, done));
+            wait_for(done, 1);
+            ch.close();
+            wait_for(done, 2);
+        }
+        cout << "Throughput, threaded_executor(2): " << nanoseconds_per(clock.now() - start, messages)
+             << " ns per message" << (sum == expected ? "" : " WRONG RESULT") << "\n";
+    }
+    {
+        blocking_queue q(1024);
+        long long sum = 0;
+        auto start = clock.now();
+        std::thread consumer([&]() {
+            for (int i = 0; i != messages; ++i) {
+                sum += q.pop();
+            }
+        });
+        for (int i = 0; i != messages; ++i) {
+            q.push(i);
+        }
+        consumer.join();
+        cout << "Throughput, threads on a mutex + condition variable queue: "
+             << nanoseconds_per(clock.now() - start, messages) << " ns per message"
+             << (sum == expected ? "" : " WRONG RESULT") << "\n";
+    }
+}
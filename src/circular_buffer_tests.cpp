@@ -2,7 +2,11 @@
 
 #include <iostream>
 #include <chrono>
+#include <memory>
+#include <string>
 #include "circular_buffer.hpp"
+#include "static_circular_buffer.hpp"
+#include "soa_circular_buffer.hpp"
 
 using std::cout;
 
@@ -410,3 +414,424 @@ bool test_circular_buffer_iterator_movement()
     //
     return result;
 }
+
+
+/// Compile time tests for static_circular_buffer
+// Each helper pushes some elements through a ring inside a constexpr function. If any of them did
+// something not allowed during constant evaluation the static_asserts bellow would fail to compile.
+
+constexpr int static_ring_sum_after_overflow()
+{
+    static_circular_buffer<int, 4> ring;
+    for (int i = 1; i <= 6; ++i) {
+        ring.push_back(i);
+    }
+    // Only 3, 4, 5, 6 remain.
+    int sum = 0;
+    for (int x : ring) {
+        sum += x;
+    }
+    return sum;
+}
+
+constexpr bool static_ring_push_pop_and_index()
+{
+    static_circular_buffer<int, 3> ring;
+    bool result = ring.empty() && ring.capacity() == 3;
+    ring.push_back(1);
+    ring.push_back(2);
+    ring.push_back(3);
+    result = result && ring.full() && ring[0] == 1 && ring[2] == 3;
+    ring.push_back(4);
+    result = result && ring.front() == 2 && ring.back() == 4 && ring[1] == 3;
+    ring.pop_front();
+    result = result && ring.size() == 2 && ring.front() == 3;
+    ring[0] = 10;
+    result = result && ring.front() == 10;
+    ring.pop_front();
+    ring.pop_front();
+    return result && ring.empty();
+}
+
+// A lookup table of moving averages over a window of W samples of a (made up) signal.
+// This is the kind of table that we used to fill at start up by running samples through a ring.
+template<int Size>
+struct moving_average_table {
+    int values[Size];
+};
+
+constexpr int table_signal(int i)
+{
+    return (i * i + 7 * i) % 251;
+}
+
+template<int Size, std::size_t W>
+constexpr moving_average_table<Size> make_moving_average_table()
+{
+    moving_average_table<Size> table {};
+    static_circular_buffer<int, W> window;
+    int sum = 0;
+    for (int i = 0; i != Size; ++i) {
+        if (window.full()) {
+            sum -= window.front();
+        }
+        int sample = table_signal(i);
+        window.push_back(sample);
+        sum += sample;
+        table.values[i] = sum / static_cast<int>(window.size());
+    }
+    return table;
+}
+
+static_assert(static_ring_sum_after_overflow() == 3 + 4 + 5 + 6, "static_circular_buffer overflow");
+static_assert(static_ring_push_pop_and_index(), "static_circular_buffer push/pop/index");
+static_assert(make_moving_average_table<4, 2>().values[0] == 0, "moving average table first entry");
+static_assert(make_moving_average_table<4, 2>().values[3] == (table_signal(2) + table_signal(3)) / 2,
+              "moving average table windowed entry");
+
+constexpr int startup_table_size = 4096;
+constexpr std::size_t startup_table_window = 16;
+
+// Same computation as make_moving_average_table but done at run time (like we used to at start up).
+moving_average_table<startup_table_size> make_moving_average_table_at_runtime(int offset)
+{
+    moving_average_table<startup_table_size> table {};
+    static_circular_buffer<int, startup_table_window> window;
+    int sum = 0;
+    for (int i = 0; i != startup_table_size; ++i) {
+        if (window.full()) {
+            sum -= window.front();
+        }
+        int sample = table_signal(i + offset);
+        window.push_back(sample);
+        sum += sample;
+        table.values[i] = sum / static_cast<int>(window.size());
+    }
+    return table;
+}
+
+bool test_static_circular_buffer()
+{
+    bool result = true;
+
+    static_circular_buffer<int, 5> ring;
+    for (int i = 0; i < 12; ++i) {
+        ring.push_back(i);
+    }
+    int expected = 7;
+    for (auto it = ring.begin(); it != ring.end(); ++it) {
+        result = result && *it == expected;
+        ++expected;
+    }
+    result = result && ring.size() == 5 && ring.front() == 7 && ring.back() == 11;
+
+    // The table computed by the compiler must match the one computed at run time.
+    constexpr auto table = make_moving_average_table<startup_table_size, startup_table_window>();
+    auto runtime_table = make_moving_average_table_at_runtime(0);
+    for (int i = 0; i != startup_table_size; ++i) {
+        result = result && table.values[i] == runtime_table.values[i];
+    }
+
+    return result;
+}
+
+void test_static_circular_buffer_startup_performance()
+{
+    using namespace std::chrono;
+
+    const int repetitions = 1'000;
+    // Keep the results alive so the optimizer does not throw the work away.
+    volatile int sink = 0;
+    // The offset is always zero, but it is read from a volatile on every repetition, so the compiler cannot
+    // assume that and compute the table once (sink & 0 would not do: it is folded to zero).
+    volatile int offset = 0;
+
+    high_resolution_clock clock {};
+    auto t1 = clock.now();
+
+    for (int i = 0; i < repetitions; ++i) {
+        auto table = make_moving_average_table_at_runtime(offset);
+        sink = sink + table.values[i % startup_table_size];
+    }
+
+    auto t2 = clock.now();
+    auto delta_1 = t2 - t1;
+    cout << "Time for building " << repetitions << " tables at start up: "
+         << duration_cast<microseconds>(delta_1).count() << " us\n\n";
+
+    auto t3 = clock.now();
+
+    for (int i = 0; i < repetitions; ++i) {
+        static constexpr auto table = make_moving_average_table<startup_table_size, startup_table_window>();
+        sink = sink + table.values[i % startup_table_size];
+    }
+
+    auto t4 = clock.now();
+    auto delta_2 = t4 - t3;
+    cout << "Time for using " << repetitions << " compile time tables: "
+         << duration_cast<microseconds>(delta_2).count() << " us\n\n";
+}
+
+bool test_soa_circular_buffer()
+{
+    bool result = true;
+
+    soa_circular_buffer<color_rgba> cbuf(4);
+    for (int i = 0; i < 6; ++i) {
+        cbuf.push_back(make_color_rgba(i, 10 * i, 20 * i, 255));
+    }
+    // Only colors 2, 3, 4, 5 remain and the storage has wrapped around.
+    result = result && cbuf.size() == 4;
+    for (int i = 0; i < 4; ++i) {
+        color_rgba c = cbuf[i];
+        result = result && c.r == i + 2 && c.g == 10 * (i + 2) && c.b == 20 * (i + 2) && c.a == 255;
+    }
+
+    // The proxy can be assigned whole elements, modified through the color operators and
+    // used to access single fields.
+    cbuf[0] = make_color_rgba(1, 2, 3, 4);
+    cbuf[1] += make_color_rgba(250, 250, 250, 0);
+    get<3>(cbuf[2]) = 7;
+    color_rgba first = cbuf.front();
+    color_rgba second = cbuf[1];
+    result = result && first.r == 1 && first.g == 2 && first.b == 3 && first.a == 4;
+    result = result && second.r == 253 && second.g == 255 && second.b == 255 && second.a == 255;
+    result = result && cbuf[2].get<3>() == 7;
+
+    // The two channel segments hold the red values of all elements in order.
+    int expected_red[] = { 1, 253, 4, 5 };
+    int k = 0;
+    for (unsigned char r : cbuf.channel_one<0>()) {
+        result = result && r == expected_red[k++];
+    }
+    for (unsigned char r : cbuf.channel_two<0>()) {
+        result = result && r == expected_red[k++];
+    }
+    result = result && k == 4 && cbuf.channel_one<0>().size() == 2 && cbuf.channel_two<0>().size() == 2;
+
+    soa_circular_buffer<color_rgba> copy(cbuf);
+    cbuf.pop_front();
+    result = result && cbuf.size() == 3 && copy.size() == 4;
+    int j = 0;
+    for (auto ref : copy) {
+        color_rgba c = ref;
+        result = result && c.r == expected_red[j++];
+    }
+
+    return result;
+}
+
+void test_soa_circular_buffer_channel_performance()
+{
+    using namespace std::chrono;
+
+    const std::size_t count = 1 << 20;
+    const int repetitions = 200;
+
+    circular_buffer<color_rgba> aos(count);
+    soa_circular_buffer<color_rgba> soa(count);
+    // Push more than the capacity so that both buffers have wrapped around.
+    for (std::size_t i = 0; i < count + count / 3; ++i) {
+        color_rgba c = make_color_rgba(i % 256, (i / 3) % 256, (i * 7) % 256, 255);
+        aos.push_back(c);
+        soa.push_back(c);
+    }
+
+    high_resolution_clock clock {};
+    unsigned long long aos_sum = 0;
+    auto t1 = clock.now();
+
+    for (int k = 0; k < repetitions; ++k) {
+        for (std::size_t i = 0; i != aos.size(); ++i) {
+            aos_sum += aos[i].r;
+        }
+    }
+
+    auto t2 = clock.now();
+    auto delta_1 = t2 - t1;
+    cout << "Time for summing the red channel of circular_buffer<color_rgba>: "
+         << duration_cast<milliseconds>(delta_1).count() << " ms\n\n";
+
+    unsigned long long soa_sum = 0;
+    auto t3 = clock.now();
+
+    for (int k = 0; k < repetitions; ++k) {
+        for (unsigned char r : soa.channel_one<0>()) {
+            soa_sum += r;
+        }
+        for (unsigned char r : soa.channel_two<0>()) {
+            soa_sum += r;
+        }
+    }
+
+    auto t4 = clock.now();
+    auto delta_2 = t4 - t3;
+    cout << "Time for summing the red channel of soa_circular_buffer<color_rgba>: "
+         << duration_cast<milliseconds>(delta_2).count() << " ms\n\n";
+
+    cout << "Sums match: " << std::boolalpha << (aos_sum == soa_sum) << "\n\n";
+}
+
+namespace {
+
+// Owns an int on the heap and copies it deeply, so it is not trivially copyable. Its bytes are just a pointer
+// though, so it can say it is trivially relocatable. It counts its copies so we can see that reserve does none.
+struct owned_int {
+    static int copies;
+
+    std::unique_ptr<int> p;
+
+    owned_int()
+        : p(new int(0))
+    {}
+    explicit owned_int(int x)
+        : p(new int(x))
+    {}
+    owned_int(const owned_int& other)
+        : p(new int(*other.p))
+    {
+        ++copies;
+    }
+    owned_int& operator=(const owned_int& other)
+    {
+        *p = *other.p;
+        ++copies;
+        return *this;
+    }
+};
+
+int owned_int::copies = 0;
+
+// Element number i of a test ring.
+template<typename T>
+T element_from(int i)
+{
+    return T(i);
+}
+
+template<>
+color_rgba element_from<color_rgba>(int i)
+{
+    return make_color_rgba(i % 256, (i / 3) % 256, (i * 7) % 256, 255);
+}
+
+// The same bytes as T, but with a hand written assignment, so it takes the element by element path.
+template<typename T>
+struct element_wise {
+    T value;
+
+    element_wise() = default;
+    explicit element_wise(int i)
+        : value(element_from<T>(i))
+    {}
+    element_wise& operator=(const element_wise& other)
+    {
+        value = other.value;
+        return *this;
+    }
+};
+
+template<typename T>
+circular_buffer<T> wrapped_ring(std::size_t capacity, std::size_t n)
+{
+    circular_buffer<T> cb(capacity);
+    for (std::size_t i = 0; i != capacity / 2 + n; ++i) {
+        cb.push_back(element_from<T>(static_cast<int>(i)));
+    }
+    while (cb.size() > n) {
+        cb.pop_front();
+    }
+    return cb;
+}
+
+}
+
+template<>
+struct is_trivially_relocatable<owned_int> : std::true_type {};
+
+bool test_circular_buffer_bulk_copy()
+{
+    bool result = true;
+
+    // A copy keeps the layout, wrap around included.
+    circular_buffer<int> ints = wrapped_ring<int>(10, 8);
+    circular_buffer<int> ints_copy(ints);
+    result = result && ints.array_two().size() != 0 && ints_copy.size() == 8 && ints_copy.array_two().size() != 0;
+    for (std::size_t i = 0; i != 8; ++i) {
+        result = result && ints_copy[i] == ints[i];
+    }
+    ints.reserve(30);
+    result = result && ints.capacity() == 30 && ints.array_two().empty();
+    for (std::size_t i = 0; i != 8; ++i) {
+        result = result && ints[i] == ints_copy[i];
+    }
+
+    circular_buffer<color_rgba> colors(3);
+    colors.push_back(make_color_rgba(1, 2, 3, 4));
+    colors.push_back(make_color_rgba(5, 6, 7, 8));
+    colors.push_back(make_color_rgba(9, 10, 11, 12));
+    colors.push_back(make_color_rgba(13, 14, 15, 16));
+    circular_buffer<color_rgba> colors_copy = colors;
+    colors_copy.reserve(5);
+    result = result && colors_copy.size() == 3 && colors_copy[0].r == 5 && colors_copy[2].a == 16;
+
+    // Relocating owned_int swaps its bytes: no copies, nothing leaked or freed twice.
+    circular_buffer<owned_int> owned = wrapped_ring<owned_int>(6, 5);
+    owned_int::copies = 0;
+    owned.reserve(12);
+    result = result && owned_int::copies == 0 && owned.size() == 5;
+    for (std::size_t i = 0; i != 5; ++i) {
+        result = result && *owned[i].p == static_cast<int>(i) + 3;
+    }
+    circular_buffer<owned_int> owned_copy(owned);
+    result = result && owned_int::copies == 5 && *owned_copy[4].p == *owned[4].p && owned_copy[4].p != owned[4].p;
+
+    // Strings are neither, they are moved one by one.
+    circular_buffer<std::string> strings(2);
+    strings.push_back(std::string(100, 'a'));
+    strings.push_back(std::string(100, 'b'));
+    strings.push_back(std::string(100, 'c'));
+    strings.reserve(4);
+    result = result && strings[0] == std::string(100, 'b') && strings[1] == std::string(100, 'c');
+
+    return result;
+}
+
+namespace {
+
+template<typename T>
+void ring_copy_performance(const char* name)
+{
+    using namespace std::chrono;
+
+    high_resolution_clock clock {};
+    for (std::size_t n = 1000; n <= 100'000'000; n *= 10) {
+        const std::size_t repetitions = 100'000'000 / n;
+        long long ms[2] = { 0, 0 };
+        std::size_t check = 0;
+        auto time_copies = [&](auto ring, long long& elapsed) {
+            auto t1 = clock.now();
+            for (std::size_t r = 0; r != repetitions; ++r) {
+                decltype(ring) copy(ring);
+                copy.reserve(copy.capacity() + 1);
+                check += copy.size();
+            }
+            elapsed = duration_cast<milliseconds>(clock.now() - t1).count();
+        };
+        time_copies(wrapped_ring<element_wise<T>>(n, n - n / 4), ms[0]);
+        time_copies(wrapped_ring<T>(n, n - n / 4), ms[1]);
+        cout << name << ", " << n << " elements x " << repetitions << " copies + reserves: element by element "
+             << ms[0] << " ms, bulk " << ms[1] << " ms" << (check == 2 * repetitions * (n - n / 4) ? "" : " (wrong)")
+             << "\n";
+    }
+}
+
+}
+
+// Copying and growing rings of trivially copyable elements, element by element and with memcpy.
+void test_circular_buffer_copy_performance()
+{
+    ring_copy_performance<int>("int");
+    ring_copy_performance<color_rgba>("color_rgba");
+    cout << '\n';
+}
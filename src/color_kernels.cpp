@@ -0,0 +1,255 @@
+#include "color_kernels.hpp"
+
+#include <cstdint>
+
+// We pick the widest instruction set the compiler was told it may use.
+#if defined(__AVX2__)
+#define COLOR_KERNELS_AVX2
+#define COLOR_KERNELS_SSE2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define COLOR_KERNELS_SSE2
+#include <emmintrin.h>
+#endif
+
+// The kernels treat an array of colors as an array of bytes: r, g, b, a, r, g, b, a, ...
+static_assert(sizeof(color_rgba) == 4, "color_rgba must be exactly four bytes for the batch kernels");
+
+namespace {
+
+unsigned char scaled_channel(unsigned char v, float s)
+{
+    color_rgba c { v, 0, 0, 0 };
+    c *= s;
+    return c.r;
+}
+
+#ifdef COLOR_KERNELS_SSE2
+
+// Selects the red, green and blue bytes of each color.
+inline __m128i rgb_mask_128()
+{
+    return _mm_set1_epi32(0x00FFFFFF);
+}
+
+// paddusb: add with unsigned saturation, exactly what operator+= does per channel.
+// Alpha of src is zeroed first so that alpha of dst stays unchanged.
+inline __m128i add_128(__m128i d, __m128i s)
+{
+    return _mm_adds_epu8(d, _mm_and_si128(s, rgb_mask_128()));
+}
+
+// psubusb: subtract with unsigned saturation at zero.
+inline __m128i subtract_128(__m128i d, __m128i s)
+{
+    return _mm_subs_epu8(d, _mm_and_si128(s, rgb_mask_128()));
+}
+
+// Scales eight 16 bit lanes holding channel values: min(255, v * whole + ((v * fraction) >> 16)).
+inline __m128i scale_lanes_128(__m128i v, __m128i whole, __m128i fraction)
+{
+    const __m128i saturate = _mm_set1_epi16(static_cast<short>(0xFF00));
+    __m128i x = _mm_adds_epu16(_mm_mullo_epi16(v, whole), _mm_mulhi_epu16(v, fraction));
+    // There is no unsigned 16 bit min in SSE2 so we clamp to 255 by saturating at the top of the range.
+    return _mm_subs_epu16(_mm_adds_epu16(x, saturate), saturate);
+}
+
+inline __m128i scale_128(__m128i d, __m128i whole, __m128i fraction)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i lo = scale_lanes_128(_mm_unpacklo_epi8(d, zero), whole, fraction);
+    __m128i hi = scale_lanes_128(_mm_unpackhi_epi8(d, zero), whole, fraction);
+    __m128i scaled = _mm_packus_epi16(lo, hi);
+    // Put back the original alpha.
+    return _mm_or_si128(_mm_and_si128(scaled, rgb_mask_128()), _mm_andnot_si128(rgb_mask_128(), d));
+}
+
+#endif // COLOR_KERNELS_SSE2
+
+#ifdef COLOR_KERNELS_AVX2
+
+inline __m256i rgb_mask_256()
+{
+    return _mm256_set1_epi32(0x00FFFFFF);
+}
+
+inline __m256i add_256(__m256i d, __m256i s)
+{
+    return _mm256_adds_epu8(d, _mm256_and_si256(s, rgb_mask_256()));
+}
+
+inline __m256i subtract_256(__m256i d, __m256i s)
+{
+    return _mm256_subs_epu8(d, _mm256_and_si256(s, rgb_mask_256()));
+}
+
+inline __m256i scale_lanes_256(__m256i v, __m256i whole, __m256i fraction)
+{
+    const __m256i saturate = _mm256_set1_epi16(static_cast<short>(0xFF00));
+    __m256i x = _mm256_adds_epu16(_mm256_mullo_epi16(v, whole), _mm256_mulhi_epu16(v, fraction));
+    return _mm256_subs_epu16(_mm256_adds_epu16(x, saturate), saturate);
+}
+
+// The unpack and pack instructions work inside each 128 bit half, so the order of the bytes is preserved.
+inline __m256i scale_256(__m256i d, __m256i whole, __m256i fraction)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i lo = scale_lanes_256(_mm256_unpacklo_epi8(d, zero), whole, fraction);
+    __m256i hi = scale_lanes_256(_mm256_unpackhi_epi8(d, zero), whole, fraction);
+    __m256i scaled = _mm256_packus_epi16(lo, hi);
+    return _mm256_or_si256(_mm256_and_si256(scaled, rgb_mask_256()), _mm256_andnot_si256(rgb_mask_256(), d));
+}
+
+#endif // COLOR_KERNELS_AVX2
+
+} // namespace
+
+/// Fixed point scaling
+// operator*= multiplies each channel by a float and truncates the result to an int before clamping it.
+// We want the same result with integer arithmetic only: min(255, (v * m) >> 16) for some multiplier m,
+// which is split as m = whole * 65536 + fraction. The whole part is at most 256 since that saturates any channel
+// that is not 0. Instead of trying to be clever about float rounding we simply ask the operator what it gives
+// for every possible channel value (there are only 256 of them) and find the range of multipliers consistent
+// with all answers. The range can be empty for some values of s very close to a fraction with a small denominator.
+color_scale::color_scale(float s)
+    : factor(s), exact(false), whole(0), fraction(0)
+{
+    const std::int64_t one = 1 << 16;
+    std::int64_t lo = 0;
+    std::int64_t hi = 256 * one;
+    for (std::int64_t v = 1; v != 256; ++v) {
+        std::int64_t t = scaled_channel(static_cast<unsigned char>(v), s);
+        // (v * m) >> 16 >= t
+        std::int64_t low_bound = (t * one + v - 1) / v;
+        if (low_bound > lo) {
+            lo = low_bound;
+        }
+        // (v * m) >> 16 <= t, only needed when the result did not saturate.
+        if (t < 255) {
+            std::int64_t high_bound = ((t + 1) * one - 1) / v;
+            if (high_bound < hi) {
+                hi = high_bound;
+            }
+        }
+    }
+    exact = scaled_channel(0, s) == 0 && lo <= hi;
+    whole = static_cast<std::uint16_t>(lo >> 16);
+    fraction = static_cast<std::uint16_t>(lo & 0xFFFF);
+}
+
+void add_colors(color_rgba* dst, const color_rgba* src, std::size_t n)
+{
+    std::size_t i = 0;
+#ifdef COLOR_KERNELS_AVX2
+    for (; i + 8 <= n; i += 8) {
+        __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+        __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), add_256(d, s));
+    }
+#endif
+#ifdef COLOR_KERNELS_SSE2
+    for (; i + 4 <= n; i += 4) {
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), add_128(d, s));
+    }
+#endif
+    // Whatever is left (or everything, without SIMD) goes through the ordinary operator.
+    for (; i != n; ++i) {
+        dst[i] += src[i];
+    }
+}
+
+void subtract_colors(color_rgba* dst, const color_rgba* src, std::size_t n)
+{
+    std::size_t i = 0;
+#ifdef COLOR_KERNELS_AVX2
+    for (; i + 8 <= n; i += 8) {
+        __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+        __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), subtract_256(d, s));
+    }
+#endif
+#ifdef COLOR_KERNELS_SSE2
+    for (; i + 4 <= n; i += 4) {
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), subtract_128(d, s));
+    }
+#endif
+    for (; i != n; ++i) {
+        dst[i] -= src[i];
+    }
+}
+
+void scale_colors(color_rgba* dst, std::size_t n, float s)
+{
+#ifdef COLOR_KERNELS_SSE2
+    // Only worth preparing the factor for larger arrays.
+    const std::size_t worth_it = 256;
+    if (n >= worth_it) {
+        scale_colors(dst, n, color_scale(s));
+        return;
+    }
+#endif
+    for (std::size_t i = 0; i != n; ++i) {
+        dst[i] *= s;
+    }
+}
+
+void scale_colors(color_rgba* dst, std::size_t n, const color_scale& s)
+{
+    std::size_t i = 0;
+#ifdef COLOR_KERNELS_SSE2
+    if (s.exact) {
+#ifdef COLOR_KERNELS_AVX2
+        const __m256i whole_256 = _mm256_set1_epi16(static_cast<short>(s.whole));
+        const __m256i fraction_256 = _mm256_set1_epi16(static_cast<short>(s.fraction));
+        for (; i + 8 <= n; i += 8) {
+            __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), scale_256(d, whole_256, fraction_256));
+        }
+#endif
+        const __m128i whole = _mm_set1_epi16(static_cast<short>(s.whole));
+        const __m128i fraction = _mm_set1_epi16(static_cast<short>(s.fraction));
+        for (; i + 4 <= n; i += 4) {
+            __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), scale_128(d, whole, fraction));
+        }
+    }
+#endif
+    for (; i != n; ++i) {
+        dst[i] *= s.factor;
+    }
+}
+
+void add_colors(array_segment<color_rgba> dst, array_segment<const color_rgba> src)
+{
+    add_colors(dst.data(), src.data(), dst.size());
+}
+
+void subtract_colors(array_segment<color_rgba> dst, array_segment<const color_rgba> src)
+{
+    subtract_colors(dst.data(), src.data(), dst.size());
+}
+
+void scale_colors(array_segment<color_rgba> dst, float s)
+{
+    scale_colors(dst.data(), dst.size(), s);
+}
+
+void scale_colors(array_segment<color_rgba> dst, const color_scale& s)
+{
+    scale_colors(dst.data(), dst.size(), s);
+}
+
+const char* color_kernels_instruction_set()
+{
+#if defined(COLOR_KERNELS_AVX2)
+    return "AVX2";
+#elif defined(COLOR_KERNELS_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
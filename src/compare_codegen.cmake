@@ -0,0 +1,52 @@
+# Checks that the functions raw_<name> and singleton_<name> in an assembly file have the same instructions.
+# Usage: cmake -DASSEMBLY=<file.s> -P compare_codegen.cmake
+# Directives, comments and the numbers of local labels differ between two functions with the same code,
+# so they are left out of the comparison.
+
+if(NOT ASSEMBLY)
+    message(FATAL_ERROR "compare_codegen.cmake needs -DASSEMBLY=<file>")
+endif()
+
+file(STRINGS ${ASSEMBLY} lines)
+
+set(current "")
+set(names "")
+foreach(line ${lines})
+    string(REGEX MATCH "^_?(raw|singleton)_([A-Za-z0-9_]+):" label "${line}")
+    if(label)
+        set(current "${CMAKE_MATCH_1}_${CMAKE_MATCH_2}")
+        set(body_${current} "")
+        if(CMAKE_MATCH_1 STREQUAL "raw")
+            list(APPEND names ${CMAKE_MATCH_2})
+        endif()
+    elseif(current)
+        if(line MATCHES "^[ \t]*\\.cfi_endproc" OR line MATCHES "^[ \t]*\\.size")
+            set(current "")
+        elseif(NOT line MATCHES "^[ \t]*\\.[a-z_0-9]+([ \t]|$)" AND NOT line MATCHES "^\\.?LFB[0-9]+:")
+            string(REGEX REPLACE "[ \t]+#.*$" "" line "${line}")
+            string(REGEX REPLACE "\\.?L[A-Za-z_]*[0-9_]+" ".L" line "${line}")
+            set(body_${current} "${body_${current}}${line}\n")
+        endif()
+    endif()
+endforeach()
+
+if(NOT names)
+    message(FATAL_ERROR "No raw_ functions found in ${ASSEMBLY}")
+endif()
+
+set(failed FALSE)
+foreach(name ${names})
+    if(NOT DEFINED body_singleton_${name})
+        message(SEND_ERROR "${name}: no singleton_${name} to compare with")
+        set(failed TRUE)
+    elseif(body_raw_${name} STREQUAL body_singleton_${name})
+        message(STATUS "${name}: same code")
+    else()
+        message(SEND_ERROR "${name}: different code\n--- raw:\n${body_raw_${name}}--- singleton:\n${body_singleton_${name}}")
+        set(failed TRUE)
+    endif()
+endforeach()
+
+if(failed)
+    message(FATAL_ERROR "singleton adds instructions over the bare type in ${ASSEMBLY}")
+endif()
@@ -0,0 +1,253 @@
+#include "compressed_ring_tests.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+#include "circular_buffer.hpp"
+#include "compressed_ring.hpp"
+
+using std::cout;
+
+namespace {
+
+// Encodes the deltas between consecutive values (the first one is the base), like a block does.
+template<typename T>
+std::vector<std::uint8_t> encode_deltas(const std::vector<T>& values)
+{
+    using U = std::make_unsigned_t<T>;
+    std::vector<std::uint8_t> bytes(values.size() * 10 + 16);
+    std::uint8_t* end = bytes.data();
+    for (std::size_t i = 1; i < values.size(); ++i) {
+        end = write_varint(end, zigzag_encode(static_cast<U>(static_cast<U>(values[i]) - static_cast<U>(values[i - 1]))));
+    }
+    bytes.resize(static_cast<std::size_t>(end - bytes.data()));
+    return bytes;
+}
+
+// Both decoders give back the values and read exactly the encoded bytes.
+template<typename T>
+bool round_trip(const std::vector<T>& values)
+{
+    std::vector<std::uint8_t> bytes = encode_deltas(values);
+    std::size_t n = values.size() - 1;
+    std::vector<T> scalar(n), simd(n);
+    const std::uint8_t* end_scalar = decode_deltas_scalar(bytes.data(), n, values[0], scalar.data());
+    const std::uint8_t* end_simd = decode_deltas(bytes.data(), n, values[0], simd.data());
+    const std::uint8_t* end = bytes.data() + bytes.size();
+    return end_scalar == end && end_simd == end && scalar == std::vector<T>(values.begin() + 1, values.end())
+        && simd == scalar;
+}
+
+// Values whose deltas are mostly within a single byte, with longer ones (of up to max_delta) mixed in.
+template<typename T>
+std::vector<T> mostly_small_steps(std::mt19937_64& gen, std::size_t n, int large_every, std::uint64_t max_delta)
+{
+    std::vector<T> values(n);
+    T x = static_cast<T>(gen());
+    for (T& v : values) {
+        std::uint64_t r = gen();
+        std::uint64_t step = r % 64;
+        if (r % static_cast<std::uint64_t>(large_every) == 0) {
+            step = max_delta == ~std::uint64_t(0) ? gen() : gen() % (max_delta + 1);
+        }
+        // Up or down, wrapping around at the ends of the type.
+        x = static_cast<T>((r >> 32) & 1 ? static_cast<std::uint64_t>(x) + step : static_cast<std::uint64_t>(x) - step);
+        v = x;
+    }
+    return values;
+}
+
+// Pushes the values into the ring and checks that it holds the newest ones, in whole blocks.
+template<typename T, std::size_t BlockSize>
+bool check_ring(compressed_ring<T, BlockSize>& ring, const std::vector<T>& values)
+{
+    bool result = true;
+    for (std::size_t i = 0; i != values.size(); ++i) {
+        ring.push_back(values[i]);
+        std::size_t size = ring.size();
+        // Only whole blocks are thrown away.
+        result = result && size <= i + 1 && (i + 1 - size) % BlockSize == 0 && ring.back() == values[i]
+            && ring.front() == values[i + 1 - size];
+    }
+    std::size_t first = values.size() - ring.size();
+    for (std::size_t i = 0; i != ring.size(); ++i) {
+        result = result && ring[i] == values[first + i];
+    }
+    std::vector<T> all(ring.size());
+    result = result && ring.copy_to(all.data()) == all.data() + all.size()
+        && all == std::vector<T>(values.begin() + static_cast<std::ptrdiff_t>(first), values.end());
+    return result;
+}
+
+}
+
+bool test_varint_deltas()
+{
+    bool result = true;
+    result = result && zigzag_encode<std::uint32_t>(0) == 0 && zigzag_encode<std::uint32_t>(static_cast<std::uint32_t>(-1)) == 1
+        && zigzag_encode<std::uint32_t>(1) == 2 && zigzag_encode<std::uint32_t>(static_cast<std::uint32_t>(-2)) == 3;
+    result = result && zigzag_encode<std::uint8_t>(0x80) == 0xFF && zigzag_decode<std::uint8_t>(0xFF) == 0x80;
+
+    std::uint8_t bytes[10];
+    result = result && write_varint(bytes, std::uint64_t(127)) == bytes + 1
+        && write_varint(bytes, std::uint64_t(128)) == bytes + 2 && bytes[0] == 0x80 && bytes[1] == 1
+        && write_varint(bytes, std::numeric_limits<std::uint64_t>::max()) == bytes + 10;
+
+    // The extremes of each type, where the deltas wrap around.
+    result = result && round_trip<std::int8_t>({ 0, 127, -128, 5, -128, 127 });
+    result = result && round_trip<std::uint16_t>({ 0, 65535, 1, 65535, 0 });
+    result = result && round_trip<std::int64_t>({ 0, std::numeric_limits<std::int64_t>::max(),
+                                                  std::numeric_limits<std::int64_t>::min(), -1, 1 });
+    result = result && round_trip<std::uint64_t>({ 5, 0, std::numeric_limits<std::uint64_t>::max(), 7 });
+
+    // Runs of single byte deltas (the SIMD path) broken up by longer ones at every possible position.
+    std::mt19937_64 gen(42);
+    for (int large_every : { 1000000, 40, 17, 3 }) {
+        result = result && round_trip(mostly_small_steps<std::int64_t>(gen, 2000, large_every, 1 << 20));
+        result = result && round_trip(mostly_small_steps<std::uint64_t>(gen, 2000, large_every, ~std::uint64_t(0)));
+        result = result && round_trip(mostly_small_steps<std::int32_t>(gen, 2000, large_every, 1 << 30));
+        result = result && round_trip(mostly_small_steps<std::uint32_t>(gen, 2000, large_every, 1 << 16));
+        result = result && round_trip(mostly_small_steps<std::int16_t>(gen, 2000, large_every, 1 << 15));
+    }
+    return result;
+}
+
+bool test_compressed_ring()
+{
+    bool result = true;
+    compressed_ring<std::int64_t, 16> small(100);
+    // Room for at least one block, whatever was asked for.
+    result = result && small.empty() && small.byte_capacity() == decltype(small)::max_block_bytes;
+    for (int i = 0; i != 20; ++i) {
+        small.push_back(1000 + i);
+    }
+    result = result && small.size() == 20 && small.block_count() == 1 && small.front() == 1000 && small.back() == 1019
+        && small[3] == 1003 && small[16] == 1016;
+    small.clear();
+    result = result && small.empty();
+
+    std::mt19937_64 gen(7);
+    // A byte capacity which the blocks do not divide, so that the blocks wrap around at different places.
+    {
+        compressed_ring<std::int64_t, 16> ring(1000);
+        result = result && check_ring(ring, mostly_small_steps<std::int64_t>(gen, 20000, 10, 1 << 24));
+        // Evicting made room as needed, and no more.
+        result = result && ring.size() > 1000 / 3 && ring.compressed_bytes() <= 1000 + 16 * 8 + ring.block_count() * 64;
+    }
+    {
+        compressed_ring<std::uint64_t, 128> ring(50000);
+        result = result && check_ring(ring, mostly_small_steps<std::uint64_t>(gen, 100000, 5, ~std::uint64_t(0)));
+    }
+    {
+        compressed_ring<std::int32_t, 32> ring(4000);
+        result = result && check_ring(ring, mostly_small_steps<std::int32_t>(gen, 30000, 50, 1 << 30));
+    }
+    {
+        // Samples which do not compress at all (every delta is a full length varint) still work.
+        compressed_ring<std::int8_t, 8> ring(64);
+        std::vector<std::int8_t> values(5000);
+        for (std::int8_t& v : values) {
+            v = static_cast<std::int8_t>(gen());
+        }
+        result = result && check_ring(ring, values);
+    }
+    return result;
+}
+
+void test_compressed_ring_performance()
+{
+    using namespace std::chrono;
+    high_resolution_clock clock {};
+    const std::size_t n = std::size_t(1) << 24;
+    const int repeats = 10;
+
+    struct series {
+        const char* name;
+        int large_every;
+        std::uint64_t max_delta;
+    };
+    // Counters which mostly move a little, now and then more, and noise that does not compress at all.
+    const series all_series[] = {
+        { "small steps", 1000000000, 0 },
+        { "small steps, 1 in 20 larger", 20, 1 << 20 },
+        { "small steps, 1 in 4 larger", 4, 1 << 20 },
+        { "random 64 bit", 1, ~std::uint64_t(0) },
+    };
+    for (const series& s : all_series) {
+        std::mt19937_64 gen(n);
+        std::vector<std::int64_t> values = mostly_small_steps<std::int64_t>(gen, n, s.large_every, s.max_delta);
+
+        circular_buffer<std::int64_t> plain(n);
+        // Room for all of the samples, however badly they compress.
+        compressed_ring<std::int64_t, 128> ring(n * 10);
+        for (std::int64_t x : values) {
+            plain.push_back(x);
+            ring.push_back(x);
+        }
+        std::vector<std::int64_t> out(n);
+
+        auto start = clock.now();
+        for (int r = 0; r != repeats; ++r) {
+            std::int64_t* o = out.data();
+            for (const array_segment<std::int64_t>& segment : { plain.array_one(), plain.array_two() }) {
+                std::memcpy(o, segment.data(), segment.size() * sizeof(std::int64_t));
+                o += segment.size();
+            }
+        }
+        auto copied = clock.now();
+        for (int r = 0; r != repeats; ++r) {
+            ring.copy_to(out.data());
+        }
+        auto decoded = clock.now();
+        bool same = out == values;
+
+        // The deltas of the whole series as one stream, through each decoder. Decoding all of it to memory only
+        // measures how fast we can write (as copying the circular_buffer does), so we decode 4096 values at a time
+        // into a buffer which stays in the cache and add them up, as a scan over the samples would.
+        std::vector<std::uint8_t> bytes = encode_deltas(values);
+        const std::size_t chunk = 4096;
+        std::vector<std::int64_t> buffer(chunk);
+        auto sum_stream = [&](auto decode) {
+            // Unsigned, so that the random series may wrap around.
+            std::uint64_t sum = 0;
+            const std::uint8_t* p = bytes.data();
+            std::int64_t prev = values[0];
+            for (std::size_t i = 0; i < n - 1; i += chunk) {
+                std::size_t k = std::min(chunk, n - 1 - i);
+                p = decode(p, k, prev, buffer.data());
+                prev = buffer[k - 1];
+                for (std::size_t j = 0; j != k; ++j) {
+                    sum += static_cast<std::uint64_t>(buffer[j]);
+                }
+            }
+            return sum;
+        };
+        std::uint64_t expected = 0;
+        for (std::size_t i = 1; i != n; ++i) {
+            expected += static_cast<std::uint64_t>(values[i]);
+        }
+        auto stream_start = clock.now();
+        for (int r = 0; r != repeats; ++r) {
+            same = same && sum_stream(decode_deltas_scalar<std::int64_t>) == expected;
+        }
+        auto scalar = clock.now();
+        for (int r = 0; r != repeats; ++r) {
+            same = same && sum_stream(decode_deltas<std::int64_t>) == expected;
+        }
+        auto simd = clock.now();
+
+        auto gb_per_s = [&](high_resolution_clock::duration d) {
+            return repeats * n * sizeof(std::int64_t) / duration_cast<duration<double>>(d).count() / 1e9;
+        };
+        cout << s.name << ": " << double(ring.compressed_bytes()) / (n * sizeof(std::int64_t)) * 100
+             << "% of the memory, decoding " << gb_per_s(decoded - copied) << " GB/s (deltas, summed in the cache: scalar "
+             << gb_per_s(scalar - stream_start) << " GB/s, SIMD " << gb_per_s(simd - scalar)
+             << " GB/s), copying circular_buffer " << gb_per_s(copied - start) << " GB/s"
+             << (same ? "" : " WRONG RESULT") << "\n";
+    }
+}
@@ -0,0 +1,93 @@
+#include "executors.hpp"
+
+manual_executor::manual_executor(std::size_t capacity)
+    : queue_(capacity)
+{}
+
+void manual_executor::schedule(std::coroutine_handle<> h)
+{
+    push_growing(queue_, h);
+}
+
+bool manual_executor::run_one()
+{
+    if (queue_.empty()) {
+        return false;
+    }
+    std::coroutine_handle<> h = queue_.front();
+    queue_.pop_front();
+    h.resume();
+    return true;
+}
+
+std::size_t manual_executor::run()
+{
+    std::size_t resumed = 0;
+    while (run_one()) {
+        ++resumed;
+    }
+    return resumed;
+}
+
+threaded_executor::threaded_executor(std::size_t thread_count, std::size_t capacity)
+    : queue_(capacity), sleeping_(0), stopping_(false)
+{
+    if (thread_count == 0) {
+        thread_count = std::thread::hardware_concurrency();
+    }
+    // hardware_concurrency is allowed to return 0 if it cannot tell.
+    if (thread_count == 0) {
+        thread_count = 1;
+    }
+    threads_.reserve(thread_count);
+    for (std::size_t i = 0; i != thread_count; ++i) {
+        threads_.emplace_back([this]() { worker_loop(); });
+    }
+}
+
+threaded_executor::~threaded_executor()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    ready_.notify_all();
+    for (std::thread& t : threads_) {
+        t.join();
+    }
+}
+
+void threaded_executor::schedule(std::coroutine_handle<> h)
+{
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        push_growing(queue_, h);
+        wake = sleeping_ != 0;
+    }
+    if (wake) {
+        ready_.notify_one();
+    }
+}
+
+void threaded_executor::worker_loop()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        if (!queue_.empty()) {
+            std::coroutine_handle<> h = queue_.front();
+            queue_.pop_front();
+            lock.unlock();
+            h.resume();
+            lock.lock();
+            continue;
+        }
+        // We only stop once all of the queued work is done.
+        if (stopping_) {
+            return;
+        }
+        ++sleeping_;
+        ready_.wait(lock);
+        --sleeping_;
+    }
+}
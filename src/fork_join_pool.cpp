@@ -0,0 +1,175 @@
+#include "fork_join_pool.hpp"
+
+#include <chrono>
+
+struct fork_join_pool::worker {
+    worker(fork_join_pool* p, std::size_t i)
+        : pool(p), index(i), random(static_cast<std::uint32_t>(2654435761u * (i + 1)))
+    {}
+
+    fork_join_pool* pool;
+    std::size_t index;
+    work_stealing_deque<fork_join_task*> deque;
+    // For picking victims at random (xorshift).
+    std::uint32_t random;
+};
+
+thread_local fork_join_pool::worker* fork_join_pool::current_worker_ = nullptr;
+
+namespace {
+
+// Idle rounds of looking for work before a worker goes to sleep.
+constexpr unsigned spins_before_sleep = 64;
+
+}
+
+fork_join_pool::fork_join_pool(std::size_t thread_count)
+    : injected_count_(0), sleepers_(0), stopping_(false)
+{
+    if (thread_count == 0) {
+        thread_count = std::thread::hardware_concurrency();
+    }
+    // hardware_concurrency is allowed to return 0 if it cannot tell.
+    if (thread_count == 0) {
+        thread_count = 1;
+    }
+    // All deques must exist before the first worker starts looking for work to steal.
+    for (std::size_t i = 0; i != thread_count; ++i) {
+        worker_state_.push_back(std::make_unique<worker>(this, i));
+    }
+    workers_.reserve(thread_count);
+    for (std::size_t i = 0; i != thread_count; ++i) {
+        workers_.emplace_back([this, i]() { worker_loop(i); });
+    }
+}
+
+fork_join_pool::~fork_join_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& w : workers_) {
+        w.join();
+    }
+}
+
+bool fork_join_pool::in_worker_thread() const
+{
+    return current_worker_ != nullptr && current_worker_->pool == this;
+}
+
+bool fork_join_pool::spawn(fork_join_task* task)
+{
+    worker* self = current_worker_;
+    if (self == nullptr) {
+        return false;
+    }
+    self->deque.push(task);
+    self->pool->wake_one();
+    return true;
+}
+
+void fork_join_pool::sync(const std::atomic<std::size_t>& pending)
+{
+    worker& self = *current_worker_;
+    unsigned idle = 0;
+    while (pending.load(std::memory_order_acquire) != 0) {
+        fork_join_task* task;
+        if (self.pool->find_task(self, task)) {
+            task->run_and_release();
+            idle = 0;
+        }
+        // The tasks we wait for are running elsewhere: let the threads running them have the core.
+        else if (++idle > spins_before_sleep) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void fork_join_pool::inject(fork_join_task* task)
+{
+    {
+        std::lock_guard<std::mutex> lock(injected_mutex_);
+        injected_.push_back(task);
+        injected_count_.fetch_add(1, std::memory_order_release);
+    }
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    wake_.notify_one();
+}
+
+bool fork_join_pool::find_task(worker& self, fork_join_task*& task)
+{
+    if (self.deque.pop(task)) {
+        return true;
+    }
+    if (injected_count_.load(std::memory_order_acquire) != 0) {
+        std::lock_guard<std::mutex> lock(injected_mutex_);
+        if (!injected_.empty()) {
+            task = injected_.front();
+            injected_.pop_front();
+            injected_count_.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return steal(self, task);
+}
+
+bool fork_join_pool::steal(worker& self, fork_join_task*& task)
+{
+    const std::size_t n = worker_state_.size();
+    if (n == 1) {
+        return false;
+    }
+    self.random ^= self.random << 13;
+    self.random ^= self.random >> 17;
+    self.random ^= self.random << 5;
+    // Every other worker once, starting at a random one so that thieves spread out.
+    std::size_t start = self.random % n;
+    for (std::size_t k = 0; k != n; ++k) {
+        std::size_t victim = (start + k) % n;
+        if (victim != self.index && worker_state_[victim]->deque.steal(task)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void fork_join_pool::wake_one()
+{
+    // Cheap in the common case where every worker is busy. A worker which is just going to sleep may miss the
+    // notification, but it only sleeps for a moment at a time.
+    if (sleepers_.load(std::memory_order_relaxed) != 0) {
+        wake_.notify_one();
+    }
+}
+
+void fork_join_pool::worker_loop(std::size_t index)
+{
+    worker& self = *worker_state_[index];
+    current_worker_ = &self;
+    unsigned idle = 0;
+    while (!stopping_.load(std::memory_order_relaxed)) {
+        fork_join_task* task;
+        if (find_task(self, task)) {
+            task->run_and_release();
+            idle = 0;
+            continue;
+        }
+        if (++idle < spins_before_sleep) {
+            std::this_thread::yield();
+            continue;
+        }
+        sleepers_.fetch_add(1, std::memory_order_seq_cst);
+        {
+            std::unique_lock<std::mutex> lock(sleep_mutex_);
+            if (!stopping_.load(std::memory_order_relaxed) && injected_count_.load(std::memory_order_acquire) == 0) {
+                wake_.wait_for(lock, std::chrono::milliseconds(1));
+            }
+        }
+        sleepers_.fetch_sub(1, std::memory_order_relaxed);
+        idle = 0;
+    }
+    current_worker_ = nullptr;
+}
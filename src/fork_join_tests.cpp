@@ -0,0 +1,269 @@
+#include "fork_join_tests.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "buffer.hpp"
+#include "fork_join_pool.hpp"
+#include "thread_pool.hpp"
+#include "work_stealing_deque.hpp"
+
+using std::cout;
+
+namespace {
+
+long long serial_fib(int n)
+{
+    return n < 2 ? n : serial_fib(n - 1) + serial_fib(n - 2);
+}
+
+// Below the cutoff the calls are too small to be worth a task.
+long long fib(int n, int cutoff)
+{
+    if (n < cutoff) {
+        return serial_fib(n);
+    }
+    long long x;
+    task_group g;
+    g.spawn([&]() { x = fib(n - 1, cutoff); });
+    long long y = fib(n - 2, cutoff);
+    g.sync();
+    return x + y;
+}
+
+// Halves the range until it is at most grain elements long.
+long long sum(const int* first, std::size_t n, std::size_t grain)
+{
+    if (n <= grain) {
+        long long s = 0;
+        for (std::size_t i = 0; i != n; ++i) {
+            s += first[i];
+        }
+        return s;
+    }
+    long long left;
+    task_group g;
+    g.spawn([&]() { left = sum(first, n / 2, grain); });
+    long long right = sum(first + n / 2, n - n / 2, grain);
+    g.sync();
+    return left + right;
+}
+
+// A flat storm of tiny tasks: every one marks its own slot.
+void storm(std::vector<int>& marks)
+{
+    task_group g;
+    for (std::size_t i = 0; i != marks.size(); ++i) {
+        g.spawn([&marks, i]() { ++marks[i]; });
+    }
+}
+
+bool all_marked_once(const std::vector<int>& marks)
+{
+    for (int m : marks) {
+        if (m != 1) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<std::size_t> thread_counts()
+{
+    std::size_t max_threads = std::thread::hardware_concurrency();
+    if (max_threads == 0) {
+        max_threads = 1;
+    }
+    // 1, 2, 4, ... threads and finally all of them.
+    std::vector<std::size_t> counts;
+    for (std::size_t threads = 1; threads < max_threads; threads *= 2) {
+        counts.push_back(threads);
+    }
+    counts.push_back(max_threads);
+    return counts;
+}
+
+}
+
+bool test_work_stealing_deque()
+{
+    bool result = true;
+    work_stealing_deque<int> d(4);
+    int x = 0;
+    result = result && d.capacity() == 4 && d.empty() && !d.pop(x) && !d.steal(x);
+
+    // The owner gets the newest element, thieves the oldest.
+    for (int i = 0; i != 3; ++i) {
+        d.push(i);
+    }
+    result = result && d.size() == 3 && d.pop(x) && x == 2 && d.steal(x) && x == 0 && d.pop(x) && x == 1;
+    result = result && d.empty() && !d.pop(x);
+
+    // Pushing past the capacity grows the array, with the elements wrapped around in the old one.
+    d.push(10);
+    d.push(11);
+    d.steal(x);
+    for (int i = 12; i != 100; ++i) {
+        d.push(i);
+    }
+    result = result && d.capacity() == 128 && d.size() == 89;
+    for (int i = 11; i != 50; ++i) {
+        result = result && d.steal(x) && x == i;
+    }
+    for (int i = 99; i != 49; --i) {
+        result = result && d.pop(x) && x == i;
+    }
+    result = result && !d.pop(x) && !d.steal(x);
+    return result;
+}
+
+bool test_work_stealing_deque_concurrent()
+{
+    // The owner pushes and pops while thieves steal; every element must be taken exactly once.
+    const int total = 1'000'000;
+    work_stealing_deque<int> d(16);
+    std::atomic<bool> done { false };
+    std::vector<std::vector<int>> stolen(3);
+    std::vector<std::thread> thieves;
+    for (std::size_t t = 0; t != stolen.size(); ++t) {
+        thieves.emplace_back([&, t]() {
+            int x;
+            while (!done.load(std::memory_order_acquire)) {
+                if (d.steal(x)) {
+                    stolen[t].push_back(x);
+                }
+            }
+            while (d.steal(x)) {
+                stolen[t].push_back(x);
+            }
+        });
+    }
+    std::vector<int> popped;
+    int x;
+    for (int i = 0; i != total; ++i) {
+        d.push(i);
+        // Pop every third element right away, to race the thieves for the last one often.
+        if (i % 3 == 0 && d.pop(x)) {
+            popped.push_back(x);
+        }
+    }
+    while (d.pop(x)) {
+        popped.push_back(x);
+    }
+    done.store(true, std::memory_order_release);
+    for (std::thread& t : thieves) {
+        t.join();
+    }
+
+    std::vector<int> seen(total, 0);
+    for (int y : popped) {
+        ++seen[y];
+    }
+    for (const std::vector<int>& s : stolen) {
+        for (int y : s) {
+            ++seen[y];
+        }
+    }
+    return all_marked_once(seen);
+}
+
+bool test_fork_join_pool()
+{
+    bool result = true;
+    fork_join_pool pool(4);
+    result = result && pool.size() == 4 && !pool.in_worker_thread();
+
+    long long f = 0;
+    pool.run([&]() { f = fib(25, 2); });
+    result = result && f == 75025;
+
+    const int n = 1 << 20;
+    auto b = std::make_unique<buffer<int, n>>();
+    long long expected = 0;
+    for (int i = 0; i != n; ++i) {
+        (*b)[i] = i % 1001 - 500;
+        expected += (*b)[i];
+    }
+    long long s = 0;
+    pool.run([&]() { s = sum(b->data(), n, 1000); });
+    result = result && s == expected;
+
+    std::vector<int> marks(100'000, 0);
+    pool.run([&]() { storm(marks); });
+    result = result && all_marked_once(marks);
+
+    // From a worker, run just calls the function.
+    bool nested = false;
+    pool.run([&]() { pool.run([&]() { nested = pool.in_worker_thread(); }); });
+    result = result && nested;
+
+    // Outside of a pool, spawn calls the function right away.
+    result = result && fib(20, 2) == 6765 && sum(b->data(), n, 1000) == expected;
+    return result;
+}
+
+void test_fork_join_performance()
+{
+    using namespace std::chrono;
+    high_resolution_clock clock {};
+
+    const int fib_n = 36;
+    const int cutoff = 12;
+    const int n = 1 << 25;
+    const std::size_t grain = 1 << 14;
+    const std::size_t tasks = 1'000'000;
+
+    auto b = std::make_unique<buffer<int, n>>();
+    for (int i = 0; i != n; ++i) {
+        (*b)[i] = i % 1001 - 500;
+    }
+
+    auto t1 = clock.now();
+    long long f = serial_fib(fib_n);
+    auto t2 = clock.now();
+    long long s = sum(b->data(), n, n);
+    auto t3 = clock.now();
+    cout << "Serial: fib(" << fib_n << ") " << duration_cast<milliseconds>(t2 - t1).count() << " ms (" << f
+         << "), sum " << duration_cast<milliseconds>(t3 - t2).count() << " ms (" << s << ")\n";
+
+    for (std::size_t threads : thread_counts()) {
+        fork_join_pool pool(threads);
+        auto t4 = clock.now();
+        pool.run([&]() { f = fib(fib_n, cutoff); });
+        auto t5 = clock.now();
+        pool.run([&]() { s = sum(b->data(), n, grain); });
+        auto t6 = clock.now();
+        std::vector<int> marks(tasks, 0);
+        pool.run([&]() { storm(marks); });
+        auto t7 = clock.now();
+
+        // The same storm through thread_pool, whose queues take a lock for every task.
+        thread_pool locked_pool(threads);
+        std::vector<int> locked_marks(tasks, 0);
+        std::atomic<std::size_t> finished { 0 };
+        auto t8 = clock.now();
+        for (std::size_t i = 0; i != tasks; ++i) {
+            locked_pool.submit([&locked_marks, &finished, i]() {
+                ++locked_marks[i];
+                finished.fetch_add(1, std::memory_order_release);
+            });
+        }
+        while (finished.load(std::memory_order_acquire) != tasks) {
+            if (!locked_pool.run_pending_task()) {
+                std::this_thread::yield();
+            }
+        }
+        auto t9 = clock.now();
+
+        cout << threads << " thread(s):\n"
+             << "    fib(" << fib_n << "): " << duration_cast<milliseconds>(t5 - t4).count() << " ms (" << f << ")\n"
+             << "    sum: " << duration_cast<milliseconds>(t6 - t5).count() << " ms (" << s << ")\n"
+             << "    storm of " << tasks << " tasks: " << duration_cast<milliseconds>(t7 - t6).count()
+             << " ms, thread_pool " << duration_cast<milliseconds>(t9 - t8).count() << " ms"
+             << (all_marked_once(marks) && all_marked_once(locked_marks) ? "" : " WRONG RESULT") << "\n";
+    }
+}
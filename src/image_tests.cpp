@@ -0,0 +1,177 @@
+#include "image_tests.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "image.hpp"
+#include "revision.hpp"
+
+using std::cout;
+
+namespace {
+
+bool same_color(const color_rgba& c1, const color_rgba& c2)
+{
+    return c1.r == c2.r && c1.g == c2.g && c1.b == c2.b && c1.a == c2.a;
+}
+
+color_rgba test_pattern(std::size_t x, std::size_t y)
+{
+    return make_color_rgba((x * 3) % 256, (y * 5) % 256, (x + y) % 256, (x * y) % 256);
+}
+
+}
+
+bool test_image_pixel_access()
+{
+    bool result = true;
+
+    // Dimensions that are not multiples of the tile size, so the edge tiles have padding.
+    image<color_rgba, 16> img(50, 20);
+    result = result && img.width() == 50 && img.height() == 20;
+    result = result && img.tiles_x() == 4 && img.tiles_y() == 2 && img.tile_count() == 8;
+
+    for (std::size_t y = 0; y != img.height(); ++y) {
+        for (std::size_t x = 0; x != img.width(); ++x) {
+            img(x, y) = test_pattern(x, y);
+        }
+    }
+    for (std::size_t y = 0; y != img.height(); ++y) {
+        for (std::size_t x = 0; x != img.width(); ++x) {
+            result = result && same_color(img(x, y), test_pattern(x, y));
+        }
+    }
+
+    // Going through the tiles gives the same pixels.
+    for (std::size_t i = 0; i != img.tile_count(); ++i) {
+        image_tile<color_rgba> t = img.tile(i);
+        result = result && t.index == i;
+        for (std::size_t row = 0; row != t.rows(); ++row) {
+            for (std::size_t column = 0; column != t.columns(); ++column) {
+                result = result && same_color(t(column, row), test_pattern(t.x + column, t.y + row));
+            }
+        }
+    }
+    // The last tile only has 50 - 48 = 2 valid columns and 20 - 16 = 4 valid rows.
+    result = result && img.tile(7).columns() == 2 && img.tile(7).rows() == 4;
+
+    return result;
+}
+
+bool test_image_color_passes()
+{
+    bool result = true;
+    thread_pool pool(4);
+
+    image<color_rgba> a(300, 130);
+    image<color_rgba> b(300, 130);
+    for (std::size_t y = 0; y != a.height(); ++y) {
+        for (std::size_t x = 0; x != a.width(); ++x) {
+            a(x, y) = test_pattern(x, y);
+            b(x, y) = test_pattern(y, x);
+        }
+    }
+
+    image<color_rgba> sum = a;
+    image<color_rgba> difference = a;
+    image<color_rgba> scaled = a;
+    add_images(sum, b, pool);
+    subtract_images(difference, b, pool);
+    scale_image(scaled, 1.7f, pool);
+
+    for (std::size_t y = 0; y != a.height(); ++y) {
+        for (std::size_t x = 0; x != a.width(); ++x) {
+            result = result && same_color(sum(x, y), a(x, y) + b(x, y));
+            result = result && same_color(difference(x, y), a(x, y) - b(x, y));
+            result = result && same_color(scaled(x, y), a(x, y) * 1.7f);
+        }
+    }
+
+    return result;
+}
+
+bool test_image_for_each_pixel()
+{
+    bool result = true;
+    thread_pool pool(3);
+
+    image<int, 8> img(21, 13, 1);
+    std::atomic<int> visited { 0 };
+    for_each_pixel(img, pool, [&](int& p) {
+        p *= 2;
+        ++visited;
+    });
+    // Padding must not be visited.
+    result = result && visited == 21 * 13;
+    for (std::size_t y = 0; y != img.height(); ++y) {
+        for (std::size_t x = 0; x != img.width(); ++x) {
+            result = result && img(x, y) == 2;
+        }
+    }
+
+    return result;
+}
+
+void test_image_passes_performance()
+{
+    using namespace std::chrono;
+
+    // A 4K frame, both as a flat array and as a tiled image.
+    const std::size_t width = 3840;
+    const std::size_t height = 2160;
+    const int repetitions = 20;
+
+    std::vector<color_rgba> flat(width * height);
+    std::vector<color_rgba> flat_other(width * height);
+    image<color_rgba> frame(width, height);
+    image<color_rgba> other(width, height);
+    for (std::size_t y = 0; y != height; ++y) {
+        for (std::size_t x = 0; x != width; ++x) {
+            flat[y * width + x] = frame(x, y) = test_pattern(x, y);
+            flat_other[y * width + x] = other(x, y) = test_pattern(y, x);
+        }
+    }
+
+    auto megapixels_per_second = [&](high_resolution_clock::duration d) {
+        double seconds = duration_cast<duration<double>>(d).count();
+        return static_cast<double>(width * height) * repetitions / seconds / 1e6;
+    };
+
+    high_resolution_clock clock {};
+
+    // What we used to do: loop over the flat frame with the scalar operators.
+    auto t1 = clock.now();
+    for (int k = 0; k < repetitions; ++k) {
+        for (std::size_t i = 0; i != flat.size(); ++i) {
+            flat[i] += flat_other[i];
+            flat[i] *= 0.9f;
+        }
+    }
+    auto t2 = clock.now();
+    cout << "Flat frame with scalar operators: " << megapixels_per_second(t2 - t1) << " MP/s\n\n";
+
+    std::size_t max_threads = std::thread::hardware_concurrency();
+    if (max_threads == 0) {
+        max_threads = 1;
+    }
+    // 1, 2, 4, ... threads and finally all of them.
+    std::vector<std::size_t> thread_counts;
+    for (std::size_t threads = 1; threads < max_threads; threads *= 2) {
+        thread_counts.push_back(threads);
+    }
+    thread_counts.push_back(max_threads);
+
+    for (std::size_t threads : thread_counts) {
+        thread_pool pool(threads);
+        auto t3 = clock.now();
+        for (int k = 0; k < repetitions; ++k) {
+            add_images(frame, other, pool);
+            scale_image(frame, 0.9f, pool);
+        }
+        auto t4 = clock.now();
+        cout << "Tiled frame, add + scale with " << threads << " thread(s): "
+             << megapixels_per_second(t4 - t3) << " MP/s\n\n";
+    }
+}
@@ -5,6 +5,23 @@
 #include <iostream>
 #include "circular_buffer.hpp"
 #include "circular_buffer_tests.hpp"
+#include "revision_tests.hpp"
+#include "image_tests.hpp"
+#include "parallel_algorithms_tests.hpp"
+#include "reductions_tests.hpp"
+#include "text_writer_tests.hpp"
+#include "snapshot_tests.hpp"
+#include "sorting_networks_tests.hpp"
+#include "pair_vector_tests.hpp"
+#include "ring_views_tests.hpp"
+#include "seqlock_ring_tests.hpp"
+#include "sequence_cursor_tests.hpp"
+#include "multicast_ring_tests.hpp"
+#include "fork_join_tests.hpp"
+#include "channel_tests.hpp"
+#include "timing_wheel_tests.hpp"
+#include "ring_memory_tests.hpp"
+#include "compressed_ring_tests.hpp"
 
 using namespace std;
 
@@ -27,12 +44,108 @@ int main(int argc, char* argv[])
         //<< "Result for iterator regularity: " << test_circular_buffer_iterator_regularity() << "\n"
         //<< "Result for iterator element access: " << test_circular_buffer_iterator_element_access() << "\n"
         //<< "Result for iterator movement: " << test_circular_buffer_iterator_movement() << "\n"
+
+        //<< "Result for static circular buffer: " << test_static_circular_buffer() << "\n"
+        //<< "Result for structure of arrays circular buffer: " << test_soa_circular_buffer() << "\n"
+        //<< "Result for circular buffer bulk copy: " << test_circular_buffer_bulk_copy() << "\n"
+
+        //<< "Result for batch color kernels: " << test_color_kernels() << "\n"
+        //<< "Result for buffer expressions: " << test_buffer_expressions() << "\n"
+        //<< "Result for buffer kernels: " << test_buffer_kernels() << "\n"
+        //<< "Result for heap buffer: " << test_heap_buffer() << "\n"
+        //<< "Result for buffer construction: " << test_buffer_construction() << "\n"
+        //<< "Result for singleton operators: " << test_singleton_operators() << "\n"
+
+        //<< "Result for image pixel access: " << test_image_pixel_access() << "\n"
+        //<< "Result for image color passes: " << test_image_color_passes() << "\n"
+        //<< "Result for image for each pixel: " << test_image_for_each_pixel() << "\n"
+        //<< "Result for parallel algorithms: " << test_parallel_algorithms() << "\n"
+        //<< "Result for parallel algorithms wrap around: " << test_parallel_algorithms_wrap_around() << "\n"
+        //<< "Result for reductions: " << test_reductions() << "\n"
+        //<< "Result for reductions on containers: " << test_reductions_containers() << "\n"
+        //<< "Result for text writer numbers: " << test_text_writer_numbers() << "\n"
+        //<< "Result for text writer containers: " << test_text_writer_containers() << "\n"
+        //<< "Result for snapshot round trip: " << test_snapshot_round_trip() << "\n"
+        //<< "Result for snapshot errors: " << test_snapshot_errors() << "\n"
+        //<< "Result for mapped snapshot: " << test_mapped_snapshot() << "\n"
+        //<< "Result for sorting networks: " << test_sorting_networks() << "\n"
+        //<< "Result for partial sort and nth element: " << test_partial_sort_and_nth_element() << "\n"
+        //<< "Result for simple_pair compression: " << test_simple_pair_compression() << "\n"
+        //<< "Result for pair_vector: " << test_pair_vector() << "\n"
+        //<< "Result for ring views: " << test_ring_views() << "\n"
+        //<< "Result for ring views take_last and window: " << test_ring_views_take_last_and_window() << "\n"
+        //<< "Result for seqlock ring: " << test_seqlock_ring() << "\n"
+        //<< "Result for seqlock ring concurrent snapshots: " << test_seqlock_ring_concurrent_snapshots() << "\n"
+        //<< "Result for sequence numbers: " << test_sequence_numbers() << "\n"
+        //<< "Result for sequence cursor: " << test_sequence_cursor() << "\n"
+        //<< "Result for multicast ring: " << test_multicast_ring() << "\n"
+        //<< "Result for multicast ring concurrent: " << test_multicast_ring_concurrent() << "\n"
+        //<< "Result for work stealing deque: " << test_work_stealing_deque() << "\n"
+        //<< "Result for work stealing deque concurrent: " << test_work_stealing_deque_concurrent() << "\n"
+        //<< "Result for fork/join pool: " << test_fork_join_pool() << "\n"
+        //<< "Result for channel: " << test_channel() << "\n"
+        //<< "Result for channel threaded: " << test_channel_threaded() << "\n"
+        //<< "Result for timing wheel: " << test_timing_wheel() << "\n"
+        //<< "Result for timing wheel random: " << test_timing_wheel_random() << "\n"
+        //<< "Result for ring memory: " << test_ring_memory() << "\n"
+        //<< "Result for varint deltas: " << test_varint_deltas() << "\n"
+        //<< "Result for compressed ring: " << test_compressed_ring() << "\n"
         ;
 
     //test_circular_buffer_push_back_performance();
 
     //test_circular_buffer_output();
 
+    //test_static_circular_buffer_startup_performance();
+
+    //test_soa_circular_buffer_channel_performance();
+
+    //test_circular_buffer_copy_performance();
+
+    //test_color_kernels_performance();
+
+    //test_buffer_expressions_performance();
+
+    //test_buffer_kernels_performance();
+
+    //test_heap_buffer_performance();
+
+    //test_buffer_copy_performance();
+
+    //test_singleton_performance();
+
+    //test_image_passes_performance();
+
+    //test_parallel_algorithms_performance();
+
+    //test_reductions_performance();
+
+    //test_text_output_performance();
+
+    //test_snapshot_performance();
+
+    //test_sorting_networks_performance();
+
+    //test_pair_vector_performance();
+
+    //test_ring_views_performance();
+
+    //test_seqlock_ring_performance();
+
+    //test_sequence_cursor_performance();
+
+    //test_multicast_ring_performance();
+
+    //test_fork_join_performance();
+
+    //test_channel_performance();
+
+    //test_timing_wheel_performance();
+
+    //test_ring_memory_performance();
+
+    //test_compressed_ring_performance();
+
     return 0;
 }
 
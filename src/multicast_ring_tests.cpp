@@ -0,0 +1,217 @@
+#include "multicast_ring_tests.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "multicast_ring.hpp"
+
+using std::cout;
+
+namespace {
+
+// A typical message: a sequence number and a few words of payload.
+struct event {
+    std::uint64_t seq;
+    std::uint64_t payload[3];
+};
+
+event make_event(std::uint64_t i)
+{
+    return { i, { i * 3, i ^ 0x5555, ~i } };
+}
+
+// What a consumer checks and computes: the events must come in order, each exactly once.
+struct event_checker {
+    std::uint64_t expected = 0;
+    std::uint64_t sum = 0;
+    bool ok = true;
+
+    void operator()(const event& e)
+    {
+        ok = ok && e.seq == expected && e.payload[0] == e.seq * 3 && e.payload[2] == ~e.seq;
+        sum += e.payload[1];
+        ++expected;
+    }
+};
+
+template<typename Ring>
+void produce(Ring& ring, std::uint64_t total, std::size_t batch)
+{
+    std::uint64_t i = 0;
+    while (i != total) {
+        std::size_t n = total - i < batch ? static_cast<std::size_t>(total - i) : batch;
+        storage_segments<event> s = ring.claim(n);
+        for (event& e : s.one) {
+            e = make_event(i++);
+        }
+        for (event& e : s.two) {
+            e = make_event(i++);
+        }
+        ring.publish();
+    }
+}
+
+// One ring shared by all of the consumers.
+template<typename Wait>
+bool multicast(std::size_t consumers, std::uint64_t total, std::size_t capacity, std::size_t batch, Wait wait)
+{
+    multicast_ring<event, Wait> ring(capacity, consumers, wait);
+    std::vector<event_checker> checkers(consumers);
+    std::vector<std::thread> threads;
+    for (std::size_t c = 0; c != consumers; ++c) {
+        threads.emplace_back([&, c]() {
+            while (checkers[c].expected != total) {
+                ring.consume(c, [&](const event& e) { checkers[c](e); });
+            }
+        });
+    }
+    produce(ring, total, batch);
+    for (std::thread& t : threads) {
+        t.join();
+    }
+    bool ok = true;
+    for (const event_checker& checker : checkers) {
+        ok = ok && checker.ok && checker.sum == checkers[0].sum;
+    }
+    return ok;
+}
+
+// What we compare against: the producer copies every event into one ring per consumer.
+template<typename Wait>
+bool fan_out(std::size_t consumers, std::uint64_t total, std::size_t capacity, std::size_t batch, Wait wait)
+{
+    std::vector<std::unique_ptr<multicast_ring<event, Wait>>> rings;
+    for (std::size_t c = 0; c != consumers; ++c) {
+        rings.emplace_back(new multicast_ring<event, Wait>(capacity, 1, wait));
+    }
+    std::vector<event_checker> checkers(consumers);
+    std::vector<std::thread> threads;
+    for (std::size_t c = 0; c != consumers; ++c) {
+        threads.emplace_back([&, c]() {
+            while (checkers[c].expected != total) {
+                rings[c]->consume(0, [&](const event& e) { checkers[c](e); });
+            }
+        });
+    }
+    std::vector<storage_segments<event>> slots(consumers);
+    std::uint64_t i = 0;
+    while (i != total) {
+        std::size_t n = total - i < batch ? static_cast<std::size_t>(total - i) : batch;
+        for (std::size_t c = 0; c != consumers; ++c) {
+            slots[c] = rings[c]->claim(n);
+        }
+        for (std::size_t j = 0; j != n; ++j, ++i) {
+            event e = make_event(i);
+            for (storage_segments<event>& s : slots) {
+                (j < s.one.size() ? s.one[j] : s.two[j - s.one.size()]) = e;
+            }
+        }
+        for (auto& ring : rings) {
+            ring->publish();
+        }
+    }
+    for (std::thread& t : threads) {
+        t.join();
+    }
+    bool ok = true;
+    for (const event_checker& checker : checkers) {
+        ok = ok && checker.ok && checker.sum == checkers[0].sum;
+    }
+    return ok;
+}
+
+template<typename Wait>
+void compare(const char* name, std::size_t consumers, std::uint64_t total, Wait wait)
+{
+    using namespace std::chrono;
+    const std::size_t capacity = 1 << 14;
+    const std::size_t batch = 256;
+    high_resolution_clock clock {};
+
+    auto start = clock.now();
+    bool ok = multicast(consumers, total, capacity, batch, wait);
+    auto multicast_time = duration_cast<milliseconds>(clock.now() - start).count();
+
+    start = clock.now();
+    ok = fan_out(consumers, total, capacity, batch, wait) && ok;
+    auto fan_out_time = duration_cast<milliseconds>(clock.now() - start).count();
+
+    cout << name << ", " << consumers << " consumers: multicast ring " << multicast_time << " ms ("
+         << capacity * sizeof(event) << " bytes), " << consumers << " copies " << fan_out_time << " ms ("
+         << consumers * capacity * sizeof(event) << " bytes)" << (ok ? "" : " WRONG RESULT") << "\n";
+}
+
+}
+
+bool test_multicast_ring()
+{
+    bool result = true;
+    multicast_ring<int> ring(6, 2);
+    result = result && ring.capacity() == 8 && ring.consumers() == 2;
+    result = result && ring.try_available(0).size() == 0;
+
+    for (int i = 0; i != 5; ++i) {
+        ring.push_back(i);
+    }
+    int sum = 0;
+    result = result && ring.consume(0, [&](int x) { sum += x; }) == 5 && sum == 10;
+    result = result && ring.cursor(0) == 5 && ring.cursor(1) == 0 && ring.published() == 5;
+
+    // Consumer 1 has not read anything yet, so only 3 slots are free.
+    storage_segments<int> slots;
+    result = result && !ring.try_claim(4, slots) && ring.try_claim(3, slots) && slots.size() == 3;
+    slots.one[0] = 5;
+    slots.one[1] = 6;
+    slots.one[2] = 7;
+    ring.publish();
+    result = result && !ring.try_claim(1, slots);
+
+    ring.release(1, 2);
+    result = result && ring.try_claim(2, slots) && slots.one.size() == 2 && slots.two.size() == 0;
+    slots.one[0] = 8;
+    slots.one[1] = 9;
+    // Claimed slots are not visible before they are published.
+    result = result && ring.try_available(0).size() == 3;
+    ring.publish();
+
+    // The 5 elements for consumer 0 wrap around the end of the array.
+    storage_segments<const int> s = ring.try_available(0);
+    result = result && s.size() == 5 && s.one.size() == 3 && s.two.size() == 2 && s.one[0] == 5 && s.two[1] == 9;
+    ring.release(0, 5);
+
+    std::vector<int> seen;
+    while (ring.try_available(1).size() != 0) {
+        ring.consume(1, [&](int x) { seen.push_back(x); });
+    }
+    result = result && seen == std::vector<int> { 2, 3, 4, 5, 6, 7, 8, 9 } && ring.cursor(1) == 10;
+
+    // With the slowest consumer caught up, the whole ring is free again.
+    result = result && ring.try_claim(8, slots) && slots.size() == 8;
+    return result;
+}
+
+bool test_multicast_ring_concurrent()
+{
+    // A small ring and odd batch sizes, so that the producer keeps waiting for the consumers and the batches wrap.
+    return multicast(5, 1'000'000, 64, 7, yield_wait {})
+        && multicast(5, 200'000, 64, 64, sleep_wait {})
+        && multicast(1, 200'000, 1, 1, yield_wait {})
+        && fan_out(3, 200'000, 64, 7, yield_wait {});
+}
+
+void test_multicast_ring_performance()
+{
+    const std::uint64_t total = 20'000'000;
+    for (std::size_t consumers : { 1, 2, 5 }) {
+        // Spinning threads only make sense with a core for each of them.
+        if (std::thread::hardware_concurrency() > consumers) {
+            compare("busy spin", consumers, total, busy_spin_wait {});
+        }
+        compare("yield", consumers, total, yield_wait {});
+        compare("sleep", consumers, total, sleep_wait {});
+    }
+}
@@ -0,0 +1,123 @@
+#include "pair_vector_tests.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "buffer.hpp"
+#include "pair_vector.hpp"
+
+namespace {
+
+struct empty_tag { };
+
+// Three quarters of every pair is value.
+using value_block = buffer<double, 3>;
+
+template<typename F>
+double seconds_for(F f)
+{
+    using namespace std::chrono;
+    high_resolution_clock clock {};
+    auto t1 = clock.now();
+    f();
+    auto t2 = clock.now();
+    return duration_cast<duration<double>>(t2 - t1).count();
+}
+
+}
+
+bool test_simple_pair_compression()
+{
+    bool result = true;
+    // Empty members take no room...
+    result = result && sizeof(simple_pair<int, empty_tag>) == sizeof(int);
+    result = result && sizeof(simple_pair<empty_tag, double>) == sizeof(double);
+    // ...but two objects of the same type still need different addresses.
+    result = result && sizeof(simple_pair<empty_tag, empty_tag>) == 2;
+    // Non empty members are laid out as before.
+    result = result && sizeof(simple_pair<int, double>) == 2 * sizeof(double);
+
+    // Still an aggregate with first and second.
+    simple_pair<int, empty_tag> p { 5, {} };
+    simple_pair<std::string, int> q { "key", 3 };
+    result = result && p.first == 5 && q.first == "key" && q.second == 3;
+    return result;
+}
+
+bool test_pair_vector()
+{
+    bool result = true;
+    pair_vector<int, std::string> v;
+    for (int i = 0; i != 10; ++i) {
+        v.push_back({ i, std::to_string(i * i) });
+    }
+    result = result && v.size() == 10 && v.firsts().size() == 10 && v.seconds()[3] == "9";
+
+    // The proxy works like a pair.
+    v[2].second = "four";
+    v[4] = simple_pair<int, std::string> { 40, "sixteen" };
+    simple_pair<int, std::string> p = v[4];
+    result = result && v[2].second == "four" && p.first == 40 && p.second == "sixteen";
+
+    auto it = v.find(7);
+    result = result && it != v.end() && (*it).second == "49" && it - v.begin() == 7;
+    result = result && v.find(4) == v.end();
+
+    int sum = 0;
+    for (auto q : v) {
+        sum += q.first;
+        q.second += "!";
+    }
+    result = result && sum == 45 - 4 + 40 && v[9].second == "81!";
+
+    const pair_vector<int, std::string>& c = v;
+    pair_vector<int, std::string>::const_iterator ci = v.begin();
+    result = result && (*ci).first == 0 && c.find(9) != c.end() && c[1].second == "1!";
+
+    v.pop_back();
+    v.clear();
+    result = result && v.empty() && v.begin() == v.end();
+    return result;
+}
+
+void test_pair_vector_performance()
+{
+    const int n = 1 << 20;
+    const int lookups = 200;
+    std::vector<simple_pair<std::int64_t, value_block>> pairs;
+    pair_vector<std::int64_t, value_block> split;
+    pairs.reserve(n);
+    split.reserve(n);
+    for (int i = 0; i != n; ++i) {
+        value_block b(static_cast<double>(i));
+        pairs.push_back({ 3 * i, b });
+        split.push_back(3 * i, b);
+    }
+
+    std::cout << "Memory footprint: vector of pairs " << pairs.size() * sizeof(pairs[0]) / (1024 * 1024)
+              << " MB, pair_vector " << split.memory_footprint() / (1024 * 1024) << " MB "
+              << "(keys " << n * sizeof(std::int64_t) / (1024 * 1024) << " MB)\n";
+
+    // Look up keys spread over the whole range, so each scan reads about half of the keys.
+    double found_pairs = 0;
+    double t1 = seconds_for([&]() {
+        for (int k = 0; k != lookups; ++k) {
+            std::int64_t key = 3 * ((k * 7919) % n);
+            auto it = std::find_if(pairs.begin(), pairs.end(),
+                                   [key](const simple_pair<std::int64_t, value_block>& p) { return p.first == key; });
+            found_pairs += (*it).second[0];
+        }
+    });
+    double found_split = 0;
+    double t2 = seconds_for([&]() {
+        for (int k = 0; k != lookups; ++k) {
+            std::int64_t key = 3 * ((k * 7919) % n);
+            found_split += (*split.find(key)).second[0];
+        }
+    });
+    std::cout << "Key scans, vector of pairs: " << t1 << "s\n";
+    std::cout << "Key scans, pair_vector: " << t2 << "s (" << (found_pairs == found_split ? "same" : "different")
+              << " values found)\n\n";
+}
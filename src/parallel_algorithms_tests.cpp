@@ -0,0 +1,233 @@
+#include "parallel_algorithms_tests.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "parallel_algorithms.hpp"
+#include "revision_2.hpp"
+
+using std::cout;
+
+namespace {
+
+// Enough elements for a few dozen chunks.
+constexpr int test_size = 1 << 20;
+
+int test_value(std::size_t i)
+{
+    return static_cast<int>(i % 2001) - 1000;
+}
+
+// A ring whose contents wrap around somewhere in the middle of the underlying array.
+circular_buffer<int> make_wrapped_ring(std::size_t capacity, std::size_t size, std::size_t shift)
+{
+    circular_buffer<int> cb(capacity);
+    for (std::size_t i = 0; i != shift; ++i) {
+        cb.push_back(0);
+    }
+    cb.pop_front_n(shift);
+    for (std::size_t i = 0; i != size; ++i) {
+        cb.push_back(test_value(i));
+    }
+    return cb;
+}
+
+}
+
+bool test_parallel_algorithms()
+{
+    bool result = true;
+    thread_pool pool(4);
+
+    // Buffers of this size do not fit on the stack.
+    using big_buffer = buffer<int, test_size>;
+    auto a = std::make_unique<big_buffer>();
+    auto b = std::make_unique<big_buffer>();
+    auto c = std::make_unique<big_buffer>();
+    auto out = std::make_unique<big_buffer>();
+    for (int i = 0; i != test_size; ++i) {
+        (*a)[i] = test_value(i);
+        (*b)[i] = test_value(i * 7);
+        (*c)[i] = i % 3;
+    }
+
+    // abs_int on every element, in place.
+    auto abs_a = std::make_unique<big_buffer>(*a);
+    parallel_for_each(pool, *abs_a, [](int& x) { x = abs_int {}(x); });
+    for (int i = 0; i != test_size; ++i) {
+        result = result && (*abs_a)[i] == abs_int {}((*a)[i]);
+    }
+
+    // The same through transform.
+    parallel_transform(pool, *a, *out, abs_int {});
+    for (int i = 0; i != test_size; ++i) {
+        result = result && (*out)[i] == (*abs_a)[i];
+    }
+
+    parallel_transform(pool, *a, *b, *out, std::plus<int> {});
+    for (int i = 0; i != test_size; ++i) {
+        result = result && (*out)[i] == (*a)[i] + (*b)[i];
+    }
+
+    parallel_transform(pool, *a, *b, *c, *out, square_add_3 {});
+    for (int i = 0; i != test_size; ++i) {
+        result = result && (*out)[i] == square_add_3 {}((*a)[i], (*b)[i], (*c)[i]);
+    }
+
+    long long expected = 0;
+    for (int i = 0; i != test_size; ++i) {
+        expected += (*abs_a)[i];
+    }
+    result = result && parallel_reduce(pool, *abs_a, 0LL, std::plus<long long> {}) == expected;
+
+    // A reduction which is associative but not commutative: the chunks must be combined in order.
+    auto last = [](int, int y) { return y; };
+    result = result && parallel_reduce(pool, *a, 12345, last) == (*a)[test_size - 1];
+
+    // Small buffers are a single chunk.
+    buffer<int, 5> small;
+    for (int i = 0; i != 5; ++i) {
+        small[i] = -i;
+    }
+    parallel_for_each(pool, small, [](int& x) { x = abs_int {}(x); });
+    result = result && parallel_reduce(pool, small, 0, std::plus<int> {}) == 10;
+
+    return result;
+}
+
+bool test_parallel_algorithms_wrap_around()
+{
+    bool result = true;
+    thread_pool pool(3);
+
+    // Different wrap around points for the input and the output.
+    const std::size_t size = test_size + 17;
+    circular_buffer<int> in = make_wrapped_ring(size + 5, size, 1001);
+    circular_buffer<int> out = make_wrapped_ring(size, size, 250000);
+    result = result && !in.array_two().empty() && !out.array_two().empty();
+    result = result && in.array_one().size() + in.array_two().size() == in.size();
+
+    parallel_transform(pool, in, out, abs_int {});
+    for (std::size_t i = 0; i != size; ++i) {
+        result = result && out[i] == abs_int {}(in[i]);
+    }
+
+    parallel_transform(pool, in, in, out, out, square_add_3 {});
+    for (std::size_t i = 0; i != size; ++i) {
+        result = result && out[i] == square_add_3 {}(in[i], in[i], abs_int {}(in[i]));
+    }
+
+    // Chunks must cover every element exactly once.
+    parallel_for_each(pool, in, [](int& x) { x += 1; });
+    for (std::size_t i = 0; i != size; ++i) {
+        result = result && in[i] == test_value(i) + 1;
+    }
+
+    long long expected = 0;
+    for (std::size_t i = 0; i != size; ++i) {
+        expected += in[i];
+    }
+    result = result && parallel_reduce(pool, in, 0LL, std::plus<long long> {}) == expected;
+
+    // Mixed containers: write a buffer from a ring.
+    auto b = std::make_unique<buffer<int, test_size>>();
+    circular_buffer<int> ring = make_wrapped_ring(test_size, test_size, 77);
+    parallel_transform(pool, ring, *b, abs_int {});
+    for (int i = 0; i != test_size; ++i) {
+        result = result && (*b)[i] == abs_int {}(ring[i]);
+    }
+
+    // Reductions to another type than the elements: the smallest and the largest element at once.
+    // reduce combines two ranges, transform makes a range of one element.
+    using range = std::pair<int, int>;
+    auto widen = [](const range& x, const range& y) {
+        return range(std::min(x.first, y.first), std::max(x.second, y.second));
+    };
+    range expected_range(in[0], in[0]);
+    for (std::size_t i = 0; i != size; ++i) {
+        expected_range = widen(expected_range, range(in[i], in[i]));
+    }
+    result = result
+        && parallel_transform_reduce(pool, in, range(in[0], in[0]), widen, [](int x) { return range(x, x); })
+            == expected_range;
+
+    // Empty containers do nothing.
+    circular_buffer<int> empty(10);
+    parallel_for_each(pool, empty, [](int& x) { x = 1; });
+    result = result && parallel_reduce(pool, empty, 7, std::plus<int> {}) == 7;
+
+    return result;
+}
+
+void test_parallel_algorithms_performance()
+{
+    using namespace std::chrono;
+
+    // 32M ints (128 MB) for each container.
+    constexpr int n = 1 << 25;
+    using big_buffer = buffer<int, n>;
+    auto a = std::make_unique<big_buffer>();
+    auto out = std::make_unique<big_buffer>();
+    for (int i = 0; i != n; ++i) {
+        (*a)[i] = test_value(i);
+    }
+    circular_buffer<int> ring = make_wrapped_ring(n, n, n / 3);
+    circular_buffer<int> ring_out = make_wrapped_ring(n, n, n / 2);
+
+    auto gigabytes_per_second = [&](high_resolution_clock::duration d, int bytes_per_element) {
+        double seconds = duration_cast<duration<double>>(d).count();
+        return static_cast<double>(n) * bytes_per_element / seconds / 1e9;
+    };
+
+    high_resolution_clock clock {};
+
+    // What we used to do: a loop on a single thread.
+    auto t1 = clock.now();
+    for (int i = 0; i != n; ++i) {
+        (*out)[i] = abs_int {}((*a)[i]);
+    }
+    auto t2 = clock.now();
+    long long sum = 0;
+    for (std::size_t i = 0; i != ring.size(); ++i) {
+        sum += ring[i];
+    }
+    auto t3 = clock.now();
+    cout << "Sequential transform (buffer): " << gigabytes_per_second(t2 - t1, 8) << " GB/s\n"
+         << "Sequential reduce (circular_buffer, operator[]): " << gigabytes_per_second(t3 - t2, 4) << " GB/s"
+         << " (sum " << sum << ")\n\n";
+
+    std::size_t max_threads = std::thread::hardware_concurrency();
+    if (max_threads == 0) {
+        max_threads = 1;
+    }
+    // 1, 2, 4, ... threads and finally all of them.
+    std::vector<std::size_t> thread_counts;
+    for (std::size_t threads = 1; threads < max_threads; threads *= 2) {
+        thread_counts.push_back(threads);
+    }
+    thread_counts.push_back(max_threads);
+
+    for (std::size_t threads : thread_counts) {
+        thread_pool pool(threads);
+        auto t4 = clock.now();
+        parallel_for_each(pool, *a, [](int& x) { x = abs_int {}(x); });
+        auto t5 = clock.now();
+        parallel_transform(pool, *a, *out, abs_int {});
+        auto t6 = clock.now();
+        parallel_transform(pool, ring, ring_out, abs_int {});
+        auto t7 = clock.now();
+        long long total = parallel_reduce(pool, ring, 0LL, std::plus<long long> {});
+        auto t8 = clock.now();
+        cout << threads << " thread(s):\n"
+             << "    for_each (buffer): " << gigabytes_per_second(t5 - t4, 8) << " GB/s\n"
+             << "    transform (buffer): " << gigabytes_per_second(t6 - t5, 8) << " GB/s\n"
+             << "    transform (circular_buffer): " << gigabytes_per_second(t7 - t6, 8) << " GB/s\n"
+             << "    reduce (circular_buffer): " << gigabytes_per_second(t8 - t7, 4) << " GB/s"
+             << " (sum " << total << ")\n\n";
+    }
+}
@@ -0,0 +1,281 @@
+#include "reductions_tests.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include "reductions.hpp"
+#include "revision.hpp"
+
+using std::cout;
+
+namespace {
+
+// Small integers: every partial sum of floats is exact, so the order of the additions does not matter.
+template<typename T>
+std::vector<T> test_values(std::size_t n)
+{
+    std::vector<T> v(n);
+    for (std::size_t i = 0; i != n; ++i) {
+        v[i] = static_cast<T>(static_cast<int>((i * 37) % 201) - 100);
+    }
+    return v;
+}
+
+// The obvious loops, for checking and for comparison.
+template<typename T, typename S = sum_type<T>>
+S naive_sum(const T* a, std::size_t n)
+{
+    S s {};
+    while (n != 0) {
+        s += *a;
+        ++a;
+        --n;
+    }
+    return s;
+}
+
+template<typename T, typename S = sum_type<T>>
+S naive_dot(const T* a, const T* b, std::size_t n)
+{
+    S s {};
+    for (std::size_t i = 0; i != n; ++i) {
+        s += static_cast<S>(a[i]) * b[i];
+    }
+    return s;
+}
+
+template<typename T>
+bool check_pointer_reductions(std::size_t n)
+{
+    std::vector<T> a = test_values<T>(n);
+    std::vector<T> b = test_values<T>(n + 7);
+    bool result = true;
+    result = result && sum(a.data(), n) == naive_sum(a.data(), n);
+    result = result && dot(a.data(), b.data() + 7, n) == naive_dot(a.data(), b.data() + 7, n);
+    result = result && sum_of_squares(a.data(), n) == naive_dot(a.data(), a.data(), n);
+    if (n != 0) {
+        T lo = a[0];
+        T hi = a[0];
+        for (T x : a) {
+            lo = x < lo ? x : lo;
+            hi = hi < x ? x : hi;
+        }
+        auto m = minmax(a.data(), n);
+        result = result && min(a.data(), n) == lo && max(a.data(), n) == hi && m.first == lo && m.second == hi;
+    }
+    return result;
+}
+
+bool same_color(const color_rgba& c1, const color_rgba& c2)
+{
+    return c1.r == c2.r && c1.g == c2.g && c1.b == c2.b && c1.a == c2.a;
+}
+
+}
+
+bool test_reductions()
+{
+    bool result = true;
+    // Sizes around the register widths and unrolling factors, so every tail loop is exercised.
+    for (std::size_t n : { 0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 32, 33, 63, 64, 65, 1000, 4099 }) {
+        result = result && check_pointer_reductions<float>(n);
+        result = result && check_pointer_reductions<double>(n);
+        result = result && check_pointer_reductions<std::int32_t>(n);
+        result = result && check_pointer_reductions<std::int16_t>(n);
+        result = result && check_pointer_reductions<unsigned char>(n);
+    }
+
+    // The extremes may be anywhere, including the very first and the very last element.
+    std::vector<float> v(100, 1.0f);
+    v[0] = -5.0f;
+    v[99] = 8.0f;
+    result = result && min(v.data(), v.size()) == -5.0f && max(v.data(), v.size()) == 8.0f;
+    v[0] = 9.0f;
+    v[99] = -6.0f;
+    result = result && minmax(v.data(), v.size()) == std::make_pair(-6.0f, 9.0f);
+
+    // 32 bit integers are summed in 64 bits.
+    std::vector<std::int32_t> big(1000, 2000000000);
+    result = result && sum(big.data(), big.size()) == 2000000000LL * 1000;
+
+    // User types only need += (here a saturating one, which leaves alpha alone).
+    std::vector<color_rgba> colors(10, make_color_rgba(10, 20, 30, 40));
+    result = result && same_color(sum(colors.data(), colors.size()), make_color_rgba(100, 200, 255, 0));
+    result = result && same_color(sum(colors.data(), 0), color_rgba {});
+
+    return result;
+}
+
+bool test_reductions_containers()
+{
+    bool result = true;
+    std::vector<int> values = test_values<int>(1000);
+
+    buffer<int, 1000> b;
+    for (int i = 0; i != 1000; ++i) {
+        b[i] = values[i];
+    }
+    result = result && sum(b) == naive_sum(values.data(), 1000);
+    result = result && sum_of_squares(b) == naive_dot(values.data(), values.data(), 1000);
+    result = result && dot(b, b) == sum_of_squares(b);
+    result = result && min(b) == -100 && max(b) == 100 && minmax(b) == std::make_pair(-100, 100);
+
+    // Two rings with the same contents which wrap around at different places.
+    circular_buffer<int> x(1100);
+    circular_buffer<int> y(1000);
+    for (int i = 0; i != 700; ++i) {
+        x.push_back(0);
+    }
+    x.pop_front_n(700);
+    for (int i = 0; i != 1300; ++i) {
+        y.push_back(i < 300 ? 1000 : values[i - 300]);
+    }
+    for (int v : values) {
+        x.push_back(v);
+    }
+    result = result && !x.array_two().empty() && !y.array_two().empty();
+    result = result && sum(x) == sum(b) && sum(y) == sum(b);
+    result = result && dot(x, y) == dot(b, b) && sum_of_squares(y) == sum_of_squares(b);
+    result = result && min(x) == -100 && max(y) == 100 && minmax(x) == minmax(y);
+
+    // The segments themselves.
+    result = result && sum(x.array_one()) + sum(x.array_two()) == sum(x);
+
+    const circular_buffer<float> empty(10);
+    result = result && sum(empty) == 0.0f;
+
+    return result;
+}
+
+void test_reductions_performance()
+{
+    using namespace std::chrono;
+
+    // 64 MB of each element type, a bit bigger than the last level cache, summed a few times.
+    const std::size_t bytes = 64 << 20;
+    const int repetitions = 10;
+
+    high_resolution_clock clock {};
+    auto report = [&](const char* name, high_resolution_clock::duration naive, high_resolution_clock::duration fast,
+                      std::size_t bytes_read) {
+        double naive_seconds = duration_cast<duration<double>>(naive).count();
+        double fast_seconds = duration_cast<duration<double>>(fast).count();
+        cout << name << ": naive " << bytes_read * repetitions / naive_seconds / 1e9 << " GB/s, reductions "
+             << bytes_read * repetitions / fast_seconds / 1e9 << " GB/s\n";
+    };
+
+    // Keeps the compiler from throwing the results away. Every repetition also changes an element,
+    // otherwise the compiler may notice it computes the same thing again and only do it once.
+    double sink = 0;
+
+    {
+        std::vector<float> a = test_values<float>(bytes / sizeof(float));
+        std::vector<float> b = test_values<float>(bytes / sizeof(float));
+        auto t1 = clock.now();
+        for (int k = 0; k < repetitions; ++k) {
+            a[k] = static_cast<float>(k);
+            sink += naive_sum(a.data(), a.size());
+        }
+        auto t2 = clock.now();
+        for (int k = 0; k < repetitions; ++k) {
+            a[k] = static_cast<float>(k);
+            sink += sum(a.data(), a.size());
+        }
+        auto t3 = clock.now();
+        report("float sum", t2 - t1, t3 - t2, bytes);
+
+        t1 = clock.now();
+        for (int k = 0; k < repetitions; ++k) {
+            a[k] = static_cast<float>(k);
+            sink += naive_dot(a.data(), b.data(), a.size());
+        }
+        t2 = clock.now();
+        for (int k = 0; k < repetitions; ++k) {
+            a[k] = static_cast<float>(k);
+            sink += dot(a.data(), b.data(), a.size());
+        }
+        t3 = clock.now();
+        report("float dot", t2 - t1, t3 - t2, 2 * bytes);
+
+        t1 = clock.now();
+        for (int k = 0; k < repetitions; ++k) {
+            a[k] = static_cast<float>(k);
+            float lo = a[0];
+            float hi = a[0];
+            for (float x : a) {
+                lo = x < lo ? x : lo;
+                hi = hi < x ? x : hi;
+            }
+            sink += lo + hi;
+        }
+        t2 = clock.now();
+        for (int k = 0; k < repetitions; ++k) {
+            a[k] = static_cast<float>(k);
+            auto m = minmax(a.data(), a.size());
+            sink += m.first + m.second;
+        }
+        t3 = clock.now();
+        report("float minmax", t2 - t1, t3 - t2, bytes);
+    }
+    {
+        std::vector<double> a = test_values<double>(bytes / sizeof(double));
+        auto t1 = clock.now();
+        for (int k = 0; k < repetitions; ++k) {
+            a[k] = static_cast<double>(k);
+            sink += naive_dot(a.data(), a.data(), a.size());
+        }
+        auto t2 = clock.now();
+        for (int k = 0; k < repetitions; ++k) {
+            a[k] = static_cast<double>(k);
+            sink += sum_of_squares(a.data(), a.size());
+        }
+        auto t3 = clock.now();
+        report("double sum of squares", t2 - t1, t3 - t2, bytes);
+    }
+    {
+        // A ring of ints against the obvious loop through operator[].
+        const std::size_t n = bytes / sizeof(int);
+        circular_buffer<int> ring(n);
+        std::vector<int> values = test_values<int>(n);
+        for (std::size_t i = 0; i != n / 3; ++i) {
+            ring.push_back(0);
+        }
+        for (int v : values) {
+            ring.push_back(v);
+        }
+        auto t1 = clock.now();
+        for (int k = 0; k < repetitions; ++k) {
+            ring[k] = k;
+            long long s = 0;
+            for (std::size_t i = 0; i != ring.size(); ++i) {
+                s += ring[i];
+            }
+            sink += s;
+        }
+        auto t2 = clock.now();
+        for (int k = 0; k < repetitions; ++k) {
+            ring[k] = k;
+            sink += sum(ring);
+        }
+        auto t3 = clock.now();
+        report("circular_buffer<int> sum", t2 - t1, t3 - t2, bytes);
+    }
+    {
+        std::vector<color_rgba> colors(bytes / sizeof(color_rgba), make_color_rgba(0, 1, 0, 0));
+        auto t1 = clock.now();
+        for (int k = 0; k < repetitions; ++k) {
+            colors[k].g = static_cast<unsigned char>(k);
+            sink += naive_sum(colors.data(), colors.size()).g;
+        }
+        auto t2 = clock.now();
+        for (int k = 0; k < repetitions; ++k) {
+            colors[k].g = static_cast<unsigned char>(k);
+            sink += sum(colors.data(), colors.size()).g;
+        }
+        auto t3 = clock.now();
+        report("color_rgba sum", t2 - t1, t3 - t2, bytes);
+    }
+    cout << "(checksum " << sink << ")\n\n";
+}
@@ -5,41 +5,8 @@
 using namespace std;
 
 /// Callable objects in C++
-// 1) Free Functions
-// 2) Member functions
-// 3) Classes/structs overloading the () operator
-
-// Defining a function object is very simple. We just need to overload the function call
-// operator, also known as (). Here are several examples:
-// A simple function object imitating a function.
-struct abs_int {
-    int operator()(int a) const
-    {
-        return a < 0 ? -a : a;
-    }
-};
-
-// A function object can be useful when you need to store some state. 
-// Store a number at construction and then use that number to compare
-// integers passed to it later.
-struct less_than_n {
-    int n;
-    less_than_n(int m) : n{n} {}
-    bool operator()(int a) const
-    {
-        return a < n;
-    }
-};
-
-// Unlike the other ordinary operators, the function call operator can take in an arbitrary
-// number of operators.
-// Square three numbers and add them together.
-struct square_add_3 {
-    int operator()(int a, int b, int c) const
-    {
-        return (a*a + b*b + c*c);
-    }
-};
+// The function objects abs_int, less_than_n and square_add_3 are defined in revision_2.hpp, so that
+// other algorithms (for example the parallel ones in parallel_algorithms.hpp) can use them as well.
 
 // Test function objects
 void test_function_objects()
@@ -161,6 +128,7 @@ void test_pair()
 // be totally ordered for the second one for the algorithm to be well defined. The reasons go deeper than mere
 // definition of the operators. The regular type axioms are really important as well.
 
+// A single chain of additions, each waiting for the previous one. See reductions.hpp for how to do it fast.
 template<typename T>
 T sum(T* a, int n)
 {
@@ -170,6 +138,7 @@ T sum(T* a, int n)
         // T should model a more complicated type but we will not deal with this for now.
         s += *a;
         ++a;
+        --n;
     }
     // In order to return from the function, we need to copy the type T.
     // It better be at least a regular type or summing over T-s would not make much sense,
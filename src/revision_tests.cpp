@@ -4,6 +4,18 @@
 #include "revision_2.hpp"
 #include "singleton.hpp"
 #include "buffer.hpp"
+#include "color_kernels.hpp"
+#include "heap_buffer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
 
 using namespace std;
 
@@ -80,4 +92,738 @@ void revision_test()
     blue *= 0.5f;
     color_rgba light_grey = (red * 1.5f) + (1.5f * green) + (1.5f * blue);
     std::cout << red << green << blue << light_grey << std::endl;
-}
\ No newline at end of file
+}
+
+bool test_color_kernels()
+{
+    bool result = true;
+
+    // Every pair of channel values for add and subtract. Red and green take the values from the pair, blue gets
+    // something else and alpha must never change. The odd count also exercises the scalar tail.
+    const std::size_t count = 256 * 256 + 3;
+    std::vector<color_rgba> lhs(count);
+    std::vector<color_rgba> rhs(count);
+    for (std::size_t i = 0; i != count; ++i) {
+        unsigned char x = static_cast<unsigned char>(i / 256);
+        unsigned char y = static_cast<unsigned char>(i % 256);
+        lhs[i] = make_color_rgba(x, y, static_cast<unsigned char>(x ^ y), static_cast<unsigned char>(i * 7));
+        rhs[i] = make_color_rgba(y, x, static_cast<unsigned char>(x + y), static_cast<unsigned char>(i * 13));
+    }
+
+    auto same = [](const color_rgba& c1, const color_rgba& c2) {
+        return c1.r == c2.r && c1.g == c2.g && c1.b == c2.b && c1.a == c2.a;
+    };
+
+    std::vector<color_rgba> sum = lhs;
+    std::vector<color_rgba> difference = lhs;
+    add_colors(sum.data(), rhs.data(), count);
+    subtract_colors(difference.data(), rhs.data(), count);
+    for (std::size_t i = 0; i != count; ++i) {
+        result = result && same(sum[i], lhs[i] + rhs[i]) && same(difference[i], lhs[i] - rhs[i]);
+    }
+
+    // Scaling by a range of factors, including negative ones, ones that saturate and awkward fractions.
+    const float factors[] = { 0.0f, 0.5f, 1.0f, 1.5f, -0.75f, 1.0f / 3.0f, 2.0f / 3.0f, 0.1f, 0.7f,
+                              1.1f, 3.999f, 255.0f, 300.0f, 0.00390625f, 0.999999f, 1.000001f };
+    for (float s : factors) {
+        std::vector<color_rgba> scaled = lhs;
+        scale_colors(scaled.data(), count, s);
+        for (std::size_t i = 0; i != count; ++i) {
+            result = result && same(scaled[i], lhs[i] * s);
+        }
+    }
+    for (int k = 0; k != 1000; ++k) {
+        float s = k * 0.00731f;
+        std::vector<color_rgba> scaled(lhs.begin(), lhs.begin() + 1024);
+        scale_colors(scaled.data(), scaled.size(), s);
+        for (std::size_t i = 0; i != scaled.size(); ++i) {
+            result = result && same(scaled[i], lhs[i] * s);
+        }
+    }
+
+    return result;
+}
+
+void test_color_kernels_performance()
+{
+    using namespace std::chrono;
+
+    // One 4K frame.
+    const std::size_t count = 3840 * 2160;
+    const int repetitions = 20;
+    std::vector<color_rgba> frame(count);
+    std::vector<color_rgba> other(count);
+    for (std::size_t i = 0; i != count; ++i) {
+        frame[i] = make_color_rgba(i % 256, (i / 7) % 256, (i / 3) % 256, 255);
+        other[i] = make_color_rgba((i / 5) % 256, i % 128, (i * 3) % 256, 0);
+    }
+
+    auto megapixels_per_second = [&](high_resolution_clock::duration d) {
+        double seconds = duration_cast<duration<double>>(d).count();
+        return static_cast<double>(count) * repetitions / seconds / 1e6;
+    };
+
+    high_resolution_clock clock {};
+    cout << "Batch color kernels compiled for: " << color_kernels_instruction_set() << "\n\n";
+
+    auto t1 = clock.now();
+    for (int k = 0; k < repetitions; ++k) {
+        for (std::size_t i = 0; i != count; ++i) {
+            frame[i] += other[i];
+        }
+    }
+    auto t2 = clock.now();
+    for (int k = 0; k < repetitions; ++k) {
+        add_colors(frame.data(), other.data(), count);
+    }
+    auto t3 = clock.now();
+    cout << "Add with operator+=: " << megapixels_per_second(t2 - t1) << " MP/s\n"
+         << "Add with add_colors: " << megapixels_per_second(t3 - t2) << " MP/s\n\n";
+
+    t1 = clock.now();
+    for (int k = 0; k < repetitions; ++k) {
+        for (std::size_t i = 0; i != count; ++i) {
+            frame[i] -= other[i];
+        }
+    }
+    t2 = clock.now();
+    for (int k = 0; k < repetitions; ++k) {
+        subtract_colors(frame.data(), other.data(), count);
+    }
+    t3 = clock.now();
+    cout << "Subtract with operator-=: " << megapixels_per_second(t2 - t1) << " MP/s\n"
+         << "Subtract with subtract_colors: " << megapixels_per_second(t3 - t2) << " MP/s\n\n";
+
+    t1 = clock.now();
+    for (int k = 0; k < repetitions; ++k) {
+        for (std::size_t i = 0; i != count; ++i) {
+            frame[i] *= 1.01f;
+        }
+    }
+    t2 = clock.now();
+    for (int k = 0; k < repetitions; ++k) {
+        scale_colors(frame.data(), count, 1.01f);
+    }
+    t3 = clock.now();
+    cout << "Scale with operator*=: " << megapixels_per_second(t2 - t1) << " MP/s\n"
+         << "Scale with scale_colors: " << megapixels_per_second(t3 - t2) << " MP/s\n\n";
+}
+
+bool test_buffer_expressions()
+{
+    bool result = true;
+
+    buffer<int, 5> b1(10);
+    buffer<int, 5> b2(3);
+    buffer<int, 5> b3(20);
+    buffer<int, 5> b4(1);
+    for (int i = 0; i != 5; ++i) {
+        b2[i] = i;
+    }
+
+    buffer<int, 5> r = b1 + b2 - b3 + b4;
+    for (int i = 0; i != 5; ++i) {
+        result = result && r[i] == 10 + i - 20 + 1;
+    }
+
+    // Scalars on either side and user function objects.
+    auto negate = [](int x) { return -x; };
+    auto larger = [](int x, int y) { return x < y ? y : x; };
+    r = 2 * (b1 - b3) * 3 + element_wise(b2, negate);
+    for (int i = 0; i != 5; ++i) {
+        result = result && r[i] == 2 * (10 - 20) * 3 - i;
+    }
+    r = element_wise(b2 * 4, b1, larger);
+    for (int i = 0; i != 5; ++i) {
+        result = result && r[i] == (4 * i < 10 ? 10 : 4 * i);
+    }
+
+    // Element i of the result only depends on element i of the operands, so aliasing is fine.
+    r = b2;
+    r = r + r + b4;
+    r += b2 - b4;
+    for (int i = 0; i != 5; ++i) {
+        result = result && r[i] == 3 * i;
+    }
+
+    // Works for any T with the right operators.
+    buffer<string, 2> s1("ab");
+    buffer<string, 2> s2("cd");
+    buffer<string, 2> s3 = s1 + s2 + s1;
+    result = result && s3[0] == "abcdab" && s3[1] == "abcdab";
+
+    return result;
+}
+
+namespace {
+
+// What b1 + b2 - b3 + b4 used to do: every operator made a full temporary.
+template<typename T, int N>
+void eager_chain(const buffer<T, N>& b1, const buffer<T, N>& b2, const buffer<T, N>& b3, const buffer<T, N>& b4,
+                 buffer<T, N>& out, buffer<T, N>& t1, buffer<T, N>& t2, buffer<T, N>& t3)
+{
+    t1 = b1;
+    t1 += b2;
+    t2 = t1;
+    t2 -= b3;
+    t3 = t2;
+    t3 += b4;
+    out = t3;
+}
+
+template<int N>
+void buffer_expressions_performance(long long total_elements)
+{
+    using namespace std::chrono;
+    using buffer_type = buffer<float, N>;
+
+    // Big buffers do not fit on the stack.
+    std::unique_ptr<buffer_type[]> b(new buffer_type[8]);
+    for (int i = 0; i != N; ++i) {
+        b[0][i] = i * 0.5f;
+        b[1][i] = i * 0.25f;
+        b[2][i] = 1.0f;
+        b[3][i] = 2.0f;
+    }
+    const long long repetitions = total_elements / N;
+
+    high_resolution_clock clock {};
+    auto t1 = clock.now();
+    for (long long k = 0; k < repetitions; ++k) {
+        eager_chain(b[0], b[1], b[2], b[3], b[4], b[5], b[6], b[7]);
+        b[0][k % N] = b[4][(k + 1) % N];
+    }
+    auto t2 = clock.now();
+    for (long long k = 0; k < repetitions; ++k) {
+        b[4] = b[0] + b[1] - b[2] + b[3];
+        b[0][k % N] = b[4][(k + 1) % N];
+    }
+    auto t3 = clock.now();
+
+    cout << "N = " << N << ": temporaries " << duration_cast<milliseconds>(t2 - t1).count() << " ms, "
+         << "fused expression " << duration_cast<milliseconds>(t3 - t2).count() << " ms\n\n";
+}
+
+}
+
+void test_buffer_expressions_performance()
+{
+    // The same number of elements is processed for every size.
+    const long long total_elements = 500'000'000;
+    buffer_expressions_performance<16>(total_elements);
+    buffer_expressions_performance<1024>(total_elements);
+    buffer_expressions_performance<1 << 20>(total_elements);
+}
+
+namespace {
+
+// Compares every operation of buffer<T, N> with the generic loops. The values are small integers so that
+// the float results are exact whether or not the multiply-add is fused.
+template<typename T, int N>
+bool check_buffer_kernels()
+{
+    bool result = true;
+
+    buffer<T, N> x;
+    buffer<T, N> a;
+    buffer<T, N> b;
+    T expected[N];
+    for (int i = 0; i != N; ++i) {
+        x[i] = static_cast<T>(i % 11);
+        a[i] = static_cast<T>(i % 7 + 1);
+        b[i] = static_cast<T>(i % 5 - 2);
+        expected[i] = x[i];
+    }
+
+    x += a;
+    generic_buffer_kernels<T>::add(expected, &a[0], N);
+    x -= b;
+    generic_buffer_kernels<T>::sub(expected, &b[0], N);
+    x *= a;
+    generic_buffer_kernels<T>::mul(expected, &a[0], N);
+    x.fma(a, b);
+    generic_buffer_kernels<T>::fma(expected, &a[0], &b[0], N);
+
+    for (int i = 0; i != N; ++i) {
+        result = result && x[i] == expected[i];
+    }
+    return result;
+}
+
+template<typename T>
+bool check_buffer_kernels_sizes()
+{
+    return check_buffer_kernels<T, 1>() && check_buffer_kernels<T, 4>() && check_buffer_kernels<T, 7>()
+        && check_buffer_kernels<T, 16>() && check_buffer_kernels<T, 37>() && check_buffer_kernels<T, 256>();
+}
+
+}
+
+bool test_buffer_kernels()
+{
+    bool result = true;
+
+    result = result && check_buffer_kernels_sizes<float>();
+    result = result && check_buffer_kernels_sizes<double>();
+    result = result && check_buffer_kernels_sizes<std::int32_t>();
+    result = result && check_buffer_kernels_sizes<std::int16_t>();
+    // A type without a specialization uses the generic loops.
+    result = result && check_buffer_kernels_sizes<long long>();
+
+    // Aligned to a cache line, unless the buffer is smaller than that.
+    result = result && alignof(buffer<float, 16>) == 64 && alignof(buffer<double, 256>) == 64;
+    result = result && alignof(buffer<float, 4>) == 16 && sizeof(buffer<float, 4>) == 16;
+    result = result && alignof(buffer<char, 3>) == 2 && sizeof(buffer<char, 3>) == 4;
+
+    buffer<float, 8> f(2.5f);
+    buffer<int, 8> z;
+    for (int i = 0; i != 8; ++i) {
+        result = result && f[i] == 2.5f && z[i] == 0;
+    }
+
+    return result;
+}
+
+namespace {
+
+// Many small buffers, like the millions of small vectors per second we process.
+template<typename T, int N>
+void buffer_kernels_performance(const char* type_name)
+{
+    using namespace std::chrono;
+
+    const int count = 4096;
+    const long long total_elements = 200'000'000;
+    const long long repetitions = total_elements / (static_cast<long long>(count) * N);
+    std::vector<buffer<T, N>> x(count);
+    std::vector<buffer<T, N>> a(count);
+    for (int k = 0; k != count; ++k) {
+        for (int i = 0; i != N; ++i) {
+            x[k][i] = static_cast<T>(i % 3);
+            a[k][i] = static_cast<T>(1);
+        }
+    }
+
+    high_resolution_clock clock {};
+    auto t1 = clock.now();
+    for (long long r = 0; r < repetitions; ++r) {
+        for (int k = 0; k != count; ++k) {
+            generic_buffer_kernels<T>::fma(&x[k][0], &a[k][0], &a[(k + 1) % count][0], N);
+            generic_buffer_kernels<T>::sub(&x[k][0], &a[k][0], N);
+        }
+    }
+    auto t2 = clock.now();
+    for (long long r = 0; r < repetitions; ++r) {
+        for (int k = 0; k != count; ++k) {
+            x[k].fma(a[k], a[(k + 1) % count]);
+            x[k] -= a[k];
+        }
+    }
+    auto t3 = clock.now();
+
+    auto generic_ms = duration_cast<duration<double, std::milli>>(t2 - t1).count();
+    auto simd_ms = duration_cast<duration<double, std::milli>>(t3 - t2).count();
+    cout << "buffer<" << type_name << ", " << N << "> fma + sub: generic " << generic_ms << " ms, specialized "
+         << simd_ms << " ms, speedup " << generic_ms / simd_ms << "\n";
+}
+
+template<typename T>
+void buffer_kernels_performance_sizes(const char* type_name)
+{
+    buffer_kernels_performance<T, 4>(type_name);
+    buffer_kernels_performance<T, 16>(type_name);
+    buffer_kernels_performance<T, 256>(type_name);
+    cout << '\n';
+}
+
+}
+
+void test_buffer_kernels_performance()
+{
+    buffer_kernels_performance_sizes<float>("float");
+    buffer_kernels_performance_sizes<double>("double");
+    buffer_kernels_performance_sizes<std::int32_t>("int32_t");
+    buffer_kernels_performance_sizes<std::int16_t>("int16_t");
+}
+
+namespace {
+
+// Counts its live objects, and its move constructor throws when asked to.
+struct fragile {
+    static int live;
+    static bool throw_on_move;
+    int value;
+
+    fragile(int v = 0)
+        : value(v)
+    {
+        ++live;
+    }
+    fragile(const fragile& x)
+        : value(x.value)
+    {
+        ++live;
+    }
+    fragile(fragile&& x)
+        : value(x.value)
+    {
+        if (throw_on_move) {
+            throw std::runtime_error("fragile move");
+        }
+        ++live;
+    }
+    fragile& operator=(const fragile&) = default;
+    fragile& operator=(fragile&&) = default;
+    ~fragile()
+    {
+        --live;
+    }
+};
+
+int fragile::live = 0;
+bool fragile::throw_on_move = false;
+
+}
+
+bool test_heap_buffer()
+{
+    bool result = true;
+
+    // Small buffers live inside the object, big ones on the heap. They behave the same.
+    heap_buffer<int, 4> small(3, 2);
+    heap_buffer<int, 4> big(10, 5);
+    result = result && small.is_inline() && !big.is_inline();
+    result = result && small.size() == 3 && big.size() == 10;
+
+    heap_buffer<int, 4> small_sum = small + small - heap_buffer<int, 4>(3, 1);
+    heap_buffer<int, 4> big_product = big * big;
+    big_product += big;
+    for (int i = 0; i != 3; ++i) {
+        result = result && small_sum[i] == 3;
+    }
+    for (int i = 0; i != 10; ++i) {
+        result = result && big_product[i] == 30;
+    }
+
+    // Times a scalar, like a buffer.
+    heap_buffer<int, 4> small_scaled = 3 * small;
+    heap_buffer<int, 4> big_scaled = big * 2;
+    heap_buffer<double, 4> halves = heap_buffer<double, 4>(6, 3.0) * 0.5;
+    for (int i = 0; i != 3; ++i) {
+        result = result && small_scaled[i] == 6;
+    }
+    for (int i = 0; i != 10; ++i) {
+        result = result && big_scaled[i] == 10;
+    }
+    for (int i = 0; i != 6; ++i) {
+        result = result && halves[i] == 1.5;
+    }
+
+    get<1>(small) = 400;
+    result = result && get<1>(small) == 400 && heap_buffer<int, 4>(2)[1] == 0;
+
+    std::ostringstream out;
+    out << small;
+    print_buffer(out, heap_buffer<int, 4>(2, 7));
+    result = result && out.str() == "2 400 2 \n7 7 \n";
+
+    // Copies are independent, moves leave the source empty.
+    heap_buffer<string, 2> s1(2, "inline");
+    heap_buffer<string, 2> s2(5, "on the heap");
+    heap_buffer<string, 2> s3 = s1;
+    s3[0] = "changed";
+    result = result && s1[0] == "inline" && s3[0] == "changed";
+    heap_buffer<string, 2> s4 = std::move(s2);
+    result = result && s2.empty() && s4.size() == 5 && s4[4] == "on the heap" && !s4.is_inline();
+    s4 = s1;
+    result = result && s4.size() == 2 && s4.is_inline() && s4[1] == "inline";
+    s1 = std::move(s3);
+    result = result && s1[0] == "changed" && s3.empty();
+
+    // Moving cannot throw, so a growing vector moves its heap_buffers: the heap memory goes along.
+    static_assert(std::is_nothrow_move_constructible<heap_buffer<string, 2>>::value
+                  && std::is_nothrow_move_assignable<heap_buffer<int, 4>>::value, "heap_buffer moves cannot throw");
+    std::vector<heap_buffer<int, 4>> buffers;
+    buffers.emplace_back(10, 1);
+    const int* memory = buffers[0].data();
+    for (int i = 0; i != 20; ++i) {
+        buffers.emplace_back(i + 1, i);
+    }
+    result = result && buffers[0].data() == memory;
+
+    // A move which throws half way leaves both buffers valid, and holding what they say they hold.
+    static_assert(!std::is_nothrow_move_constructible<heap_buffer<fragile, 4>>::value, "fragile moves can throw");
+    {
+        heap_buffer<fragile, 4> a(3, fragile(1));
+        heap_buffer<fragile, 4> b(2, fragile(2));
+        fragile::throw_on_move = true;
+        bool threw = false;
+        try {
+            a = std::move(b);
+        }
+        catch (const std::runtime_error&) {
+            threw = true;
+        }
+        fragile::throw_on_move = false;
+        result = result && threw && a.empty() && b.size() == 2 && fragile::live == 2;
+
+        // Copy assignment copies to the side first and the copy is swapped in: a throwing move before anything
+        // changed leaves a as it was.
+        a = heap_buffer<fragile, 4>(1, fragile(3));
+        fragile::throw_on_move = true;
+        threw = false;
+        try {
+            a = b;
+        }
+        catch (const std::runtime_error&) {
+            threw = true;
+        }
+        fragile::throw_on_move = false;
+        result = result && threw && a.size() == 1 && a[0].value == 3 && fragile::live == 3;
+
+        // Without throwing, swap exchanges inline elements and heap memory alike.
+        heap_buffer<fragile, 4> c(6, fragile(4));
+        a.swap(c);
+        result = result && a.size() == 6 && a[5].value == 4 && c.size() == 1 && c[0].value == 3;
+        a.swap(b);
+        result = result && a.size() == 2 && a[0].value == 2 && b.size() == 6 && !b.is_inline();
+    }
+    result = result && fragile::live == 0;
+
+    return result;
+}
+
+void test_heap_buffer_performance()
+{
+    using namespace std::chrono;
+
+    const long long total_elements = 100'000'000;
+    high_resolution_clock clock {};
+    long long check = 0;
+
+    for (int n = 1; n <= 64; n *= 2) {
+        const long long repetitions = total_elements / n;
+
+        // Create two buffers, add them and look at the result. The allocation is a big part of the cost for vector.
+        auto t1 = clock.now();
+        for (long long r = 0; r < repetitions; ++r) {
+            heap_buffer<int, 64> x(n, static_cast<int>(r));
+            heap_buffer<int, 64> y(n, 1);
+            x += y;
+            check += x[n - 1];
+        }
+        auto t2 = clock.now();
+        for (long long r = 0; r < repetitions; ++r) {
+            std::vector<int> x(n, static_cast<int>(r));
+            std::vector<int> y(n, 1);
+            for (int i = 0; i != n; ++i) {
+                x[i] += y[i];
+            }
+            check -= x[n - 1];
+        }
+        auto t3 = clock.now();
+
+        cout << "n = " << n << ": heap_buffer<int, 64> " << duration_cast<milliseconds>(t2 - t1).count()
+             << " ms, std::vector<int> " << duration_cast<milliseconds>(t3 - t2).count() << " ms\n";
+    }
+    cout << "Results match: " << std::boolalpha << (check == 0) << "\n\n";
+}
+
+// buffer<T, N> is trivially copyable exactly when T is.
+static_assert(std::is_trivially_copyable<buffer<float, 16>>::value, "buffer of float must be trivially copyable");
+static_assert(std::is_trivially_copyable<buffer<color_rgba, 4>>::value, "buffer of colors must be trivially copyable");
+static_assert(!std::is_trivially_copyable<buffer<string, 4>>::value, "buffer of strings cannot be trivially copyable");
+
+bool test_buffer_construction()
+{
+    bool result = true;
+
+    buffer<int, 8> zeros;
+    buffer<int, 8> explicit_zeros(value_init);
+    for (int i = 0; i != 8; ++i) {
+        result = result && zeros[i] == 0 && explicit_zeros[i] == 0;
+    }
+
+    // Default construction works for class types as well now.
+    buffer<string, 3> strings;
+    result = result && strings[0].empty() && strings[2].empty();
+
+    // An uninitialized buffer can be filled in afterwards.
+    buffer<float, 16> b(uninitialized);
+    for (int i = 0; i != 16; ++i) {
+        b[i] = i * 1.5f;
+    }
+    buffer<float, 16> c = b;
+    c += b;
+    for (int i = 0; i != 16; ++i) {
+        result = result && c[i] == i * 3.0f;
+    }
+
+    return result;
+}
+
+namespace {
+
+// buffer as it used to be, with a hand written copy constructor and assignment.
+// The compiler has to assume something special happens in them, so it cannot use memcpy.
+struct hand_copied_buffer {
+    buffer<float, 16> b;
+
+    hand_copied_buffer() = default;
+    hand_copied_buffer(const hand_copied_buffer& other)
+    {
+        for (int i = 0; i != 16; ++i) {
+            b[i] = other.b[i];
+        }
+    }
+    hand_copied_buffer& operator=(const hand_copied_buffer& other)
+    {
+        for (int i = 0; i != 16; ++i) {
+            b[i] = other.b[i];
+        }
+        return *this;
+    }
+};
+
+template<typename B>
+void buffer_copy_performance(const char* name, B value)
+{
+    using namespace std::chrono;
+
+    const int count = 1'000'000;
+    const int repetitions = 20;
+    high_resolution_clock clock {};
+
+    // Growth: every reallocation of the vector moves all of the elements to new memory.
+    auto t1 = clock.now();
+    for (int r = 0; r < repetitions; ++r) {
+        std::vector<B> v;
+        for (int i = 0; i != count; ++i) {
+            v.push_back(value);
+        }
+    }
+    auto t2 = clock.now();
+
+    // Bulk copies of a whole vector.
+    std::vector<B> source(count, value);
+    std::vector<B> destination(count);
+    auto t3 = clock.now();
+    for (int r = 0; r < repetitions; ++r) {
+        destination = source;
+    }
+    auto t4 = clock.now();
+
+    cout << name << ": growth " << duration_cast<milliseconds>(t2 - t1).count() << " ms, bulk copy "
+         << duration_cast<milliseconds>(t4 - t3).count() << " ms\n";
+}
+
+}
+
+void test_buffer_copy_performance()
+{
+    buffer_copy_performance("hand written copy", hand_copied_buffer {});
+    buffer_copy_performance("buffer<float, 16>", buffer<float, 16>(1.0f));
+    cout << '\n';
+}
+
+// singleton<T> is meant to cost nothing over T. The layout checks are in singleton.hpp, the code the compiler
+// generates is checked by the singleton-codegen target (see singleton_codegen.cpp).
+bool test_singleton_operators()
+{
+    bool result = true;
+
+    // Everything works when compiling.
+    constexpr singleton<int> a(6);
+    constexpr singleton<int> b(4);
+    static_assert((a + b).value == 10 && (a - b).value == 2 && (a * b).value == 24 && (a / b).value == 1,
+                  "singleton arithmetic is constexpr");
+    static_assert((a + 1).value == 7 && (1 - a).value == -5 && (-a).value == -6, "mixing singletons and values");
+    static_assert(b < a && a >= b && a != b, "singleton comparisons are constexpr");
+    static_assert(noexcept(a + b) && noexcept(a < b), "singleton<int> operations cannot throw");
+    static_assert(!noexcept(singleton<string>("x") + singleton<string>("y")), "but string concatenation can");
+
+    // The result of an operation is a singleton again, not a T.
+    static_assert(std::is_same<decltype(a + b), singleton<int>>::value, "a + b must not round trip through T");
+    static_assert(std::is_same<decltype(a * 2), singleton<int>>::value, "neither must a * 2");
+
+    // Any other type than T goes through the conversion to T, as if there were no operators: the .5 is kept.
+    static_assert(singleton<int>(3) + 1.5 == 4.5 && std::is_same<decltype(singleton<int>(3) + 1.5), double>::value,
+                  "singleton<int> + double is a double");
+    static_assert(std::is_same<decltype(singleton<int>(3) + 2L), long>::value, "singleton<int> + long is a long");
+    static_assert(singleton<double>(1.25) * 2 == 2.5 && std::is_same<decltype(singleton<double>(1.25) * 2), double>::value,
+                  "singleton<double> * int is a double");
+    const double half = 0.5;
+    result = result && singleton<int>(3) + half == 3.5 && 2 * singleton<double>(0.75) == 1.5;
+
+    singleton<double> x(1.5);
+    x += singleton<double>(2.5);
+    x *= 2.0;
+    x = x / 4.0;
+    result = result && x == singleton<double>(2.0);
+
+    singleton<string> s("generic");
+    s += singleton<string>(" programming");
+    result = result && s.value == "generic programming";
+    return result;
+}
+
+namespace {
+
+// The same algorithms over a vector of T and a vector of singleton<T> holding the same values.
+template<typename T>
+void singleton_performance(const char* name)
+{
+    using namespace std::chrono;
+
+    const int count = 1 << 22;
+    high_resolution_clock clock {};
+    std::vector<T> raw(count);
+    for (int i = 0; i != count; ++i) {
+        raw[i] = static_cast<T>((i * 7919LL) % 100003);
+    }
+    std::vector<singleton<T>> wrapped(raw.begin(), raw.end());
+
+    auto time = [&](auto f) {
+        auto t1 = clock.now();
+        f();
+        return duration_cast<microseconds>(clock.now() - t1).count();
+    };
+    auto report = [&](const char* algorithm, long long raw_time, long long wrapped_time) {
+        cout << name << " " << algorithm << ": " << raw_time << " us, singleton " << wrapped_time << " us\n";
+    };
+
+    T raw_sum {};
+    singleton<T> wrapped_sum {};
+    report("accumulate", time([&]() { raw_sum = std::accumulate(raw.begin(), raw.end(), T {}); }),
+           time([&]() { wrapped_sum = std::accumulate(wrapped.begin(), wrapped.end(), singleton<T>(T {})); }));
+
+    std::vector<T> raw_copy(count);
+    std::vector<singleton<T>> wrapped_copy(count);
+    report("copy", time([&]() { std::copy(raw.begin(), raw.end(), raw_copy.begin()); }),
+           time([&]() { std::copy(wrapped.begin(), wrapped.end(), wrapped_copy.begin()); }));
+
+    // std::equal compares arrays of built in types with memcmp. It cannot know that singleton<T> could be
+    // compared the same way, so it loops.
+    bool raw_equal = false;
+    bool wrapped_equal = false;
+    report("equal", time([&]() { raw_equal = std::equal(raw.begin(), raw.end(), raw_copy.begin()); }),
+           time([&]() { wrapped_equal = std::equal(wrapped.begin(), wrapped.end(), wrapped_copy.begin()); }));
+
+    report("sort", time([&]() { std::sort(raw_copy.begin(), raw_copy.end()); }),
+           time([&]() { std::sort(wrapped_copy.begin(), wrapped_copy.end()); }));
+
+    cout << name << " results match: " << std::boolalpha
+         << (raw_sum == wrapped_sum.value && raw_equal && wrapped_equal
+             && std::equal(raw_copy.begin(), raw_copy.end(), wrapped_copy.begin(),
+                           [](const T& x, const singleton<T>& y) { return x == y.value; }))
+         << "\n";
+}
+
+}
+
+void test_singleton_performance()
+{
+    singleton_performance<int>("int");
+    singleton_performance<double>("double");
+    cout << '\n';
+}
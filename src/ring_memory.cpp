@@ -0,0 +1,203 @@
+#include "ring_memory.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define RING_MEMORY_HAS_MMAP
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#define RING_MEMORY_HAS_MBIND
+#include <linux/mempolicy.h>
+#include <sys/syscall.h>
+#endif
+
+const char* to_string(page_kind k)
+{
+    switch (k) {
+    case page_kind::normal:
+        return "normal pages";
+    case page_kind::transparent_huge:
+        return "transparent huge pages";
+    case page_kind::explicit_huge:
+        return "explicit huge pages";
+    }
+    return "unknown pages";
+}
+
+#ifdef RING_MEMORY_HAS_MMAP
+
+namespace {
+
+constexpr std::size_t huge_page_size = std::size_t(2) << 20;
+
+std::size_t round_up(std::size_t n, std::size_t multiple)
+{
+    return (n + multiple - 1) / multiple * multiple;
+}
+
+std::size_t normal_page_size()
+{
+    long size = sysconf(_SC_PAGESIZE);
+    return size > 0 ? static_cast<std::size_t>(size) : 4096;
+}
+
+void* map_anonymous(std::size_t length, int extra_flags)
+{
+    void* p = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | extra_flags, -1, 0);
+    return p == MAP_FAILED ? nullptr : p;
+}
+
+bool map_explicit_huge(std::size_t bytes, ring_memory_block& block)
+{
+#ifdef MAP_HUGETLB
+    int flags = MAP_HUGETLB;
+#ifdef MAP_HUGE_2MB
+    flags |= MAP_HUGE_2MB;
+#endif
+    std::size_t length = round_up(bytes, huge_page_size);
+    if (void* p = map_anonymous(length, flags)) {
+        block = { p, length, page_kind::explicit_huge, false };
+        return true;
+    }
+#else
+    (void)bytes;
+    (void)block;
+#endif
+    return false;
+}
+
+// The kernel only uses a huge page for a 2 MB aligned stretch of the mapping, so we map 2 MB more than needed
+// and cut off the ends around the aligned part.
+bool map_transparent_huge(std::size_t bytes, ring_memory_block& block)
+{
+#ifdef MADV_HUGEPAGE
+    std::size_t length = round_up(bytes, huge_page_size);
+    char* p = static_cast<char*>(map_anonymous(length + huge_page_size, 0));
+    if (p == nullptr) {
+        return false;
+    }
+    std::uintptr_t address = reinterpret_cast<std::uintptr_t>(p);
+    char* aligned = p + (round_up(address, huge_page_size) - address);
+    if (aligned != p) {
+        munmap(p, static_cast<std::size_t>(aligned - p));
+    }
+    std::size_t tail = static_cast<std::size_t>(p + length + huge_page_size - (aligned + length));
+    if (tail != 0) {
+        munmap(aligned + length, tail);
+    }
+    // Without the advice (transparent huge pages switched off) it is just normal memory.
+    bool advised = madvise(aligned, length, MADV_HUGEPAGE) == 0;
+    block = { aligned, length, advised ? page_kind::transparent_huge : page_kind::normal, false };
+    return true;
+#else
+    (void)bytes;
+    (void)block;
+    return false;
+#endif
+}
+
+bool place(const ring_memory_block& block, const ring_memory_options& options)
+{
+#ifdef RING_MEMORY_HAS_MBIND
+    // Room for 1024 nodes.
+    constexpr unsigned long mask_bits = 1024;
+    constexpr unsigned long bits_per_word = 8 * sizeof(unsigned long);
+    unsigned long mask[mask_bits / bits_per_word] = {};
+    int mode = MPOL_DEFAULT;
+    switch (options.placement) {
+    case numa_placement::any:
+        return false;
+    case numa_placement::local:
+        mode = MPOL_LOCAL;
+        break;
+    case numa_placement::interleave:
+        // Over all of the nodes we may use.
+        if (syscall(SYS_get_mempolicy, nullptr, mask, mask_bits, nullptr, MPOL_F_MEMS_ALLOWED) != 0) {
+            return false;
+        }
+        mode = MPOL_INTERLEAVE;
+        break;
+    case numa_placement::bind:
+        if (options.node < 0 || static_cast<unsigned long>(options.node) >= mask_bits) {
+            return false;
+        }
+        mask[options.node / bits_per_word] = 1ul << (options.node % bits_per_word);
+        mode = MPOL_BIND;
+        break;
+    }
+    // The kernel reads one bit less than maxnode says (libnuma passes one more, and so do we).
+    const unsigned long* nodes = mode == MPOL_LOCAL ? nullptr : mask;
+    unsigned long max_node = mode == MPOL_LOCAL ? 0 : mask_bits + 1;
+    return syscall(SYS_mbind, block.data, block.length, mode, nodes, max_node, 0) == 0;
+#else
+    (void)block;
+    (void)options;
+    return false;
+#endif
+}
+
+}
+
+ring_memory_block allocate_ring_memory(std::size_t bytes, const ring_memory_options& options)
+{
+    ring_memory_block block;
+    if (bytes == 0) {
+        return block;
+    }
+    bool mapped = (options.pages == page_kind::explicit_huge && map_explicit_huge(bytes, block))
+        || (options.pages != page_kind::normal && map_transparent_huge(bytes, block));
+    if (!mapped) {
+        std::size_t length = round_up(bytes, normal_page_size());
+        void* p = map_anonymous(length, 0);
+        if (p == nullptr) {
+            throw std::bad_alloc();
+        }
+        block = { p, length, page_kind::normal, false };
+    }
+    block.placed = place(block, options);
+    if (options.prefault) {
+        // One write per page faults it in, on the node the policy says.
+        std::size_t stride = block.pages == page_kind::explicit_huge ? huge_page_size : normal_page_size();
+        char* p = static_cast<char*>(block.data);
+        for (std::size_t offset = 0; offset < block.length; offset += stride) {
+            p[offset] = 0;
+        }
+    }
+    return block;
+}
+
+void free_ring_memory(const ring_memory_block& block)
+{
+    if (block.data != nullptr) {
+        munmap(block.data, block.length);
+    }
+}
+
+#else
+
+// No pages to choose from: aligned memory from operator new, zeroed as mmap would give it.
+ring_memory_block allocate_ring_memory(std::size_t bytes, const ring_memory_options&)
+{
+    ring_memory_block block;
+    if (bytes == 0) {
+        return block;
+    }
+    block.data = ::operator new(bytes, std::align_val_t(4096));
+    block.length = bytes;
+    std::memset(block.data, 0, bytes);
+    return block;
+}
+
+void free_ring_memory(const ring_memory_block& block)
+{
+    if (block.data != nullptr) {
+        ::operator delete(block.data, std::align_val_t(4096));
+    }
+}
+
+#endif
@@ -0,0 +1,167 @@
+#include "ring_memory_tests.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "circular_buffer.hpp"
+#include "ring_memory.hpp"
+
+using std::cout;
+
+namespace {
+
+template<typename T>
+bool same_elements(const circular_buffer<T>& a, const circular_buffer<T>& b)
+{
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i != a.size(); ++i) {
+        if (!(a[i] == b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The same pushes, reserve, copy and swap on a buffer with the options and on a plain one.
+bool check_options(const ring_memory_options& options)
+{
+    bool result = true;
+    circular_buffer<int> mapped(1000, options);
+    circular_buffer<int> plain(1000);
+    result = result && mapped.memory().data == mapped.data() && mapped.memory().length >= 1000 * sizeof(int);
+    // A page_kind other than normal is 2 MB aligned, so that the kernel can actually use huge pages.
+    result = result && (mapped.memory().pages == page_kind::normal
+                        || reinterpret_cast<std::uintptr_t>(mapped.data()) % (std::size_t(2) << 20) == 0);
+
+    for (int i = 0; i != 2500; ++i) {
+        mapped.push_back(i);
+        plain.push_back(i);
+    }
+    result = result && same_elements(mapped, plain);
+
+    // reserve maps a new array with the same options.
+    mapped.reserve(5000);
+    plain.reserve(5000);
+    result = result && same_elements(mapped, plain) && mapped.memory().data == mapped.data();
+    for (int i = 0; i != 3000; ++i) {
+        mapped.push_back(-i);
+        plain.push_back(-i);
+    }
+    result = result && same_elements(mapped, plain);
+
+    circular_buffer<int> copy(mapped);
+    result = result && same_elements(copy, mapped) && copy.memory().data == copy.data()
+        && copy.memory().data != mapped.memory().data && copy.memory_options().pages == options.pages;
+
+    // The mapping goes along with the array.
+    copy.swap(plain);
+    result = result && plain.memory().data == plain.data() && copy.memory().data == nullptr
+        && same_elements(copy, plain);
+
+    // Elements which are not trivial are constructed and destroyed in the mapped memory.
+    circular_buffer<std::string> strings(3, options);
+    for (int i = 0; i != 10; ++i) {
+        strings.push_back(std::string(40, static_cast<char>('a' + i)));
+    }
+    strings.reserve(8);
+    result = result && strings.size() == 3 && strings[0] == std::string(40, 'h') && strings[2] == std::string(40, 'j');
+    return result;
+}
+
+}
+
+bool test_ring_memory()
+{
+    bool result = true;
+
+    ring_memory_options defaults;
+    result = result && defaults.is_default();
+    circular_buffer<int> plain(16);
+    result = result && plain.memory().data == nullptr && plain.memory_options().is_default();
+
+    ring_memory_block empty = allocate_ring_memory(0, ring_memory_options {});
+    result = result && empty.data == nullptr && empty.length == 0;
+    free_ring_memory(empty);
+
+    // Explicit huge pages fall back to transparent ones, or normal pages, when none are reserved; a node that does
+    // not exist leaves the memory where it is. Either way the buffer works the same.
+    const ring_memory_options all_options[] = {
+        { page_kind::normal, numa_placement::any, 0, true },
+        { page_kind::transparent_huge, numa_placement::any, 0, false },
+        { page_kind::transparent_huge, numa_placement::local, 0, true },
+        { page_kind::explicit_huge, numa_placement::interleave, 0, true },
+        { page_kind::normal, numa_placement::bind, 0, false },
+        { page_kind::transparent_huge, numa_placement::bind, 100000, true },
+    };
+    for (const ring_memory_options& options : all_options) {
+        result = result && !options.is_default() && check_options(options);
+    }
+
+    ring_memory_block nowhere = allocate_ring_memory(100, { page_kind::normal, numa_placement::bind, -1, false });
+    result = result && nowhere.data != nullptr && !nowhere.placed && nowhere.length >= 100;
+    free_ring_memory(nowhere);
+    return result;
+}
+
+void test_ring_memory_performance()
+{
+    using namespace std::chrono;
+    high_resolution_clock clock {};
+    // A 1 GB ring of 64 bit values: far more than the TLB covers with 4 KB pages (a few MB), a few hundred
+    // entries with 2 MB pages.
+    const std::size_t n = std::size_t(1) << 27;
+    const std::size_t reads = 20'000'000;
+
+    struct setup {
+        const char* name;
+        bool plain;
+        ring_memory_options options;
+    };
+    const setup setups[] = {
+        { "new[]", true, {} },
+        { "normal, prefault", false, { page_kind::normal, numa_placement::any, 0, true } },
+        { "transparent huge", false, { page_kind::transparent_huge, numa_placement::any, 0, false } },
+        { "transparent huge, prefault", false, { page_kind::transparent_huge, numa_placement::local, 0, true } },
+        { "explicit huge, prefault", false, { page_kind::explicit_huge, numa_placement::local, 0, true } },
+        { "interleave, prefault", false, { page_kind::normal, numa_placement::interleave, 0, true } },
+    };
+    for (const setup& s : setups) {
+        auto start = clock.now();
+        circular_buffer<std::uint64_t> ring = s.plain ? circular_buffer<std::uint64_t>(n)
+                                                      : circular_buffer<std::uint64_t>(n, s.options);
+        auto constructed = clock.now();
+
+        // Sequential push: fill it once and go round again.
+        for (std::uint64_t i = 0; i != 2 * n; ++i) {
+            ring.push_back(i);
+        }
+        auto pushed = clock.now();
+
+        // Random reads, from a generator cheap enough not to hide the misses.
+        std::uint64_t x = 88172645463325252ull;
+        std::uint64_t sum = 0;
+        for (std::size_t i = 0; i != reads; ++i) {
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+            sum += ring[x & (n - 1)];
+        }
+        auto read = clock.now();
+
+        auto ms = [](high_resolution_clock::duration d) {
+            return duration_cast<duration<double, std::milli>>(d).count();
+        };
+        auto ns_per = [](high_resolution_clock::duration d, std::size_t count) {
+            return duration_cast<duration<double, std::nano>>(d).count() / count;
+        };
+        cout << s.name << " (" << to_string(ring.memory().pages) << (ring.memory().placed ? ", placed" : "")
+             << "): construction " << ms(constructed - start) << " ms, push_back "
+             << ns_per(pushed - constructed, 2 * n) << " ns, random operator[] " << ns_per(read - pushed, reads)
+             << " ns (" << sum % 10 << ")\n";
+    }
+}
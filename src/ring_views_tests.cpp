@@ -0,0 +1,196 @@
+#include "ring_views_tests.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <vector>
+#include "circular_buffer.hpp"
+#include "reductions.hpp"
+#include "revision_2.hpp"
+#include "ring_views.hpp"
+
+namespace {
+
+// A ring whose elements wrap around the end of its array: values first, ..., first + n - 1.
+circular_buffer<int> wrapped_ring(std::size_t capacity, std::size_t n, int first)
+{
+    circular_buffer<int> cb(capacity);
+    for (std::size_t i = 0; i != capacity / 2; ++i) {
+        cb.push_back(0);
+    }
+    for (std::size_t i = 0; i != n; ++i) {
+        cb.push_back(first + static_cast<int>(i));
+    }
+    while (cb.size() > n) {
+        cb.pop_front();
+    }
+    return cb;
+}
+
+template<typename T>
+std::vector<T> to_vector(const circular_buffer<T>& cb)
+{
+    std::vector<T> v;
+    for (std::size_t i = 0; i != cb.size(); ++i) {
+        v.push_back(cb[i]);
+    }
+    return v;
+}
+
+struct square {
+    long long operator()(int x) const
+    {
+        return static_cast<long long>(x) * x;
+    }
+};
+
+/// The materializing way: every step builds a ring of its own.
+
+circular_buffer<int> materialized_take_last(const circular_buffer<int>& cb, std::size_t n)
+{
+    circular_buffer<int> out(n);
+    for (std::size_t i = cb.size() - n; i != cb.size(); ++i) {
+        out.push_back(cb[i]);
+    }
+    return out;
+}
+
+template<typename P>
+circular_buffer<int> materialized_filter(const circular_buffer<int>& cb, P p)
+{
+    circular_buffer<int> out(cb.size());
+    for (std::size_t i = 0; i != cb.size(); ++i) {
+        if (p(cb[i])) {
+            out.push_back(cb[i]);
+        }
+    }
+    return out;
+}
+
+template<typename F>
+circular_buffer<int> materialized_transform(const circular_buffer<int>& cb, F f)
+{
+    circular_buffer<int> out(cb.size());
+    for (std::size_t i = 0; i != cb.size(); ++i) {
+        out.push_back(f(cb[i]));
+    }
+    return out;
+}
+
+}
+
+bool test_ring_views()
+{
+    bool result = true;
+    circular_buffer<int> cb = wrapped_ring(16, 12, -6);  // -6 ... 5, split over the end of the array
+    result = result && cb.array_two().size() != 0;
+
+    auto negatives = cb | filter(less_than_n { 0 });
+    result = result && count(negatives) == 6;
+
+    // filter, then transform, then filter again: one pass.
+    auto v = cb | filter(less_than_n { 0 }) | transform(abs_int {}) | filter(less_than_n { 4 });
+    result = result && to_vector(collect(v)) == std::vector<int> { 3, 2, 1 };
+
+    // The element type follows the transforms.
+    auto squares = cb | transform(square {});
+    static_assert(std::is_same<decltype(squares)::value_type, long long>::value, "transform changes the type");
+    result = result && reduce(squares, 0LL, [](long long s, long long x) { return s + x; }) == 146;
+
+    // collect into an existing ring keeps its semantics: the oldest elements make room.
+    circular_buffer<int> last_three(3);
+    collect(cb | transform(abs_int {}), last_three);
+    result = result && to_vector(last_three) == std::vector<int> { 3, 4, 5 };
+
+    int total = 0;
+    for_each(cb | filter([](int x) { return x % 2 == 0; }), [&](int x) { total += x; });
+    result = result && total == -6 - 4 - 2 + 0 + 2 + 4;
+
+    circular_buffer<int> empty(4);
+    result = result && count(empty | transform(abs_int {})) == 0 && collect(empty | filter(less_than_n { 0 })).empty();
+    return result;
+}
+
+bool test_ring_views_take_last_and_window()
+{
+    bool result = true;
+    circular_buffer<int> cb = wrapped_ring(10, 10, 1);  // 1 ... 10
+
+    result = result && to_vector(collect(cb | take_last(4))) == std::vector<int> { 7, 8, 9, 10 };
+    result = result && count(cb | take_last(100)) == 10 && count(cb | take_last(0)) == 0;
+    result = result && to_vector(collect(cb | take_last(5) | filter(less_than_n { 8 }))) == std::vector<int> { 6, 7 };
+
+    // Moving sums, with the windows straddling the end of the array handled by reductions.hpp.
+    auto sums = cb | window(3) | transform([](const storage_segments<const int>& w) { return sum(w); });
+    std::vector<sum_type<int>> expected;
+    for (int i = 1; i + 2 <= 10; ++i) {
+        expected.push_back(3 * i + 3);
+    }
+    result = result && to_vector(collect(sums)) == expected;
+
+    result = result && count(cb | window(10)) == 1 && count(cb | window(11)) == 0;
+    result = result && count(cb | take_last(4) | window(2)) == 3;
+
+    // Each window of a wrapped ring is split where the ring is.
+    bool windows_ok = true;
+    int first = 1;
+    for_each(cb | window(4), [&](const storage_segments<const int>& w) {
+        windows_ok = windows_ok && w.size() == 4 && (w.one.size() != 0 || w.two.size() == 0);
+        int expected_value = first++;
+        for (int x : w.one) {
+            windows_ok = windows_ok && x == expected_value++;
+        }
+        for (int x : w.two) {
+            windows_ok = windows_ok && x == expected_value++;
+        }
+    });
+    result = result && windows_ok && first == 8;
+    return result;
+}
+
+void test_ring_views_performance()
+{
+    using namespace std::chrono;
+
+    const std::size_t n = 10'000'000;
+    const int repetitions = 10;
+    circular_buffer<int> cb = wrapped_ring(n, n, -static_cast<int>(n / 2));
+    high_resolution_clock clock {};
+
+    // The newest three quarters, the negative ones, their absolute values.
+    long long check_materialized = 0;
+    auto t1 = clock.now();
+    for (int r = 0; r < repetitions; ++r) {
+        circular_buffer<int> recent = materialized_take_last(cb, 3 * n / 4);
+        circular_buffer<int> negative = materialized_filter(recent, less_than_n { 0 });
+        circular_buffer<int> result = materialized_transform(negative, abs_int {});
+        check_materialized += result.size() + result[0];
+    }
+    auto t2 = clock.now();
+
+    long long check_collected = 0;
+    auto t3 = clock.now();
+    for (int r = 0; r < repetitions; ++r) {
+        circular_buffer<int> result = collect(cb | take_last(3 * n / 4) | filter(less_than_n { 0 }) | transform(abs_int {}));
+        check_collected += result.size() + result[0];
+    }
+    auto t4 = clock.now();
+
+    // Often we do not need the elements themselves, only something computed from them.
+    long long check_reduced = 0;
+    auto t5 = clock.now();
+    for (int r = 0; r < repetitions; ++r) {
+        auto v = cb | take_last(3 * n / 4) | filter(less_than_n { 0 }) | transform(abs_int {});
+        check_reduced += reduce(v, 0LL, [](long long s, int x) { return s + x; });
+    }
+    auto t6 = clock.now();
+
+    std::cout << "take_last | filter | transform, materializing every step: "
+              << duration_cast<milliseconds>(t2 - t1).count() << " ms\n";
+    std::cout << "take_last | filter | transform, lazy view then collect: "
+              << duration_cast<milliseconds>(t4 - t3).count() << " ms\n";
+    std::cout << "take_last | filter | transform, lazy view then reduce: "
+              << duration_cast<milliseconds>(t6 - t5).count() << " ms\n";
+    std::cout << "Results match: " << std::boolalpha << (check_materialized == check_collected)
+              << " (sum " << check_reduced << ")\n\n";
+}
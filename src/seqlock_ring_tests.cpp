@@ -0,0 +1,197 @@
+#include "seqlock_ring_tests.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "circular_buffer.hpp"
+#include "revision.hpp"
+#include "seqlock_ring.hpp"
+
+using std::cout;
+
+namespace {
+
+// An element bigger than a word, so that a torn copy (half old, half new) would show.
+struct sample {
+    std::uint64_t index;
+    std::uint64_t check;
+    double value;
+};
+
+sample make_sample(std::uint64_t i)
+{
+    return { i, ~i, static_cast<double>(i) * 0.5 };
+}
+
+// The elements of a snapshot must be whole, consecutive pushes.
+bool consecutive_samples(const sample* s, std::size_t n)
+{
+    for (std::size_t i = 0; i != n; ++i) {
+        if (s[i].check != ~s[i].index || s[i].value != static_cast<double>(s[i].index) * 0.5
+            || (i != 0 && s[i].index != s[i - 1].index + 1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// What we compare against: a circular_buffer behind a mutex.
+struct locked_ring {
+    std::mutex m;
+    circular_buffer<sample> cb;
+
+    explicit locked_ring(std::size_t capacity)
+        : cb(capacity)
+    {}
+
+    void push_back(const sample& s)
+    {
+        std::lock_guard<std::mutex> lock(m);
+        cb.push_back(s);
+    }
+    std::size_t snapshot(sample* out, std::size_t n)
+    {
+        std::lock_guard<std::mutex> lock(m);
+        std::size_t count = n < cb.size() ? n : cb.size();
+        for (std::size_t i = cb.size() - count; i != cb.size(); ++i) {
+            *out++ = cb[i];
+        }
+        return count;
+    }
+};
+
+// Pushes for a while with the given number of readers taking snapshots in a loop.
+// Returns the pushes per second and sets the number of snapshots the readers took.
+template<typename Ring>
+double writer_throughput(Ring& ring, int readers, std::size_t snapshot_size, long long& snapshots)
+{
+    using namespace std::chrono;
+    std::atomic<bool> done { false };
+    std::atomic<long long> taken { 0 };
+    std::vector<std::thread> threads;
+    for (int r = 0; r != readers; ++r) {
+        threads.emplace_back([&]() {
+            std::vector<sample> out(snapshot_size);
+            long long mine = 0;
+            while (!done.load(std::memory_order_relaxed)) {
+                ring.snapshot(out.data(), snapshot_size);
+                ++mine;
+            }
+            taken += mine;
+        });
+    }
+
+    const auto duration = milliseconds(300);
+    high_resolution_clock clock {};
+    auto start = clock.now();
+    std::uint64_t pushes = 0;
+    while (clock.now() - start < duration) {
+        for (int i = 0; i != 1024; ++i) {
+            ring.push_back(make_sample(pushes++));
+        }
+    }
+    double seconds = duration_cast<microseconds>(clock.now() - start).count() / 1e6;
+    done = true;
+    for (std::thread& t : threads) {
+        t.join();
+    }
+    snapshots = taken;
+    return pushes / seconds;
+}
+
+}
+
+bool test_seqlock_ring()
+{
+    bool result = true;
+    seqlock_ring<sample> ring(100);
+    result = result && ring.capacity() == 128;
+
+    sample out[200];
+    std::size_t count = 0;
+    result = result && ring.try_snapshot(out, 10, count) && count == 0;
+
+    for (std::uint64_t i = 0; i != 5; ++i) {
+        ring.push_back(make_sample(i));
+    }
+    result = result && ring.snapshot(out, 10) == 5 && out[0].index == 0 && consecutive_samples(out, 5);
+
+    // Past the capacity the oldest elements are gone.
+    for (std::uint64_t i = 5; i != 300; ++i) {
+        ring.push_back(make_sample(i));
+    }
+    result = result && ring.snapshot(out, 200) == 128 && out[0].index == 300 - 128 && consecutive_samples(out, 128);
+    result = result && ring.snapshot(out, 3) == 3 && out[2].index == 299;
+
+    circular_buffer<sample> last = ring.snapshot(16);
+    result = result && last.size() == 16 && last[0].index == 284 && last[15].index == 299;
+
+    // Colors are copied as single 32 bit words, although they are only aligned as bytes.
+    static_assert(sizeof(seqlock_word<color_rgba>) == 4 && alignof(color_rgba) == 1, "one word per color");
+    seqlock_ring<color_rgba> colors(4);
+    colors.push_back(make_color_rgba(1, 2, 3, 4));
+    color_rgba c;
+    result = result && colors.snapshot(&c, 1) == 1 && c.r == 1 && c.a == 4;
+    return result;
+}
+
+bool test_seqlock_ring_concurrent_snapshots()
+{
+    const std::uint64_t total = 2'000'000;
+    const std::size_t snapshot_size = 64;
+    seqlock_ring<sample> ring(1024);
+    std::atomic<bool> done { false };
+    std::atomic<bool> ok { true };
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r != 3; ++r) {
+        readers.emplace_back([&]() {
+            std::vector<sample> out(snapshot_size);
+            std::uint64_t last_seen = 0;
+            while (!done.load(std::memory_order_relaxed)) {
+                std::size_t count = 0;
+                if (!ring.try_snapshot(out.data(), snapshot_size, count)) {
+                    continue;
+                }
+                // Whole elements, consecutive, and never older than what we saw before.
+                if (!consecutive_samples(out.data(), count) || (count != 0 && out[count - 1].index < last_seen)) {
+                    ok = false;
+                }
+                if (count != 0) {
+                    last_seen = out[count - 1].index;
+                }
+            }
+        });
+    }
+    for (std::uint64_t i = 0; i != total; ++i) {
+        ring.push_back(make_sample(i));
+    }
+    done = true;
+    for (std::thread& t : readers) {
+        t.join();
+    }
+
+    sample out[snapshot_size];
+    return ok && ring.snapshot(out, snapshot_size) == snapshot_size && out[snapshot_size - 1].index == total - 1;
+}
+
+void test_seqlock_ring_performance()
+{
+    const std::size_t capacity = 1 << 16;
+    const std::size_t snapshot_size = 1024;
+    for (int readers = 0; readers <= 8; readers += (readers < 2 ? 1 : 2)) {
+        long long seqlock_snapshots = 0;
+        long long mutex_snapshots = 0;
+        seqlock_ring<sample> ring(capacity);
+        double seqlock_rate = writer_throughput(ring, readers, snapshot_size, seqlock_snapshots);
+        locked_ring locked(capacity);
+        double mutex_rate = writer_throughput(locked, readers, snapshot_size, mutex_snapshots);
+        cout << readers << " readers: seqlock_ring " << seqlock_rate / 1e6 << " M pushes/s (" << seqlock_snapshots
+             << " snapshots), mutex " << mutex_rate / 1e6 << " M pushes/s (" << mutex_snapshots << " snapshots)\n";
+    }
+    cout << '\n';
+}
@@ -0,0 +1,182 @@
+#include "sequence_cursor_tests.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "circular_buffer.hpp"
+#include "sequence_cursor.hpp"
+
+using std::cout;
+
+namespace {
+
+// What we compare against: every element carries its own sequence number.
+struct stamped_int {
+    std::uint64_t seq;
+    int value;
+};
+
+// A consumer of a ring of stamped elements, which finds where to start from the stamp of the oldest one.
+struct stamped_consumer {
+    std::uint64_t next;
+    std::uint64_t lost;
+    long long sum;
+
+    void read(const circular_buffer<stamped_int>& cb)
+    {
+        if (cb.empty()) {
+            return;
+        }
+        std::uint64_t first = cb.front().seq;
+        if (next < first) {
+            lost += first - next;
+            next = first;
+        }
+        for (const array_segment<const stamped_int>& segment : { cb.array_one(), cb.array_two() }) {
+            for (const stamped_int& x : segment) {
+                if (x.seq >= next) {
+                    sum += x.value;
+                }
+            }
+        }
+        next = cb.back().seq + 1;
+    }
+};
+
+}
+
+bool test_sequence_numbers()
+{
+    bool result = true;
+    circular_buffer<int> cb(4);
+    result = result && cb.first_seq() == 0 && cb.end_seq() == 0 && !cb.contains_seq(0);
+
+    for (int i = 0; i != 3; ++i) {
+        cb.push_back(i * 10);
+    }
+    result = result && cb.first_seq() == 0 && cb.end_seq() == 3 && cb.at_seq(2) == 20 && !cb.contains_seq(3);
+
+    // Overwriting the oldest elements moves the first sequence number but not the numbers of the others.
+    for (int i = 3; i != 7; ++i) {
+        cb.push_back(i * 10);
+    }
+    result = result && cb.first_seq() == 3 && cb.end_seq() == 7 && !cb.contains_seq(2);
+    result = result && cb.at_seq(3) == 30 && cb.at_seq(6) == 60 && cb.front() == 30;
+
+    cb.pop_front();
+    result = result && cb.first_seq() == 4 && cb.at_seq(4) == 40;
+    cb.push_back_n(2, 99);
+    result = result && cb.end_seq() == 9 && cb.first_seq() == 5 && cb.at_seq(8) == 99 && cb.at_seq(5) == 50;
+
+    // Growing, copying and swapping keep the numbers; clearing does not restart them.
+    cb.reserve(10);
+    result = result && cb.first_seq() == 5 && cb.at_seq(6) == 60;
+    circular_buffer<int> copy(cb);
+    result = result && copy.first_seq() == 5 && copy.end_seq() == 9 && copy.at_seq(7) == 99;
+    circular_buffer<int> other(2);
+    other.swap(copy);
+    result = result && other.first_seq() == 5 && copy.end_seq() == 0;
+    cb.clear();
+    result = result && cb.empty() && cb.first_seq() == 9 && cb.end_seq() == 9;
+    cb.push_back(1);
+    result = result && cb.at_seq(9) == 1;
+
+    // The numbers cost one counter per buffer, not a word per element (and ring_memory_options one pointer).
+    result = result
+        && sizeof(circular_buffer<int>) == 2 * sizeof(void*) + 4 * sizeof(std::size_t) + sizeof(std::uint64_t);
+    return result;
+}
+
+bool test_sequence_cursor()
+{
+    bool result = true;
+    circular_buffer<int> cb(8);
+    for (int i = 0; i != 5; ++i) {
+        cb.push_back(i);
+    }
+    sequence_cursor fast { 0 };
+    sequence_cursor slow { 0 };
+    sequence_cursor late { cb.end_seq() };
+
+    std::vector<int> seen;
+    read_result r = read(fast, cb, [&](int x) { seen.push_back(x); });
+    result = result && r.lost == 0 && r.read == 5 && fast.next == 5 && seen == std::vector<int> { 0, 1, 2, 3, 4 };
+    result = result && lag(fast, cb) == 0 && lag(slow, cb) == 5 && lag(late, cb) == 0;
+
+    // 10 more pushes overwrite 7 elements the slow cursor never saw.
+    for (int i = 5; i != 15; ++i) {
+        cb.push_back(i);
+    }
+    result = result && lost(slow, cb) == 7 && lost(fast, cb) == 2 && lost(late, cb) == 2 && lag(slow, cb) == 15;
+    result = result && unread(slow, cb).size() == 8 && unread(late, cb).size() == 8;
+
+    // Replay with at_seq after catching up.
+    result = result && catch_up(slow, cb) == 7 && slow.next == 7 && lost(slow, cb) == 0;
+    long long sum = 0;
+    for (; slow.next != cb.end_seq(); ++slow.next) {
+        sum += cb.at_seq(slow.next);
+    }
+    result = result && sum == 7 + 8 + 9 + 10 + 11 + 12 + 13 + 14;
+
+    seen.clear();
+    r = read(fast, cb, [&](int x) { seen.push_back(x); });
+    result = result && r.lost == 2 && r.read == 8 && seen.front() == 7 && seen.back() == 14 && fast.next == 15;
+
+    // Nothing new: nothing read and nothing lost.
+    r = read(fast, cb, [&](int) { ++sum; });
+    result = result && r.lost == 0 && r.read == 0 && unread(fast, cb).size() == 0;
+    return result;
+}
+
+void test_sequence_cursor_performance()
+{
+    using namespace std::chrono;
+    const std::size_t capacity = 1 << 12;
+    const int pushes = 100'000'000;
+    // Consumers reading at different rates: the slower ones fall behind and lose elements.
+    const int read_every[] = { 1000, 3000, 5000, 9000 };
+    const int consumers = sizeof read_every / sizeof read_every[0];
+    high_resolution_clock clock {};
+
+    circular_buffer<int> plain(capacity);
+    sequence_cursor cursors[consumers] = {};
+    std::uint64_t lost_plain[consumers] = {};
+    long long sum_plain = 0;
+    auto start = clock.now();
+    for (int i = 0; i != pushes; ++i) {
+        plain.push_back(i & 0xffff);
+        for (int c = 0; c != consumers; ++c) {
+            if (i % read_every[c] == 0) {
+                lost_plain[c] += read(cursors[c], plain, [&](int x) { sum_plain += x; }).lost;
+            }
+        }
+    }
+    auto plain_time = duration_cast<milliseconds>(clock.now() - start).count();
+
+    circular_buffer<stamped_int> stamped(capacity);
+    stamped_consumer stamped_consumers[consumers] = {};
+    long long sum_stamped = 0;
+    start = clock.now();
+    for (int i = 0; i != pushes; ++i) {
+        stamped.push_back({ static_cast<std::uint64_t>(i), i & 0xffff });
+        for (int c = 0; c != consumers; ++c) {
+            if (i % read_every[c] == 0) {
+                stamped_consumers[c].read(stamped);
+            }
+        }
+    }
+    auto stamped_time = duration_cast<milliseconds>(clock.now() - start).count();
+    for (const stamped_consumer& c : stamped_consumers) {
+        sum_stamped += c.sum;
+    }
+
+    cout << "Sequence numbers from one counter: " << plain_time << " ms, " << capacity * sizeof(int) << " bytes of elements\n";
+    cout << "Sequence numbers stored per element: " << stamped_time << " ms, " << capacity * sizeof(stamped_int)
+         << " bytes of elements\n";
+    for (int c = 0; c != consumers; ++c) {
+        cout << "Consumer reading every " << read_every[c] << " pushes lost " << lost_plain[c] << " (stamps: "
+             << stamped_consumers[c].lost << ")\n";
+    }
+    cout << "Sums: " << sum_plain << " " << sum_stamped << "\n";
+}
@@ -0,0 +1,91 @@
+// Pairs of functions doing the same work on bare values and on singletons. The singleton-codegen target
+// compiles this file to assembly and checks that both functions of each pair compile to the same instructions
+// (see compare_codegen.cmake). The functions are extern "C" so that their names in the assembly are the plain
+// names bellow. This file is not part of the program.
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+#include "singleton.hpp"
+
+extern "C" {
+
+int raw_accumulate_int(const int* a, std::size_t n)
+{
+    return std::accumulate(a, a + n, 0);
+}
+singleton<int> singleton_accumulate_int(const singleton<int>* a, std::size_t n)
+{
+    return std::accumulate(a, a + n, singleton<int>(0));
+}
+
+double raw_accumulate_double(const double* a, std::size_t n)
+{
+    return std::accumulate(a, a + n, 0.0);
+}
+singleton<double> singleton_accumulate_double(const singleton<double>* a, std::size_t n)
+{
+    return std::accumulate(a, a + n, singleton<double>(0.0));
+}
+
+void raw_add_int(int* a, const int* b, std::size_t n)
+{
+    for (std::size_t i = 0; i != n; ++i) {
+        a[i] += b[i];
+    }
+}
+void singleton_add_int(singleton<int>* a, const singleton<int>* b, std::size_t n)
+{
+    for (std::size_t i = 0; i != n; ++i) {
+        a[i] += b[i];
+    }
+}
+
+void raw_scale_double(double* a, double x, std::size_t n)
+{
+    for (std::size_t i = 0; i != n; ++i) {
+        a[i] = a[i] * x;
+    }
+}
+void singleton_scale_double(singleton<double>* a, double x, std::size_t n)
+{
+    for (std::size_t i = 0; i != n; ++i) {
+        a[i] = a[i] * x;
+    }
+}
+
+std::size_t raw_count_less_int(const int* a, const int* b, std::size_t n)
+{
+    std::size_t count = 0;
+    for (std::size_t i = 0; i != n; ++i) {
+        count += a[i] < b[i];
+    }
+    return count;
+}
+std::size_t singleton_count_less_int(const singleton<int>* a, const singleton<int>* b, std::size_t n)
+{
+    std::size_t count = 0;
+    for (std::size_t i = 0; i != n; ++i) {
+        count += a[i] < b[i];
+    }
+    return count;
+}
+
+const int* raw_max_element_int(const int* a, std::size_t n)
+{
+    return std::max_element(a, a + n);
+}
+const singleton<int>* singleton_max_element_int(const singleton<int>* a, std::size_t n)
+{
+    return std::max_element(a, a + n);
+}
+
+void raw_copy_int(int* out, const int* a, std::size_t n)
+{
+    std::copy(a, a + n, out);
+}
+void singleton_copy_int(singleton<int>* out, const singleton<int>* a, std::size_t n)
+{
+    std::copy(a, a + n, out);
+}
+
+}
@@ -0,0 +1,193 @@
+#include "snapshot.hpp"
+
+#include <cstring>
+
+#ifdef SNAPSHOT_HAS_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char snapshot_magic[8] = { 'G', 'P', 'S', 'N', 'A', 'P', '\r', '\n' };
+
+}
+
+const char* to_string(snapshot_status s)
+{
+    switch (s) {
+    case snapshot_status::ok:
+        return "ok";
+    case snapshot_status::io_error:
+        return "input/output error";
+    case snapshot_status::not_a_snapshot:
+        return "not a snapshot";
+    case snapshot_status::unsupported_version:
+        return "unsupported snapshot version";
+    case snapshot_status::wrong_byte_order:
+        return "snapshot from a machine with a different byte order";
+    case snapshot_status::type_mismatch:
+        return "snapshot of a different container or element type";
+    case snapshot_status::size_mismatch:
+        return "snapshot of a different size";
+    }
+    return "unknown snapshot status";
+}
+
+snapshot_header make_snapshot_header(snapshot_header::container_kind container,
+                                     snapshot_header::encoding_kind encoding,
+                                     std::size_t element_size, std::size_t size, std::size_t capacity)
+{
+    snapshot_header h {};
+    std::memcpy(h.magic, snapshot_magic, sizeof h.magic);
+    h.byte_order = snapshot_header::byte_order_mark;
+    h.version = snapshot_header::current_version;
+    h.container = container;
+    h.encoding = encoding;
+    h.element_size = element_size;
+    h.size = size;
+    h.capacity = capacity;
+    return h;
+}
+
+bool write_snapshot_header(std::ostream& out, const snapshot_header& h)
+{
+    out.write(reinterpret_cast<const char*>(&h), sizeof h);
+    return static_cast<bool>(out);
+}
+
+namespace {
+
+snapshot_status check_common(const snapshot_header& h)
+{
+    if (std::memcmp(h.magic, snapshot_magic, sizeof h.magic) != 0) {
+        return snapshot_status::not_a_snapshot;
+    }
+    if (h.byte_order != snapshot_header::byte_order_mark) {
+        return snapshot_status::wrong_byte_order;
+    }
+    if (h.version > snapshot_header::current_version) {
+        return snapshot_status::unsupported_version;
+    }
+    return snapshot_status::ok;
+}
+
+}
+
+snapshot_status read_snapshot_header(std::istream& in, snapshot_header& h)
+{
+    in.read(reinterpret_cast<char*>(&h), sizeof h);
+    if (in.gcount() != static_cast<std::streamsize>(sizeof h)) {
+        return snapshot_status::io_error;
+    }
+    return check_common(h);
+}
+
+snapshot_status check_snapshot_header(const snapshot_header& h, snapshot_header::container_kind container,
+                                      snapshot_header::encoding_kind encoding, std::size_t element_size)
+{
+    if (h.container != container || h.encoding != encoding || h.element_size != element_size) {
+        return snapshot_status::type_mismatch;
+    }
+    return snapshot_status::ok;
+}
+
+snapshot_status check_snapshot_sizes(std::istream& in, const snapshot_header& h, std::uint64_t max_capacity_bytes)
+{
+    // The element size was checked against sizeof(T) already, it is not zero.
+    if (h.size > h.capacity || h.capacity > max_capacity_bytes / h.element_size) {
+        return snapshot_status::io_error;
+    }
+    if (h.encoding != snapshot_header::raw_encoding) {
+        // We cannot tell how many bytes the elements take.
+        return snapshot_status::ok;
+    }
+    // Streams which cannot seek (a pipe) give -1, we just read and see.
+    std::istream::pos_type here = in.tellg();
+    if (here == std::istream::pos_type(-1)) {
+        return snapshot_status::ok;
+    }
+    in.seekg(0, std::ios::end);
+    std::istream::pos_type end = in.tellg();
+    in.seekg(here);
+    if (end == std::istream::pos_type(-1) || !in) {
+        return snapshot_status::io_error;
+    }
+    std::uint64_t left = static_cast<std::uint64_t>(end - here);
+    if (left / h.element_size < h.size) {
+        return snapshot_status::io_error;
+    }
+    return snapshot_status::ok;
+}
+
+bool snapshot_traits<std::string>::write(std::ostream& out, const std::string& x)
+{
+    std::uint64_t length = x.size();
+    out.write(reinterpret_cast<const char*>(&length), sizeof length);
+    out.write(x.data(), static_cast<std::streamsize>(x.size()));
+    return static_cast<bool>(out);
+}
+
+bool snapshot_traits<std::string>::read(std::istream& in, std::string& x)
+{
+    std::uint64_t length = 0;
+    in.read(reinterpret_cast<char*>(&length), sizeof length);
+    if (in.gcount() != static_cast<std::streamsize>(sizeof length)) {
+        return false;
+    }
+    // Read in pieces: a corrupt length must not make us allocate gigabytes before we notice the data is short.
+    x.clear();
+    char block[4096];
+    while (length != 0) {
+        std::streamsize n = length < sizeof block ? static_cast<std::streamsize>(length) : sizeof block;
+        in.read(block, n);
+        if (in.gcount() != n) {
+            return false;
+        }
+        x.append(block, static_cast<std::size_t>(n));
+        length -= static_cast<std::uint64_t>(n);
+    }
+    return true;
+}
+
+#ifdef SNAPSHOT_HAS_MMAP
+
+mapped_snapshot::mapped_snapshot(const char* path)
+    : data_(nullptr), length_(0), status_(snapshot_status::io_error)
+{
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+    struct stat info;
+    if (::fstat(fd, &info) == 0 && static_cast<std::size_t>(info.st_size) >= sizeof(snapshot_header)) {
+        void* p = ::mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            data_ = p;
+            length_ = static_cast<std::size_t>(info.st_size);
+        }
+    }
+    // The mapping stays valid after the file is closed.
+    ::close(fd);
+    if (data_ == nullptr) {
+        return;
+    }
+    status_ = check_common(header());
+    // A raw snapshot must have room for all of its elements (a corrupt one might claim anything).
+    if (status_ == snapshot_status::ok && header().encoding == snapshot_header::raw_encoding
+        && (header().element_size == 0
+            || (length_ - sizeof(snapshot_header)) / header().element_size < header().size)) {
+        status_ = snapshot_status::io_error;
+    }
+}
+
+mapped_snapshot::~mapped_snapshot()
+{
+    if (data_ != nullptr) {
+        ::munmap(data_, length_);
+    }
+}
+
+#endif
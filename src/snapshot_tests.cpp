@@ -0,0 +1,305 @@
+#include "snapshot_tests.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include "buffer.hpp"
+#include "circular_buffer.hpp"
+#include "snapshot.hpp"
+
+using std::cout;
+
+namespace {
+
+// A trivially copyable user type goes in as raw bytes without any extra code.
+struct sample {
+    int    id;
+    double value;
+};
+
+template<typename T>
+bool same_contents(const circular_buffer<T>& x, const circular_buffer<T>& y)
+{
+    if (x.size() != y.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i != x.size(); ++i) {
+        if (!(x[i] == y[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// A ring whose contents wrap around the end of the underlying array.
+circular_buffer<int> make_wrapped_ring(std::size_t capacity, std::size_t pushes)
+{
+    circular_buffer<int> cb(capacity);
+    for (std::size_t i = 0; i != pushes; ++i) {
+        cb.push_back(static_cast<int>(i * 7919 % 1000003) - 500000);
+    }
+    return cb;
+}
+
+std::filesystem::path temporary_file(const char* name)
+{
+    return std::filesystem::temp_directory_path() / name;
+}
+
+}
+
+bool test_snapshot_round_trip()
+{
+    bool result = true;
+
+    buffer<int, 100> b;
+    for (int i = 0; i != 100; ++i) {
+        b[i] = i * i - 50;
+    }
+    std::stringstream buffer_stream;
+    result = result && save_snapshot(buffer_stream, b) == snapshot_status::ok;
+    buffer<int, 100> b2;
+    result = result && load_snapshot(buffer_stream, b2) == snapshot_status::ok;
+    for (int i = 0; i != 100; ++i) {
+        result = result && b2[i] == b[i];
+    }
+
+    // The loaded ring has the same elements in the same order and the same capacity.
+    circular_buffer<int> ring = make_wrapped_ring(1000, 2500);
+    result = result && !ring.array_two().empty();
+    std::stringstream ring_stream;
+    result = result && save_snapshot(ring_stream, ring) == snapshot_status::ok;
+    circular_buffer<int> ring2(3);
+    result = result && load_snapshot(ring_stream, ring2) == snapshot_status::ok;
+    result = result && same_contents(ring, ring2) && ring2.capacity() == 1000;
+    // A ring keeps its memory options and its sequence numbers: the loaded elements come after the ones it had.
+    ring_memory_options options;
+    options.pages = page_kind::transparent_huge;
+    circular_buffer<int> mapped(10, options);
+    for (int i = 0; i != 25; ++i) {
+        mapped.push_back(i);
+    }
+    ring_stream.clear();
+    ring_stream.seekg(0);
+    result = result && load_snapshot(ring_stream, mapped) == snapshot_status::ok && same_contents(ring, mapped)
+        && mapped.memory_options().pages == page_kind::transparent_huge && mapped.memory().data == mapped.data()
+        && mapped.first_seq() == 25 && mapped.end_seq() == 25 + ring.size();
+    // And it keeps working as a ring.
+    ring.push_back(42);
+    ring2.push_back(42);
+    result = result && same_contents(ring, ring2);
+
+    circular_buffer<sample> samples(4);
+    for (int i = 0; i != 6; ++i) {
+        samples.push_back({ i, i / 3.0 });
+    }
+    std::stringstream samples_stream;
+    result = result && save_snapshot(samples_stream, samples) == snapshot_status::ok;
+    circular_buffer<sample> samples2;
+    result = result && load_snapshot(samples_stream, samples2) == snapshot_status::ok && samples2.size() == 4;
+    for (std::size_t i = 0; i != samples.size(); ++i) {
+        result = result && samples2[i].id == samples[i].id && samples2[i].value == samples[i].value;
+    }
+
+    // Strings go through their snapshot_traits.
+    circular_buffer<std::string> words(3);
+    for (const char* w : { "lorem", "", "ipsum dolor", "sit amet" }) {
+        words.push_back(w);
+    }
+    std::stringstream words_stream;
+    result = result && save_snapshot(words_stream, words) == snapshot_status::ok;
+    circular_buffer<std::string> words2;
+    result = result && load_snapshot(words_stream, words2) == snapshot_status::ok && same_contents(words, words2);
+
+    circular_buffer<double> empty(8);
+    std::stringstream empty_stream;
+    result = result && save_snapshot(empty_stream, empty) == snapshot_status::ok;
+    circular_buffer<double> empty2(1);
+    empty2.push_back(1.0);
+    result = result && load_snapshot(empty_stream, empty2) == snapshot_status::ok;
+    result = result && empty2.empty() && empty2.capacity() == 8;
+
+    return result;
+}
+
+bool test_snapshot_errors()
+{
+    bool result = true;
+    circular_buffer<int> ring = make_wrapped_ring(100, 150);
+    std::stringstream good;
+    save_snapshot(good, ring);
+    const std::string bytes = good.str();
+
+    auto load_from = [](const std::string& data, circular_buffer<int>& target) {
+        std::istringstream in(data);
+        return load_snapshot(in, target);
+    };
+
+    circular_buffer<int> target(5);
+    target.push_back(7);
+
+    std::string bad = bytes;
+    bad[0] = 'X';
+    result = result && load_from(bad, target) == snapshot_status::not_a_snapshot;
+
+    bad = bytes;
+    snapshot_header h;
+    std::memcpy(&h, bad.data(), sizeof h);
+    h.version = snapshot_header::current_version + 1;
+    std::memcpy(&bad[0], &h, sizeof h);
+    result = result && load_from(bad, target) == snapshot_status::unsupported_version;
+
+    h.version = snapshot_header::current_version;
+    h.byte_order = 0x04030201;
+    std::memcpy(&bad[0], &h, sizeof h);
+    result = result && load_from(bad, target) == snapshot_status::wrong_byte_order;
+
+    // Cut short in the middle of the elements.
+    result = result && load_from(bytes.substr(0, bytes.size() - 10), target) == snapshot_status::io_error;
+    result = result && load_from(bytes.substr(0, 20), target) == snapshot_status::io_error;
+
+    // Headers claiming more than there is, checked before allocating anything: more elements than the data
+    // holds, more elements than the capacity and a capacity of 64 GB.
+    std::memcpy(&h, bytes.data(), sizeof h);
+    h.size = h.capacity = std::uint64_t(1) << 33;
+    std::memcpy(&bad[0], &h, sizeof h);
+    result = result && load_from(bad, target) == snapshot_status::io_error;
+    std::memcpy(&h, bytes.data(), sizeof h);
+    h.size = h.capacity + 1;
+    std::memcpy(&bad[0], &h, sizeof h);
+    result = result && load_from(bad, target) == snapshot_status::io_error;
+    std::memcpy(&h, bytes.data(), sizeof h);
+    h.capacity = std::uint64_t(1) << 34;
+    std::memcpy(&bad[0], &h, sizeof h);
+    result = result && load_from(bad, target) == snapshot_status::io_error;
+    // Unless the caller allows rings that big: this one is only 4 MB.
+    h.capacity = std::uint64_t(1) << 20;
+    std::memcpy(&bad[0], &h, sizeof h);
+    std::istringstream allowed(bad);
+    circular_buffer<int> big;
+    result = result && load_snapshot(allowed, big, std::uint64_t(1) << 22) == snapshot_status::ok
+        && big.capacity() == h.capacity && same_contents(big, ring);
+    std::istringstream too_small_limit(bad);
+    result = result && load_snapshot(too_small_limit, big, (std::uint64_t(1) << 22) - 1) == snapshot_status::io_error;
+
+    // A failed load leaves the ring alone.
+    result = result && target.size() == 1 && target[0] == 7 && target.capacity() == 5;
+
+    // Different element type, different container, different buffer size.
+    std::istringstream as_doubles(bytes);
+    circular_buffer<double> doubles;
+    result = result && load_snapshot(as_doubles, doubles) == snapshot_status::type_mismatch;
+    std::istringstream as_buffer(bytes);
+    buffer<int, 100> b;
+    result = result && load_snapshot(as_buffer, b) == snapshot_status::type_mismatch;
+    std::stringstream small;
+    save_snapshot(small, buffer<int, 4> { 1 });
+    result = result && load_snapshot(small, b) == snapshot_status::size_mismatch;
+
+    result = result && std::string(to_string(snapshot_status::type_mismatch)) != to_string(snapshot_status::ok);
+    return result;
+}
+
+bool test_mapped_snapshot()
+{
+    bool result = true;
+#ifdef SNAPSHOT_HAS_MMAP
+    circular_buffer<int> ring = make_wrapped_ring(5000, 12345);
+    auto path = temporary_file("generic_programming_mapped_snapshot.bin");
+    {
+        std::ofstream out(path, std::ios::binary);
+        result = result && save_snapshot(out, ring) == snapshot_status::ok;
+    }
+    {
+        mapped_snapshot mapped(path.string().c_str());
+        result = result && mapped.status() == snapshot_status::ok;
+        array_segment<const int> elements = mapped.elements<int>();
+        result = result && elements.size() == ring.size();
+        for (std::size_t i = 0; i != elements.size(); ++i) {
+            result = result && elements[i] == ring[i];
+        }
+        // Wrong element type.
+        result = result && mapped.elements<double>().empty();
+    }
+    std::filesystem::remove(path);
+
+    mapped_snapshot missing("/this/file/does/not/exist");
+    result = result && missing.status() == snapshot_status::io_error && missing.elements<int>().empty();
+#endif
+    return result;
+}
+
+void test_snapshot_performance()
+{
+    using namespace std::chrono;
+
+    // 100M ints (400 MB), wrapped around.
+    const std::size_t n = 100000000;
+    circular_buffer<int> ring = make_wrapped_ring(n, n + n / 3);
+    auto text_path = temporary_file("generic_programming_ring.txt");
+    auto snapshot_path = temporary_file("generic_programming_ring.bin");
+
+    high_resolution_clock clock {};
+    auto seconds = [](high_resolution_clock::duration d) { return duration_cast<duration<double>>(d).count(); };
+
+    // What we do today: print the ring as text and push every element back in on startup.
+    auto t1 = clock.now();
+    {
+        std::ofstream out(text_path);
+        out << ring;
+    }
+    auto t2 = clock.now();
+    circular_buffer<int> from_text(n);
+    {
+        std::ifstream in(text_path);
+        int x;
+        char comma;
+        while (in >> x >> comma) {
+            from_text.push_back(x);
+        }
+    }
+    auto t3 = clock.now();
+
+    {
+        std::ofstream out(snapshot_path, std::ios::binary);
+        save_snapshot(out, ring);
+    }
+    auto t4 = clock.now();
+    circular_buffer<int> from_snapshot;
+    {
+        std::ifstream in(snapshot_path, std::ios::binary);
+        load_snapshot(in, from_snapshot);
+    }
+    auto t5 = clock.now();
+
+    cout << "Text: save " << seconds(t2 - t1) << " s, restore " << seconds(t3 - t2) << " s ("
+         << std::filesystem::file_size(text_path) / 1000000 << " MB)\n";
+    cout << "Snapshot: save " << seconds(t4 - t3) << " s, restore " << seconds(t5 - t4) << " s ("
+         << std::filesystem::file_size(snapshot_path) / 1000000 << " MB)\n";
+    cout << "Restored rings equal: " << same_contents(ring, from_text) << " " << same_contents(ring, from_snapshot)
+         << "\n";
+
+#ifdef SNAPSHOT_HAS_MMAP
+    // Mapping costs nothing up front, the pages are read in as we touch them: sum the elements to touch all.
+    auto t6 = clock.now();
+    long long sum = 0;
+    {
+        mapped_snapshot mapped(snapshot_path.string().c_str());
+        for (int x : mapped.elements<int>()) {
+            sum += x;
+        }
+    }
+    auto t7 = clock.now();
+    cout << "Mapped snapshot: map and read every element " << seconds(t7 - t6) << " s (sum " << sum << ")\n";
+#endif
+    cout << '\n';
+
+    std::filesystem::remove(text_path);
+    std::filesystem::remove(snapshot_path);
+}
@@ -0,0 +1,216 @@
+#include "sorting_networks_tests.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include "sorting_networks.hpp"
+
+namespace {
+
+// The 0-1 principle: a network which sorts every sequence of zeros and ones sorts every sequence.
+// So trying all 2^N of them proves the network correct.
+template<int N>
+bool sorts_all_zero_one_inputs()
+{
+    for (unsigned long bits = 0; bits != (1ul << N); ++bits) {
+        buffer<int, N> b;
+        for (int i = 0; i != N; ++i) {
+            b[i] = (bits >> i) & 1;
+        }
+        sort(b);
+        for (int i = 1; i < N; ++i) {
+            if (b[i - 1] > b[i]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+template<int... N>
+bool sorts_all_zero_one_inputs(std::integer_sequence<int, N...>)
+{
+    return (sorts_all_zero_one_inputs<N>() && ...);
+}
+
+template<typename T, int N>
+std::vector<T> to_vector(const buffer<T, N>& b)
+{
+    return std::vector<T>(b.data(), b.data() + N);
+}
+
+// Random inputs with many repeated values, against std::sort.
+template<int N>
+bool sorts_like_std_sort(std::mt19937& random)
+{
+    std::uniform_int_distribution<int> values(-20, 20);
+    for (int k = 0; k != 200; ++k) {
+        buffer<int, N> b;
+        for (int i = 0; i != N; ++i) {
+            b[i] = values(random);
+        }
+        std::vector<int> expected = to_vector(b);
+        std::sort(expected.begin(), expected.end());
+        sort(b);
+        if (to_vector(b) != expected) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template<int... N>
+bool sorts_like_std_sort(std::mt19937& random, std::integer_sequence<int, N...>)
+{
+    return (sorts_like_std_sort<N>(random) && ...);
+}
+
+// partial_sort<K> and nth_element<K> on random inputs, for every K.
+template<int N, int K>
+bool partial_sort_and_nth_element_work(std::mt19937& random)
+{
+    std::uniform_int_distribution<int> values(0, 9);
+    for (int k = 0; k != 100; ++k) {
+        buffer<int, N> b;
+        for (int i = 0; i != N; ++i) {
+            b[i] = values(random);
+        }
+        std::vector<int> sorted = to_vector(b);
+        std::sort(sorted.begin(), sorted.end());
+
+        buffer<int, N> p = b;
+        partial_sort<K>(p);
+        std::vector<int> rest(p.data() + K, p.data() + N);
+        std::sort(rest.begin(), rest.end());
+        if (!std::equal(p.data(), p.data() + K, sorted.begin())
+            || !std::equal(rest.begin(), rest.end(), sorted.begin() + K)) {
+            return false;
+        }
+
+        if constexpr (K < N) {
+            buffer<int, N> e = b;
+            nth_element<K>(e);
+            if (e[K] != sorted[K]) {
+                return false;
+            }
+            for (int i = 0; i != N; ++i) {
+                if ((i < K && e[i] > e[K]) || (i > K && e[i] < e[K])) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+template<int N, int... K>
+bool partial_sort_and_nth_element_work(std::mt19937& random, std::integer_sequence<int, K...>)
+{
+    return (partial_sort_and_nth_element_work<N, K>(random) && ...);
+}
+
+// Many small buffers, sorted one after the other: std::sort against the networks.
+template<int N>
+void time_sorts(std::mt19937& random)
+{
+    using namespace std::chrono;
+    const int count = (1 << 22) / N;
+    std::vector<buffer<int, N>> original(count);
+    std::uniform_int_distribution<int> values(0, 1000000);
+    for (auto& b : original) {
+        for (int i = 0; i != N; ++i) {
+            b[i] = values(random);
+        }
+    }
+
+    high_resolution_clock clock {};
+    std::vector<buffer<int, N>> data = original;
+    auto t1 = clock.now();
+    for (auto& b : data) {
+        std::sort(b.data(), b.data() + N);
+    }
+    auto t2 = clock.now();
+    data = original;
+    auto t3 = clock.now();
+    for (auto& b : data) {
+        sort(b);
+    }
+    auto t4 = clock.now();
+
+    auto nanoseconds_per_sort = [&](high_resolution_clock::duration d) {
+        return duration_cast<duration<double, std::nano>>(d).count() / count;
+    };
+    std::cout << "N = " << N << ": std::sort " << nanoseconds_per_sort(t2 - t1) << " ns, sort "
+              << nanoseconds_per_sort(t4 - t3) << " ns\n";
+}
+
+template<int... N>
+void time_sorts(std::mt19937& random, std::integer_sequence<int, N...>)
+{
+    (time_sorts<N + 2>(random), ...);
+}
+
+}
+
+bool test_sorting_networks()
+{
+    bool result = true;
+    std::mt19937 random(2017);
+
+    result = result && sorts_all_zero_one_inputs(std::make_integer_sequence<int, 17>{});
+    result = result && sorts_like_std_sort(random, std::make_integer_sequence<int, 33>{});
+    // Bigger buffers take the std::sort path.
+    result = result && sorts_like_std_sort<40>(random) && sorts_like_std_sort<100>(random);
+
+    // Any comparator with the contract of compare: here the reverse order.
+    buffer<double, 7> d;
+    for (int i = 0; i != 7; ++i) {
+        d[i] = (i * 3) % 7 - 0.5;
+    }
+    sort(d, [](double x, double y) { return compare(y, x); });
+    for (int i = 1; i != 7; ++i) {
+        result = result && d[i - 1] >= d[i];
+    }
+
+    // Types which are not trivially copyable are swapped instead of selected.
+    buffer<std::string, 5> words;
+    const char* w[] = { "pear", "apple", "fig", "banana", "apple" };
+    for (int i = 0; i != 5; ++i) {
+        words[i] = w[i];
+    }
+    sort(words);
+    result = result && words[0] == "apple" && words[1] == "apple" && words[2] == "banana" && words[3] == "fig"
+        && words[4] == "pear";
+
+    // The networks are really computed when compiling.
+    static_assert(sorting_network<8>::value.size == 19, "Batcher's network for 8 elements has 19 comparators");
+    static_assert(pruned_sorting_network<32, 0, 1>::value.size == 31, "finding the minimum takes n - 1 steps");
+
+    return result;
+}
+
+bool test_partial_sort_and_nth_element()
+{
+    bool result = true;
+    std::mt19937 random(42);
+    result = result && partial_sort_and_nth_element_work<1>(random, std::make_integer_sequence<int, 2>{});
+    result = result && partial_sort_and_nth_element_work<7>(random, std::make_integer_sequence<int, 8>{});
+    result = result && partial_sort_and_nth_element_work<16>(random, std::make_integer_sequence<int, 17>{});
+    result = result && partial_sort_and_nth_element_work<32>(random, std::integer_sequence<int, 0, 1, 5, 16, 31, 32>{});
+    result = result && partial_sort_and_nth_element_work<50>(random, std::integer_sequence<int, 0, 10, 49>{});
+    return result;
+}
+
+void test_sorting_networks_performance()
+{
+    std::mt19937 random(7);
+    // N = 2 ... 32 with the networks, then two sizes where sort uses std::sort as well.
+    time_sorts(random, std::make_integer_sequence<int, 31>{});
+    time_sorts<48>(random);
+    time_sorts<64>(random);
+    std::cout << '\n';
+}
@@ -0,0 +1,77 @@
+#include "text_writer.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <locale>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+text_writer::text_writer(std::ostream& out)
+    : out_(&out), fd_(-1), precision_(static_cast<int>(out.precision())), failed_(false), size_(0)
+{}
+
+text_writer::text_writer(int fd)
+    : out_(nullptr), fd_(fd), precision_(6), failed_(false), size_(0)
+{}
+
+text_writer::~text_writer()
+{
+    flush();
+}
+
+bool text_writer::compatible(const std::ostream& out)
+{
+    // Everything that changes how a number looks. adjustfield only matters together with a width.
+    const std::ios_base::fmtflags looks = std::ios_base::basefield | std::ios_base::floatfield
+        | std::ios_base::showbase | std::ios_base::showpoint | std::ios_base::showpos
+        | std::ios_base::uppercase | std::ios_base::boolalpha;
+    // The classic locale has no thousands separators and '.' as the decimal point, like to_chars.
+    return (out.flags() & looks) == std::ios_base::dec && out.width() == 0
+        && out.precision() >= 0 && out.precision() <= max_precision
+        && out.getloc() == std::locale::classic();
+}
+
+void text_writer::write(const char* s, std::size_t n)
+{
+    while (n != 0) {
+        make_room(1);
+        std::size_t k = capacity - size_ < n ? capacity - size_ : n;
+        std::memcpy(data_ + size_, s, k);
+        size_ += k;
+        s += k;
+        n -= k;
+    }
+}
+
+void text_writer::flush()
+{
+    if (size_ == 0) {
+        return;
+    }
+    if (out_ != nullptr) {
+        out_->write(data_, static_cast<std::streamsize>(size_));
+        size_ = 0;
+        return;
+    }
+    // write may write less than we asked for (a pipe or a socket which is full) or be interrupted by a signal.
+    const char* p = data_;
+    std::size_t left = size_;
+    while (left != 0 && !failed_) {
+#ifdef _WIN32
+        int written = _write(fd_, p, static_cast<unsigned int>(left));
+#else
+        auto written = ::write(fd_, p, left);
+#endif
+        if (written < 0) {
+            failed_ = errno != EINTR;
+            continue;
+        }
+        p += written;
+        left -= static_cast<std::size_t>(written);
+    }
+    size_ = 0;
+}
@@ -0,0 +1,230 @@
+#include "text_writer_tests.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include "buffer.hpp"
+#include "circular_buffer.hpp"
+#include "heap_buffer.hpp"
+#include "text_writer.hpp"
+
+using std::cout;
+
+namespace {
+
+// What operator<< printed before text_writer: one element at a time through the stream.
+template<typename C>
+std::string reference_output(const C& c, const char* separator, std::ios_base::fmtflags flags = std::ios_base::dec,
+                             std::streamsize precision = 6)
+{
+    std::ostringstream out;
+    out.flags(flags);
+    out.precision(precision);
+    for (std::size_t i = 0; i != static_cast<std::size_t>(c.size()); ++i) {
+        out << c[i] << separator;
+    }
+    out << '\n';
+    return out.str();
+}
+
+template<typename T>
+bool same_as_stream(T x, std::streamsize precision = 6)
+{
+    std::ostringstream expected;
+    expected.precision(precision);
+    expected << x;
+    std::ostringstream actual;
+    actual.precision(precision);
+    {
+        text_writer writer(actual);
+        writer.put_number(x);
+    }
+    return expected.str() == actual.str();
+}
+
+template<typename T>
+bool same_as_stream_for_limits()
+{
+    using limits = std::numeric_limits<T>;
+    return same_as_stream(limits::min()) && same_as_stream(limits::max()) && same_as_stream(limits::lowest())
+        && same_as_stream(T {}) && same_as_stream(static_cast<T>(1)) && same_as_stream(static_cast<T>(100));
+}
+
+// Throws everything away, counting the characters. Lets us time the formatting without the cost of storing it.
+class counting_streambuf : public std::streambuf {
+public:
+    std::size_t count = 0;
+protected:
+    int_type overflow(int_type c) override
+    {
+        ++count;
+        return traits_type::not_eof(c);
+    }
+    std::streamsize xsputn(const char*, std::streamsize n) override
+    {
+        count += static_cast<std::size_t>(n);
+        return n;
+    }
+};
+
+}
+
+bool test_text_writer_numbers()
+{
+    bool result = true;
+    result = result && same_as_stream_for_limits<int>() && same_as_stream_for_limits<unsigned>();
+    result = result && same_as_stream_for_limits<short>() && same_as_stream_for_limits<long long>();
+    result = result && same_as_stream_for_limits<unsigned long long>() && same_as_stream_for_limits<std::int8_t>();
+    result = result && same_as_stream_for_limits<float>() && same_as_stream_for_limits<double>();
+    result = result && same_as_stream_for_limits<long double>();
+    // char types are characters, bool is 0 or 1.
+    result = result && same_as_stream('x') && same_as_stream(static_cast<unsigned char>('y'));
+    result = result && same_as_stream(true) && same_as_stream(false);
+
+    // Floating point numbers in all the shapes %g gives them.
+    for (double x : { 0.1, -2.5, 1.0 / 3.0, 123456.0, 1234567.0, 1e-5, 1e-4, 1e21, 6.02214076e23, -0.0, 0.5e-310 }) {
+        result = result && same_as_stream(x) && same_as_stream(static_cast<float>(x));
+        for (std::streamsize precision : { 0, 1, 3, 10, 17, 40 }) {
+            result = result && same_as_stream(x, precision);
+        }
+    }
+    result = result && same_as_stream(std::numeric_limits<double>::infinity());
+    result = result && same_as_stream(-std::numeric_limits<float>::infinity());
+    result = result && same_as_stream(std::numeric_limits<double>::quiet_NaN());
+    result = result && same_as_stream(-std::numeric_limits<double>::quiet_NaN());
+
+    // Which streams we can write to directly.
+    std::ostringstream out;
+    result = result && text_writer::compatible(out);
+    out << std::hex;
+    result = result && !text_writer::compatible(out);
+    out << std::dec << std::fixed;
+    result = result && !text_writer::compatible(out);
+    out << std::defaultfloat << std::setw(5);
+    result = result && !text_writer::compatible(out);
+    out.width(0);
+    out << std::showpos;
+    result = result && !text_writer::compatible(out);
+    out << std::noshowpos << std::setprecision(12);
+    result = result && text_writer::compatible(out);
+
+    return result;
+}
+
+bool test_text_writer_containers()
+{
+    bool result = true;
+
+    buffer<double, 5> b;
+    for (int i = 0; i != 5; ++i) {
+        b[i] = i / 7.0 - 0.25;
+    }
+    std::ostringstream out;
+    out << b;
+    result = result && out.str() == reference_output(b, " ");
+
+    // A stream text_writer cannot imitate takes the old path, with the same results as before.
+    std::ostringstream hex_out;
+    buffer<int, 4> small { 255 };
+    hex_out << std::hex << small;
+    result = result && hex_out.str() == reference_output(small, " ", std::ios_base::hex);
+
+    std::ostringstream precise;
+    precise << std::setprecision(15) << b;
+    result = result && precise.str() == reference_output(b, " ", std::ios_base::dec, 15);
+
+    heap_buffer<int, 4> hb(1000, -7);
+    std::ostringstream heap_out;
+    heap_out << hb;
+    result = result && heap_out.str() == reference_output(hb, " ");
+
+    // A ring which wraps around, bigger than the writer's block.
+    circular_buffer<int> ring(10000);
+    for (int i = 0; i != 25000; ++i) {
+        ring.push_back(i * 7919 - 100000000);
+    }
+    std::ostringstream ring_out;
+    ring_out << ring;
+    result = result && ring_out.str() == reference_output(ring, ", ");
+
+    circular_buffer<unsigned char> letters(3);
+    for (char c : { 'a', 'b', 'c', 'd' }) {
+        letters.push_back(static_cast<unsigned char>(c));
+    }
+    std::ostringstream letters_out;
+    letters_out << letters;
+    result = result && letters_out.str() == "b, c, d, \n";
+
+    std::ostringstream empty_out;
+    empty_out << circular_buffer<float>(4);
+    result = result && empty_out.str() == "\n";
+
+    // Straight to a file descriptor.
+    std::FILE* file = std::tmpfile();
+    if (file != nullptr) {
+        {
+            text_writer writer(fileno(file));
+            write_text(writer, ring);
+            result = result && !writer.failed();
+        }
+        std::rewind(file);
+        std::string contents;
+        char block[4096];
+        for (std::size_t n = std::fread(block, 1, sizeof block, file); n != 0;
+             n = std::fread(block, 1, sizeof block, file)) {
+            contents.append(block, n);
+        }
+        std::fclose(file);
+        result = result && contents == reference_output(ring, ", ");
+    }
+
+    return result;
+}
+
+void test_text_output_performance()
+{
+    using namespace std::chrono;
+
+    // The size of ring our debug endpoints dump.
+    const std::size_t n = 10000000;
+    circular_buffer<int> ints(n);
+    circular_buffer<double> doubles(n);
+    for (std::size_t i = 0; i != n + n / 3; ++i) {
+        ints.push_back(static_cast<int>(i * 7919 % 2000001) - 1000000);
+        doubles.push_back(static_cast<double>(i % 100003) / 7.0);
+    }
+
+    high_resolution_clock clock {};
+    auto megabytes_per_second = [](std::size_t bytes, high_resolution_clock::duration d) {
+        return bytes / duration_cast<duration<double>>(d).count() / 1e6;
+    };
+
+    auto run = [&](const char* name, const auto& ring) {
+        counting_streambuf old_buf;
+        std::ostream old_out(&old_buf);
+        auto t1 = clock.now();
+        for (std::size_t i = 0; i != ring.size(); ++i) {
+            old_out << ring[i] << ", ";
+        }
+        old_out << '\n';
+        auto t2 = clock.now();
+        counting_streambuf new_buf;
+        std::ostream new_out(&new_buf);
+        new_out << ring;
+        auto t3 = clock.now();
+        cout << name << ": element by element " << megabytes_per_second(old_buf.count, t2 - t1) << " MB/s ("
+             << duration_cast<milliseconds>(t2 - t1).count() << " ms), text_writer "
+             << megabytes_per_second(new_buf.count, t3 - t2) << " MB/s ("
+             << duration_cast<milliseconds>(t3 - t2).count() << " ms)\n";
+    };
+    run("circular_buffer<int>, 10M elements", ints);
+    run("circular_buffer<double>, 10M elements", doubles);
+    cout << '\n';
+}
@@ -0,0 +1,117 @@
+#include "thread_pool.hpp"
+
+#include <utility>
+
+namespace {
+
+// Which pool (if any) the current thread works for, and its index in that pool.
+thread_local const thread_pool* current_pool = nullptr;
+thread_local std::size_t current_index = 0;
+
+}
+
+thread_pool::thread_pool(std::size_t thread_count)
+    : next_queue_(0), pending_(0), stopping_(false)
+{
+    if (thread_count == 0) {
+        thread_count = std::thread::hardware_concurrency();
+    }
+    // hardware_concurrency is allowed to return 0 if it cannot tell.
+    if (thread_count == 0) {
+        thread_count = 1;
+    }
+    // All queues must exist before the first worker starts looking for work to steal.
+    for (std::size_t i = 0; i != thread_count; ++i) {
+        queues_.push_back(std::make_unique<worker_queue>());
+    }
+    workers_.reserve(thread_count);
+    for (std::size_t i = 0; i != thread_count; ++i) {
+        workers_.emplace_back([this, i]() { worker_loop(i); });
+    }
+}
+
+thread_pool::~thread_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        stopping_ = true;
+    }
+    task_available_.notify_all();
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+}
+
+bool thread_pool::in_worker_thread() const
+{
+    return current_pool == this;
+}
+
+void thread_pool::submit(std::function<void()> task)
+{
+    std::size_t target = in_worker_thread() ? current_index : next_queue_++ % queues_.size();
+    {
+        std::lock_guard<std::mutex> lock(queues_[target]->mutex);
+        queues_[target]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        ++pending_;
+    }
+    task_available_.notify_one();
+}
+
+bool thread_pool::pop_task(std::size_t self, std::function<void()>& task)
+{
+    const std::size_t n = queues_.size();
+    for (std::size_t k = 0; k != n; ++k) {
+        std::size_t victim = (self + k) % n;
+        worker_queue& q = *queues_[victim];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (q.tasks.empty()) {
+            continue;
+        }
+        if (k == 0) {
+            task = std::move(q.tasks.back());
+            q.tasks.pop_back();
+        }
+        else {
+            task = std::move(q.tasks.front());
+            q.tasks.pop_front();
+        }
+        std::lock_guard<std::mutex> sleep_lock(sleep_mutex_);
+        --pending_;
+        return true;
+    }
+    return false;
+}
+
+bool thread_pool::run_pending_task()
+{
+    std::function<void()> task;
+    std::size_t self = in_worker_thread() ? current_index : 0;
+    if (!pop_task(self, task)) {
+        return false;
+    }
+    task();
+    return true;
+}
+
+void thread_pool::worker_loop(std::size_t index)
+{
+    current_pool = this;
+    current_index = index;
+    for (;;) {
+        std::function<void()> task;
+        if (pop_task(index, task)) {
+            task();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        task_available_.wait(lock, [this]() { return stopping_ || pending_ != 0; });
+        // We only stop once all of the queued work is done.
+        if (stopping_ && pending_ == 0) {
+            return;
+        }
+    }
+}
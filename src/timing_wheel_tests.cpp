@@ -0,0 +1,223 @@
+#include "timing_wheel_tests.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <queue>
+#include <random>
+#include <vector>
+#include "timing_wheel.hpp"
+
+using std::cout;
+
+namespace {
+
+// What a timer is attached to.
+struct connection : timer_node {
+    int id = 0;
+    std::uint64_t expected = 0;
+    std::uint64_t expired_at = 0;
+    int expirations = 0;
+};
+
+// Records when each timer expired.
+template<typename Wheel>
+struct recorder {
+    Wheel& wheel;
+
+    void operator()(timer_list& batch)
+    {
+        while (timer_node* t = batch.pop_front()) {
+            connection& c = static_cast<connection&>(*t);
+            c.expired_at = wheel.now();
+            ++c.expirations;
+        }
+    }
+};
+
+// What we compare against: a binary heap of deadlines. It cannot cancel, so restarting a timeout pushes a new
+// entry and the stale ones are recognized by their generation when they come out.
+struct heap_entry {
+    std::uint64_t deadline;
+    std::uint32_t id;
+    std::uint32_t generation;
+
+    friend bool operator<(const heap_entry& x, const heap_entry& y)
+    {
+        return x.deadline > y.deadline;
+    }
+};
+
+}
+
+bool test_timing_wheel()
+{
+    bool result = true;
+    timing_wheel<> wheel;
+    connection c[6];
+    wheel.schedule(c[0], 1);
+    wheel.schedule(c[1], 255);
+    wheel.schedule(c[2], 256);
+    wheel.schedule(c[3], 70'000);
+    wheel.schedule(c[4], std::uint64_t(1) << 40); // past the top level
+    wheel.schedule(c[5], 0);                      // the next tick
+    result = result && wheel.size() == 6 && c[3].scheduled();
+
+    recorder<timing_wheel<>> record { wheel };
+    result = result && wheel.advance(1, record) == 2 && c[0].expired_at == 1 && c[5].expired_at == 1;
+    result = result && !c[0].scheduled() && wheel.size() == 4;
+
+    // Restarting a timeout moves it.
+    wheel.schedule(c[1], 1000);
+    result = result && wheel.size() == 4 && wheel.advance(300, record) == 1 && c[2].expired_at == 256;
+    result = result && c[1].expirations == 0;
+
+    result = result && wheel.cancel(c[3]) && !wheel.cancel(c[3]) && wheel.size() == 2;
+    result = result && wheel.advance(100'000, record) == 1 && c[1].expired_at == 1001 && c[3].expirations == 0;
+
+    // The batch may reschedule its timers: a periodic timer.
+    connection periodic;
+    int fired = 0;
+    wheel.schedule(periodic, 10);
+    auto every_10 = [&](timer_list& batch) {
+        while (timer_node* t = batch.pop_front()) {
+            if (t == &periodic) {
+                ++fired;
+                wheel.schedule(periodic, 10);
+            }
+            else {
+                static_cast<connection*>(t)->expired_at = wheel.now();
+            }
+        }
+    };
+    wheel.advance(1000, every_10);
+    result = result && fired == 100 && wheel.size() == 2;
+    wheel.cancel(periodic);
+
+    // The far away timer comes through the overflow list.
+    std::uint64_t left = (std::uint64_t(1) << 40) - wheel.now();
+    result = result && wheel.advance(left - 1, record) == 0 && wheel.advance(1, record) == 1;
+    result = result && c[4].expired_at == std::uint64_t(1) << 40 && wheel.empty();
+    return result;
+}
+
+bool test_timing_wheel_random()
+{
+    // A tiny wheel (4 slots, 3 levels: 64 ticks before the overflow list) so that every timer cascades.
+    timing_wheel<2, 3> wheel(1000);
+    recorder<timing_wheel<2, 3>> record { wheel };
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<std::uint64_t> delay(0, 300);
+    std::uniform_int_distribution<int> action(0, 9);
+    std::vector<connection> timers(2000);
+    for (std::size_t i = 0; i != timers.size(); ++i) {
+        timers[i].id = static_cast<int>(i);
+    }
+
+    bool result = true;
+    for (int round = 0; round != 2000; ++round) {
+        connection& c = timers[gen() % timers.size()];
+        int a = action(gen);
+        if (a < 6) {
+            std::uint64_t d = delay(gen);
+            wheel.schedule(c, d);
+            c.expected = wheel.now() + (d == 0 ? 1 : d);
+            c.expirations = 0;
+        }
+        else if (a < 8) {
+            // A cancelled timer must not expire (if it did, it would be at the wrong time).
+            wheel.cancel(c);
+            c.expected = 0;
+            c.expirations = 0;
+        }
+        else {
+            wheel.advance(gen() % 50, record);
+            // Everything due has expired, exactly on time and once; nothing else has.
+            for (const connection& x : timers) {
+                result = result && x.expirations <= 1 && (x.expirations == 0 || x.expired_at == x.expected);
+                result = result && !(x.scheduled() && x.expected <= wheel.now());
+            }
+        }
+    }
+    wheel.advance(1000, record);
+    std::size_t scheduled = 0;
+    for (const connection& x : timers) {
+        scheduled += x.scheduled();
+        result = result && x.expirations <= 1;
+        if (x.expirations != 0) {
+            result = result && x.expired_at == x.expected;
+        }
+    }
+    return result && scheduled == 0 && wheel.empty();
+}
+
+void test_timing_wheel_performance()
+{
+    using namespace std::chrono;
+    high_resolution_clock clock {};
+    // Timeouts of up to a minute in milliseconds. Every timer is restarted once, as a connection that received
+    // a packet would, then all of them run out.
+    const std::uint64_t max_delay = 60'000;
+
+    for (std::size_t n : { std::size_t(10'000), std::size_t(1'000'000), std::size_t(10'000'000) }) {
+        std::mt19937_64 gen(n);
+        std::vector<std::uint64_t> delays(2 * n);
+        for (std::uint64_t& d : delays) {
+            d = 1 + gen() % max_delay;
+        }
+
+        std::uint64_t wheel_checksum = 0;
+        auto wheel_time = high_resolution_clock::duration {};
+        {
+            auto wheel = std::make_unique<timing_wheel<>>();
+            std::vector<connection> timers(n);
+            auto start = clock.now();
+            for (std::size_t i = 0; i != n; ++i) {
+                wheel->schedule(timers[i], delays[i]);
+            }
+            for (std::size_t i = 0; i != n; ++i) {
+                wheel->schedule(timers[i], delays[n + i]);
+            }
+            while (!wheel->empty()) {
+                wheel->advance(1000, [&](timer_list& batch) {
+                    while (timer_node* t = batch.pop_front()) {
+                        wheel_checksum += t->deadline;
+                    }
+                });
+            }
+            wheel_time = clock.now() - start;
+        }
+
+        std::uint64_t heap_checksum = 0;
+        auto heap_time = high_resolution_clock::duration {};
+        {
+            std::priority_queue<heap_entry> heap;
+            std::vector<std::uint32_t> generation(n, 0);
+            std::uint64_t now = 0;
+            auto start = clock.now();
+            for (std::size_t i = 0; i != n; ++i) {
+                heap.push({ now + delays[i], static_cast<std::uint32_t>(i), 0 });
+            }
+            for (std::size_t i = 0; i != n; ++i) {
+                heap.push({ now + delays[n + i], static_cast<std::uint32_t>(i), ++generation[i] });
+            }
+            while (!heap.empty()) {
+                now = heap.top().deadline;
+                heap_entry e = heap.top();
+                heap.pop();
+                if (e.generation == generation[e.id]) {
+                    heap_checksum += e.deadline;
+                }
+            }
+            heap_time = clock.now() - start;
+        }
+
+        auto per_timer = [&](high_resolution_clock::duration d) {
+            return duration_cast<duration<double, std::nano>>(d).count() / n;
+        };
+        cout << n << " timers: timing_wheel " << per_timer(wheel_time) << " ns per timer, priority_queue "
+             << per_timer(heap_time) << " ns per timer" << (wheel_checksum == heap_checksum ? "" : " WRONG RESULT")
+             << "\n";
+    }
+}